@@ -0,0 +1,50 @@
+#include "inc/cfg.h"
+#include "inc/decode.h"
+#include "inc/platform.h"
+#include "inc/rom.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// writes the control-flow graph of a ROM as DOT or JSON, with a summary on stderr
+int main(int argc, char **argv) {
+    if ((argc != 3 && argc != 4) || (strcmp(argv[2], "dot") != 0 && strcmp(argv[2], "json") != 0)) {
+        printf("[Error] usage: ./chip8-cfg <rom file> <dot|json> [profile]\n");
+        return -1;
+    }
+    struct Rom rom;
+    enum RomError error = romOpen(&rom, argv[1]);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", argv[1], romError(error));
+        return -1;
+    }
+    int profile = defaultProfile(detectPlatform(rom.data, rom.size));
+    if (argc == 4 && (profile = profileFromName(argv[3])) == -1) {
+        printf("[Error] unknown profile %s\n", argv[3]);
+        romClose(&rom);
+        return -1;
+    }
+    decodeInit();
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct Cfg cfg;
+    cfgBuild(&cfg, rom.data, rom.size, profileIsa(profile));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    if (argv[2][0] == 'd') {
+        cfgWriteDot(&cfg, stdout);
+    } else {
+        cfgWriteJson(&cfg, stdout);
+    }
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    fprintf(stderr, "%s: %s profile, %d blocks, %d subroutines, %d BNNN, %d stores, %.2f ms\n", argv[1],
+            profileName(profile), cfg.block_count, cfg.sub_count, cfg.indirect_count, cfg.write_count, ms);
+    for (int i = 0; i < ISSUES; i++) {
+        int count = cfgCountIssues(&cfg, i);
+        if (count > 0) {
+            fprintf(stderr, "    %d %s\n", count, cfgIssueName(i));
+        }
+    }
+    cfgFree(&cfg);
+    romClose(&rom);
+    return 0;
+}
@@ -0,0 +1,96 @@
+#include "inc/aot.h"
+#include <string.h>
+
+// the translations the Makefile generated, one AOT_ROM(symbol) line each
+#define AOT_ROM(name) extern const struct AotRom name;
+#include "aot/roms.h"
+#undef AOT_ROM
+
+static const struct AotRom *translations[] = {
+#define AOT_ROM(name) &name,
+#include "aot/roms.h"
+#undef AOT_ROM
+    0x00,
+};
+
+/**
+ * @brief aotFind(hash, profile) is used to look up the translation of a ROM,
+ * chLoad() and chSetProfile() keep chip8->aot set to it
+ * @param hash FNV-1a hash of the ROM, as in chip8->rom_hash
+ * @param profile enum Profile the ROM runs with
+ * @return the translation, or 0x00 if the ROM has to be interpreted
+ */
+const struct AotRom *aotFind(unsigned long long hash, enum Profile profile) {
+#if defined(CHIP8_PROFILE) || defined(CHIP8_CHECKED) || defined(CHIP8_TRACE)
+    (void)hash;
+    (void)profile;
+    (void)translations;
+    return 0x00;
+#else
+    for (int i = 0; translations[i] != 0x00; i++) {
+        if (translations[i]->hash == hash && translations[i]->profile == profile) {
+            return translations[i];
+        }
+    }
+    return 0x00;
+#endif
+}
+
+/**
+ * @brief aotTranslation(index) is used to list the translations linked in,
+ * for tools that check them against the interpreter
+ * @param index 0 for the first
+ * @return the translation, or 0x00 past the last one and in builds that always interpret
+ */
+const struct AotRom *aotTranslation(int index) {
+    for (int i = 0; i <= index; i++) {
+        if (translations[i] == 0x00) {
+            return 0x00;
+        }
+    }
+    return aotFind(translations[index]->hash, translations[index]->profile);
+}
+
+/**
+ * @brief aotCurrent(aot, memory) is used to check that the translated code
+ * in memory is still what was translated, a store or a loaded state may
+ * have changed it
+ * @param aot the translation
+ * @param memory chip8's memory
+ * @return true if every translated byte matches the ROM
+ */
+bool aotCurrent(const struct AotRom *aot, struct Memory *memory) {
+    for (int i = 0; i < aot->run_count; i++) {
+        const struct AotRun *run = &aot->runs[i];
+        if (memcmp(&memory->memory[run->start], &aot->image[run->start - ROM_START], run->len) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief aotFrame(chip8) is used in place of the interpreter's frame function
+ * while chip8->aot is set: translated blocks run as long as the frame has
+ * cycles for them, everything else is stepped by the interpreter
+ * @param chip8 chip8's state
+ * @return void
+ */
+void aotFrame(struct Chip8 *chip8) {
+    const struct AotRom *aot = chip8->aot;
+    bool stale = !aotCurrent(aot, &chip8->memory);
+    int left = CYCLES_PER_FRAME;
+    while (left > 0) {
+        if (!stale && (left = aot->run(chip8, left, &stale)) == 0) {
+            break;
+        }
+        // PC has no block, the block needs more cycles than are left, or the code was stored to
+        enum Op op = decodeOp(aot->isa, mergeBytes(&chip8->memory, chip8->registers.PC));
+        chStep(chip8);
+        left--;
+        if (!stale && (op == OP_LD_BCD || op == OP_LD_MEM || op == OP_SAVE)) {
+            stale = !aotCurrent(aot, &chip8->memory);
+        }
+    }
+    chTick(chip8);
+}
@@ -0,0 +1,1041 @@
+#include "inc/asm.h"
+#include "inc/decode.h"
+#include "inc/hash.h"
+#include "inc/rom.h"
+#include <ctype.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define ASM_LINE_MAX 512
+#define ASM_OPERANDS 16
+#define ASM_NAME_MAX 64
+
+// an instruction's mnemonic and operands, split out of its opTable format
+struct Template {
+    char mnemonic[8];
+    char operands[3][12];
+    int count;
+};
+
+static struct Template templates[OPS];
+
+// Paul Robson's mnemonics, * in operands stands for the ones written
+struct Alias {
+    const char *name;
+    const char *mnemonic;
+    const char *operands;
+};
+
+static const struct Alias aliases[] = {
+    {"JMP", "JP", "*"},        {"JSR", "CALL", "*"},     {"RTS", "RET", ""},        {"SKEQ", "SE", "*"},
+    {"SKNE", "SNE", "*"},      {"MOV", "LD", "*"},       {"RSB", "SUBN", "*"},      {"SPRITE", "DRW", "*"},
+    {"SKPR", "SKP", "*"},      {"SKUP", "SKNP", "*"},    {"RANDOM", "RND", "*"},    {"RAND", "RND", "*"},
+    {"HALT", "EXIT", ""},      {"MVI", "LD", "I, *"},    {"JMI", "JP", "V0, *"},    {"GDELAY", "LD", "*, DT"},
+    {"KEY", "LD", "*, K"},     {"SDELAY", "LD", "DT, *"}, {"SSOUND", "LD", "ST, *"}, {"ADI", "ADD", "I, *"},
+    {"FONT", "LD", "F, *"},    {"XFONT", "LD", "HF, *"}, {"BCD", "LD", "B, *"},     {"STR", "LD", "[I], *"},
+    {"LDR", "LD", "*, [I]"},
+};
+
+static const char *directives[] = {"=",     "EQU",   "DB",     "DW",    "DA",    "DS",   "ORG",
+                                   "ALIGN", "OPTION", "DEFINE", "UNDEF", "IFDEF", "IFUND", "IFNDEF",
+                                   "ELSE",  "ENDIF", "USED",   "XREF",  "END",   "INCLUDE"};
+
+// operands that name a register other than VX, never an expression
+static const char *reserved[] = {"I", "[I]", "DT", "ST", "K", "F", "HF", "B", "R"};
+
+static const char *options[] = {"BINARY", "HPASC", "CHIP8", "CHIP48", "SCHIP10", "SCHIP11", "XOCHIP", "MEGACHIP"};
+
+#define COUNT(array) (int)(sizeof(array) / sizeof(array[0]))
+
+static void buildTemplates(void) {
+    static bool built = false;
+    if (built) {
+        return;
+    }
+    for (int op = OP_UNKNOWN + 1; op < OPS; op++) {
+        struct Template *t = &templates[op];
+        const char *c = opTable[op].format;
+        int n = 0;
+        while (*c != '\0' && *c != ' ') {
+            t->mnemonic[n++] = *c++;
+        }
+        while (*c == ' ') {
+            c++;
+        }
+        while (*c != '\0') {
+            n = 0;
+            while (*c != '\0' && *c != ',') {
+                t->operands[t->count][n++] = *c++;
+            }
+            t->count++;
+            c += *c == ',' ? 2 : 0;
+        }
+    }
+    built = true;
+}
+
+static void asmError(struct Assembler *as, const char *format, ...) {
+    // pass one only sizes statements, every error shows up again in pass two
+    if (as->pass != 2) {
+        return;
+    }
+    va_list args;
+    va_start(args, format);
+    fprintf(as->log, "[Error] %s:%d: ", as->file, as->line);
+    vfprintf(as->log, format, args);
+    fputc('\n', as->log);
+    va_end(args);
+    as->errors++;
+}
+
+static bool isKeyword(const char *word) {
+    for (int i = 0; i < COUNT(directives); i++) {
+        if (strcasecmp(directives[i], word) == 0) {
+            return true;
+        }
+    }
+    for (int i = 0; i < COUNT(aliases); i++) {
+        if (strcasecmp(aliases[i].name, word) == 0) {
+            return true;
+        }
+    }
+    for (int op = OP_UNKNOWN + 1; op < OPS; op++) {
+        if (strcasecmp(templates[op].mnemonic, word) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// -------------------------------- symbols --------------------------------
+
+static unsigned long long nameHash(const char *name) {
+    char upper[ASM_NAME_MAX];
+    size_t n = 0;
+    for (; name[n] != '\0' && n < sizeof(upper); n++) {
+        upper[n] = toupper((unsigned char)name[n]);
+    }
+    return hashBytes(upper, n);
+}
+
+static void tableInsert(struct Assembler *as, int index) {
+    int slot = nameHash(as->symbols[index].name) & (as->slots - 1);
+    while (as->table[slot] != -1) {
+        slot = (slot + 1) & (as->slots - 1);
+    }
+    as->table[slot] = index;
+}
+
+// sized to stay at most half full
+static void rebuildTable(struct Assembler *as) {
+    int slots = 64;
+    while (slots < as->count * 2) {
+        slots *= 2;
+    }
+    free(as->table);
+    as->table = malloc(slots * sizeof(int));
+    if (as->table == 0x00) {
+        abort();
+    }
+    as->slots = slots;
+    memset(as->table, -1, slots * sizeof(int));
+    for (int i = 0; i < as->count; i++) {
+        tableInsert(as, i);
+    }
+}
+
+static int findSymbol(struct Assembler *as, const char *name) {
+    int slot = nameHash(name) & (as->slots - 1);
+    while (as->table[slot] != -1) {
+        if (strcasecmp(as->symbols[as->table[slot]].name, name) == 0) {
+            return as->table[slot];
+        }
+        slot = (slot + 1) & (as->slots - 1);
+    }
+    return -1;
+}
+
+static int addSymbol(struct Assembler *as, const char *name, enum SymbolKind kind) {
+    if (as->count == as->symbol_capacity) {
+        as->symbol_capacity = as->symbol_capacity ? as->symbol_capacity * 2 : 64;
+        as->symbols = realloc(as->symbols, as->symbol_capacity * sizeof(struct AsmSymbol));
+        if (as->symbols == 0x00) {
+            abort();
+        }
+    }
+    struct AsmSymbol *symbol = &as->symbols[as->count++];
+    memset(symbol, 0, sizeof(struct AsmSymbol));
+    symbol->name = strdup(name);
+    symbol->kind = kind;
+    symbol->line = as->line;
+    if (as->count * 2 > as->slots) {
+        rebuildTable(as);
+    } else {
+        tableInsert(as, as->count - 1);
+    }
+    return as->count - 1;
+}
+
+// finds or creates the label or EQU defined on this line, -1 if the name is taken
+static int declare(struct Assembler *as, const char *name, enum SymbolKind kind) {
+    if (strlen(name) >= ASM_NAME_MAX) {
+        asmError(as, "%s is longer than %d characters", name, ASM_NAME_MAX - 1);
+        return -1;
+    }
+    int index = findSymbol(as, name);
+    if (index == -1) {
+        return addSymbol(as, name, kind);
+    }
+    struct AsmSymbol *symbol = &as->symbols[index];
+    if (symbol->line != as->line) {
+        asmError(as, "%s is already defined on line %d", name, symbol->line);
+        return -1;
+    }
+    return index;
+}
+
+static struct AsmSymbol *findDefine(struct Assembler *as, const char *name) {
+    for (int i = 0; i < as->define_count; i++) {
+        if (strcasecmp(as->defines[i].name, name) == 0) {
+            return &as->defines[i];
+        }
+    }
+    return 0x00;
+}
+
+// DEFINE and UNDEF, a handful per source so a list does
+static void setDefine(struct Assembler *as, const char *name, bool defined) {
+    struct AsmSymbol *define = findDefine(as, name);
+    if (define == 0x00) {
+        if (as->define_count == as->define_capacity) {
+            as->define_capacity = as->define_capacity ? as->define_capacity * 2 : 8;
+            as->defines = realloc(as->defines, as->define_capacity * sizeof(struct AsmSymbol));
+            if (as->defines == 0x00) {
+                abort();
+            }
+        }
+        define = &as->defines[as->define_count++];
+        memset(define, 0, sizeof(struct AsmSymbol));
+        define->name = strdup(name);
+        define->line = as->line;
+    }
+    define->defined = defined;
+}
+
+// labels take the address of the next statement that emits, after alignment
+static void bindLabels(struct Assembler *as) {
+    for (int i = 0; i < as->pending_count; i++) {
+        struct AsmSymbol *symbol = &as->symbols[as->pending[i]];
+        if (as->pass == 2 && symbol->value != (long)as->pc) {
+            asmError(as, "%s moved from 0x%lX to 0x%X between passes", symbol->name, symbol->value, as->pc);
+        }
+        symbol->value = as->pc;
+        symbol->defined = true;
+    }
+    as->pending_count = 0;
+}
+
+// ------------------------------- expressions -------------------------------
+
+/*
+    CHIPPER expressions, loosest binding first:
+        |   ^   &   < > (shifts)   \ (divide)   + -   * / %   unary - + ~ !
+    Operators of one level group to the right, BottomLine-TopLine-1 in
+    VBRIX is 32, and \ binds looser than -, MAZEEND - MAZE \ 4 in BLINKY
+    is a count of words; the shipped binaries depend on both. Numbers are
+    decimal, #hex or $binary with . for 0; ? is the current address, and
+    so is . in Robson's sources.
+*/
+struct Expr {
+    struct Assembler *as;
+    const char *p;
+    bool failed;
+};
+
+static long parseLevel(struct Expr *e, int level);
+
+static void skipSpaces(struct Expr *e) {
+    while (isspace((unsigned char)*e->p)) {
+        e->p++;
+    }
+}
+
+static void exprError(struct Expr *e, const char *format, const char *what) {
+    if (!e->failed) {
+        asmError(e->as, format, what);
+    }
+    e->failed = true;
+}
+
+static bool isNameChar(char c) {
+    return isalnum((unsigned char)c) || c == '_';
+}
+
+static long parsePrimary(struct Expr *e) {
+    skipSpaces(e);
+    const char *start = e->p;
+    long value = 0;
+    if (*e->p == '(') {
+        e->p++;
+        value = parseLevel(e, 0);
+        skipSpaces(e);
+        if (*e->p != ')') {
+            exprError(e, "missing ) in %s", start);
+        } else {
+            e->p++;
+        }
+        return value;
+    }
+    if (*e->p == '#') {
+        e->p++;
+        if (!isxdigit((unsigned char)*e->p)) {
+            exprError(e, "bad hex number %s", start);
+        }
+        while (isxdigit((unsigned char)*e->p)) {
+            value = value * 16 + (isdigit((unsigned char)*e->p) ? *e->p - '0' : toupper(*e->p) - 'A' + 10);
+            e->p++;
+        }
+        return value;
+    }
+    if (*e->p == '$') {
+        e->p++;
+        if (*e->p != '0' && *e->p != '1' && *e->p != '.') {
+            exprError(e, "bad binary number %s", start);
+        }
+        while (*e->p == '0' || *e->p == '1' || *e->p == '.') {
+            value = value * 2 + (*e->p == '1');
+            e->p++;
+        }
+        return value;
+    }
+    if (isdigit((unsigned char)*e->p)) {
+        while (isdigit((unsigned char)*e->p)) {
+            value = value * 10 + (*e->p - '0');
+            e->p++;
+        }
+        return value;
+    }
+    if (*e->p == '\'' && e->p[1] != '\0' && e->p[2] == '\'') {
+        value = (unsigned char)e->p[1];
+        e->p += 3;
+        return value;
+    }
+    if (*e->p == '?' || (*e->p == '.' && !isNameChar(e->p[1]))) {
+        e->p++;
+        return e->as->pc;
+    }
+    if (isalpha((unsigned char)*e->p) || *e->p == '_') {
+        char name[ASM_NAME_MAX];
+        size_t n = 0;
+        while (isNameChar(*e->p)) {
+            if (n + 1 < sizeof(name)) {
+                name[n++] = *e->p;
+            }
+            e->p++;
+        }
+        name[n] = '\0';
+        int index = findSymbol(e->as, name);
+        if (index == -1 || !e->as->symbols[index].defined) {
+            // pass one can't know labels further down yet
+            e->as->unresolved = true;
+            if (e->as->pass == 2) {
+                exprError(e, "undefined symbol %s", name);
+            }
+            return 0;
+        }
+        return e->as->symbols[index].value;
+    }
+    exprError(e, "expected a value at %s", *start ? start : "end of line");
+    return 0;
+}
+
+static long parseUnary(struct Expr *e) {
+    skipSpaces(e);
+    switch (*e->p) {
+    case '-':
+        e->p++;
+        return -parseUnary(e);
+    case '+':
+        e->p++;
+        return parseUnary(e);
+    case '~':
+        e->p++;
+        return ~parseUnary(e);
+    case '!':
+        e->p++;
+        return !parseUnary(e);
+    default:
+        return parsePrimary(e);
+    }
+}
+
+// binary operators, loosest binding first
+static const char *levels[] = {"|", "^", "&", "<>", "\\", "+-", "*/%"};
+
+static long apply(struct Expr *e, char op, long lhs, long rhs) {
+    switch (op) {
+    case '|':
+        return lhs | rhs;
+    case '^':
+        return lhs ^ rhs;
+    case '&':
+        return lhs & rhs;
+    case '<':
+        return lhs << rhs;
+    case '>':
+        return lhs >> rhs;
+    case '+':
+        return lhs + rhs;
+    case '-':
+        return lhs - rhs;
+    case '*':
+        return lhs * rhs;
+    }
+    if (rhs == 0) {
+        exprError(e, "division by zero%s", "");
+        return 0;
+    }
+    return op == '%' ? lhs % rhs : lhs / rhs;
+}
+
+static long parseLevel(struct Expr *e, int level) {
+    if (level == COUNT(levels)) {
+        return parseUnary(e);
+    }
+    long value = parseLevel(e, level + 1);
+    skipSpaces(e);
+    char op = *e->p;
+    if (op == '\0' || strchr(levels[level], op) == 0x00) {
+        return value;
+    }
+    // CHIPPER writes < and >, << and >> are accepted too
+    e->p += (op == '<' || op == '>') && e->p[1] == op ? 2 : 1;
+    // the right side is the rest of the level, so a - b - c is a - (b - c)
+    return apply(e, op, value, parseLevel(e, level));
+}
+
+// evaluates text, 0 on success; as->unresolved tells pass one the value isn't known yet
+static int evaluate(struct Assembler *as, const char *text, long *value) {
+    struct Expr e = {as, text, false};
+    as->unresolved = false;
+    *value = parseLevel(&e, 0);
+    skipSpaces(&e);
+    if (*e.p != '\0') {
+        exprError(&e, "unexpected %s", e.p);
+    }
+    return e.failed ? -1 : 0;
+}
+
+// evaluates text and checks it fits in [min, max], 0 on success
+static int evaluateRange(struct Assembler *as, const char *text, long min, long max, long *value) {
+    if (evaluate(as, text, value) == -1) {
+        return -1;
+    }
+    if (as->pass == 2 && (*value < min || *value > max)) {
+        asmError(as, "%s is %ld, outside %ld to %ld", text, *value, min, max);
+        return -1;
+    }
+    return 0;
+}
+
+// ------------------------------- statements -------------------------------
+
+static void emit(struct Assembler *as, unsigned char byte) {
+    if (as->pc < ROM_START || as->pc >= ROM_START + ROM_MAX_SIZE) {
+        asmError(as, "address 0x%X is outside the program area", as->pc);
+        as->pc++;
+        return;
+    }
+    unsigned int offset = as->pc - ROM_START;
+    if (as->pass == 2) {
+        if (offset >= as->capacity) {
+            unsigned int capacity = as->capacity ? as->capacity : 4096;
+            while (capacity <= offset) {
+                capacity *= 2;
+            }
+            as->image = realloc(as->image, capacity);
+            if (as->image == 0x00) {
+                abort();
+            }
+            memset(&as->image[as->capacity], 0, capacity - as->capacity);
+            as->capacity = capacity;
+        }
+        as->image[offset] = byte;
+        as->size = offset + 1 > as->size ? offset + 1 : as->size;
+    }
+    as->pc++;
+}
+
+// instructions and words start at even addresses while ALIGN is ON
+static void alignWord(struct Assembler *as) {
+    if (as->align && (as->pc & 1)) {
+        emit(as, 0);
+    }
+}
+
+static char *trim(char *text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    size_t n = strlen(text);
+    while (n > 0 && isspace((unsigned char)text[n - 1])) {
+        text[--n] = '\0';
+    }
+    return text;
+}
+
+// splits operands at commas outside quotes and parentheses
+static int splitOperands(char *text, char **operands) {
+    int count = 0, depth = 0;
+    bool quoted = false;
+    text = trim(text);
+    if (*text == '\0') {
+        return 0;
+    }
+    operands[count++] = text;
+    for (char *c = text; *c != '\0'; c++) {
+        if (*c == '\'') {
+            quoted = !quoted;
+        } else if (!quoted && *c == '(') {
+            depth++;
+        } else if (!quoted && *c == ')') {
+            depth--;
+        } else if (!quoted && depth == 0 && *c == ',' && count < ASM_OPERANDS) {
+            *c = '\0';
+            operands[count++] = c + 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        operands[i] = trim(operands[i]);
+    }
+    return count;
+}
+
+// V0-VF, or R0-RF in Robson's sources; -1 if text isn't a register
+static int registerNumber(const char *text) {
+    if ((toupper(text[0]) == 'V' || toupper(text[0]) == 'R') && isxdigit((unsigned char)text[1]) && text[2] == '\0') {
+        return isdigit((unsigned char)text[1]) ? text[1] - '0' : toupper(text[1]) - 'A' + 10;
+    }
+    return -1;
+}
+
+// compares ignoring case and blanks, so [ I ] is [I]
+static bool sameWord(const char *a, const char *b) {
+    for (;;) {
+        while (isspace((unsigned char)*a)) {
+            a++;
+        }
+        while (isspace((unsigned char)*b)) {
+            b++;
+        }
+        if (toupper((unsigned char)*a) != toupper((unsigned char)*b)) {
+            return false;
+        }
+        if (*a == '\0') {
+            return true;
+        }
+        a++;
+        b++;
+    }
+}
+
+static bool isReserved(const char *text) {
+    for (int i = 0; i < COUNT(reserved); i++) {
+        if (sameWord(reserved[i], text)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// the operand text of a %l after its LONG keyword, 0x00 if it has none
+static const char *afterLong(const char *text) {
+    if (strncasecmp(text, "LONG", 4) == 0 && isspace((unsigned char)text[4])) {
+        return text + 5;
+    }
+    return 0x00;
+}
+
+static bool operandFits(const char *pattern, const char *text) {
+    if (pattern[0] == '%') {
+        if (pattern[1] == 'x' || pattern[1] == 'y') {
+            return registerNumber(text) != -1;
+        }
+        // LD I, LONG %l is tried after LD I, %a, which mustn't take "LONG x" for an expression
+        return registerNumber(text) == -1 && !isReserved(text) && afterLong(text) == 0x00;
+    }
+    if (strncmp(pattern, "LONG ", 5) == 0) {
+        return afterLong(text) != 0x00;
+    }
+    if (registerNumber(pattern) != -1) {
+        return registerNumber(text) == registerNumber(pattern);
+    }
+    return sameWord(pattern, text);
+}
+
+static void encode(struct Assembler *as, enum Op op, char **operands) {
+    const struct Template *t = &templates[op];
+    alignWord(as);
+    bindLabels(as);
+    unsigned int opcode = opTable[op].match;
+    unsigned int word = 0;
+    for (int i = 0; i < t->count; i++) {
+        const char *pattern = t->operands[i];
+        const char *text = operands[i];
+        long value = 0;
+        if (strncmp(pattern, "LONG ", 5) == 0) {
+            pattern += 5;
+            text = afterLong(text);
+        }
+        if (pattern[0] != '%') {
+            continue;
+        }
+        switch (pattern[1]) {
+        case 'x':
+            opcode |= registerNumber(text) << 8;
+            break;
+        case 'y':
+            opcode |= registerNumber(text) << 4;
+            break;
+        case 'n':
+            evaluateRange(as, text, 0, 15, &value);
+            opcode |= value & 0xF;
+            break;
+        case 'm':
+            evaluateRange(as, text, 0, 15, &value);
+            opcode |= (value & 0xF) << 8;
+            break;
+        case 'b':
+            evaluateRange(as, text, -128, 255, &value);
+            opcode |= value & 0xFF;
+            break;
+        case 'a':
+            evaluateRange(as, text, 0, 0xFFF, &value);
+            opcode |= value & 0xFFF;
+            break;
+        case 'l':
+            evaluateRange(as, text, 0, 0xFFFF, &value);
+            word = value & 0xFFFF;
+            break;
+        case 'L':
+            evaluateRange(as, text, 0, 0xFFFFFF, &value);
+            opcode |= value >> 16 & 0xFF;
+            word = value & 0xFFFF;
+            break;
+        }
+    }
+    emit(as, opcode >> 8);
+    emit(as, opcode);
+    if (opTable[op].size == 4) {
+        emit(as, word >> 8);
+        emit(as, word);
+    }
+}
+
+static void instruction(struct Assembler *as, const char *mnemonic, char *text) {
+    char rewritten[ASM_LINE_MAX];
+    for (int i = 0; i < COUNT(aliases); i++) {
+        if (strcasecmp(aliases[i].name, mnemonic) != 0) {
+            continue;
+        }
+        // STR and LDR name a range, V0-VX, of which only VX is encoded
+        char *range = strchr(text, '-');
+        if (strchr(aliases[i].operands, '[') != 0x00 && range != 0x00) {
+            text = range + 1;
+        }
+        size_t n = 0;
+        for (const char *c = aliases[i].operands; *c != '\0' && n + 1 < sizeof(rewritten); c++) {
+            if (*c == '*') {
+                size_t len = strlen(text);
+                len = len < sizeof(rewritten) - 1 - n ? len : sizeof(rewritten) - 1 - n;
+                memcpy(&rewritten[n], text, len);
+                n += len;
+            } else {
+                rewritten[n++] = *c;
+            }
+        }
+        rewritten[n] = '\0';
+        mnemonic = aliases[i].mnemonic;
+        text = rewritten;
+        break;
+    }
+    char *operands[ASM_OPERANDS];
+    int count = splitOperands(text, operands);
+    bool known = false;
+    for (int op = OP_UNKNOWN + 1; op < OPS; op++) {
+        const struct Template *t = &templates[op];
+        if (strcasecmp(t->mnemonic, mnemonic) != 0) {
+            continue;
+        }
+        known = true;
+        // SHR VX and SHL VX leave VY at 0, as CHIPPER does
+        char *shift[2] = {count > 0 ? operands[0] : 0x00, "V0"};
+        char **given = operands;
+        if ((op == OP_SHR || op == OP_SHL) && count == 1) {
+            given = shift;
+        } else if (count != t->count) {
+            continue;
+        }
+        bool fits = true;
+        for (int i = 0; i < t->count && fits; i++) {
+            fits = operandFits(t->operands[i], given[i]);
+        }
+        if (fits) {
+            encode(as, op, given);
+            return;
+        }
+    }
+    if (known) {
+        asmError(as, "%s doesn't take these operands", mnemonic);
+    } else {
+        asmError(as, "unknown instruction %s", mnemonic);
+    }
+    // keep the addresses after it right
+    alignWord(as);
+    bindLabels(as);
+    emit(as, 0);
+    emit(as, 0);
+}
+
+// DB, DW and DA; quoted strings give one byte per character
+static void data(struct Assembler *as, int width, char *text) {
+    if (width == 2) {
+        alignWord(as);
+    }
+    bindLabels(as);
+    char *operands[ASM_OPERANDS];
+    int count = splitOperands(text, operands);
+    if (count == 0) {
+        asmError(as, "no data given");
+    }
+    for (int i = 0; i < count; i++) {
+        const char *item = operands[i];
+        size_t len = strlen(item);
+        if (len == 0 && i == count - 1) {
+            // a line may end with a comma
+            break;
+        }
+        if (width == 1 && len >= 2 && item[0] == '\'' && item[len - 1] == '\'' && len != 3) {
+            // '' inside the quotes is a quote
+            for (size_t c = 1; c + 1 < len; c++) {
+                emit(as, item[c]);
+                c += item[c] == '\'' && item[c + 1] == '\'';
+            }
+            continue;
+        }
+        long value = 0;
+        if (width == 1) {
+            evaluateRange(as, item, -128, 255, &value);
+            emit(as, value);
+        } else {
+            evaluateRange(as, item, -32768, 65535, &value);
+            emit(as, value >> 8);
+            emit(as, value);
+        }
+    }
+}
+
+// a value every pass needs, like a DS size or an ORG address
+static int knownValue(struct Assembler *as, const char *text, long *value) {
+    if (evaluate(as, text, value) == -1) {
+        return -1;
+    }
+    if (as->unresolved) {
+        as->pass = 2;
+        asmError(as, "%s must only use symbols defined above it", text);
+        as->pass = 1;
+        return -1;
+    }
+    return 0;
+}
+
+static bool onOff(struct Assembler *as, const char *text, bool current) {
+    if (strcasecmp(text, "ON") == 0) {
+        return true;
+    }
+    if (strcasecmp(text, "OFF") == 0) {
+        return false;
+    }
+    asmError(as, "expected ON or OFF, not %s", text);
+    return current;
+}
+
+static void conditional(struct Assembler *as, const char *directive, const char *name) {
+    if (strcasecmp(directive, "ELSE") == 0 || strcasecmp(directive, "ENDIF") == 0) {
+        if (as->depth == 0) {
+            asmError(as, "%s without IFDEF", directive);
+        } else if (toupper(directive[1]) == 'L') {
+            as->skip[as->depth - 1] = !as->skip[as->depth - 1];
+        } else {
+            as->depth--;
+        }
+        return;
+    }
+    if (as->depth == ASM_NESTING) {
+        asmError(as, "IFDEF nested deeper than %d", ASM_NESTING);
+        return;
+    }
+    struct AsmSymbol *define = findDefine(as, name);
+    bool defined = define != 0x00 && define->defined;
+    as->skip[as->depth++] = strcasecmp(directive, "IFDEF") == 0 ? !defined : defined;
+}
+
+static bool conditionalActive(struct Assembler *as) {
+    for (int i = 0; i < as->depth; i++) {
+        if (as->skip[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void directive(struct Assembler *as, const char *name, char *text) {
+    long value = 0;
+    if (strcasecmp(name, "DB") == 0 || strcasecmp(name, "DA") == 0) {
+        data(as, 1, text);
+    } else if (strcasecmp(name, "DW") == 0) {
+        data(as, 2, text);
+    } else if (strcasecmp(name, "DS") == 0) {
+        bindLabels(as);
+        if (knownValue(as, text, &value) == 0) {
+            for (long i = 0; i < value; i++) {
+                emit(as, 0);
+            }
+        }
+    } else if (strcasecmp(name, "ORG") == 0) {
+        if (knownValue(as, text, &value) == 0) {
+            as->pc = value;
+        }
+    } else if (strcasecmp(name, "ALIGN") == 0) {
+        if (*text == '\0') {
+            alignWord(as);
+        } else {
+            as->align = onOff(as, text, as->align);
+        }
+    } else if (strcasecmp(name, "OPTION") == 0) {
+        for (int i = 0; i < COUNT(options); i++) {
+            if (strcasecmp(options[i], text) == 0) {
+                return;
+            }
+        }
+        asmError(as, "unknown option %s", text);
+    } else if (strcasecmp(name, "DEFINE") == 0 || strcasecmp(name, "UNDEF") == 0) {
+        setDefine(as, text, toupper(name[0]) == 'D');
+    } else if (strcasecmp(name, "USED") == 0 || strcasecmp(name, "XREF") == 0) {
+        // cross reference listing controls, there is no listing
+    } else if (strcasecmp(name, "END") == 0) {
+        as->ended = true;
+    } else if (strcasecmp(name, "INCLUDE") == 0) {
+        asmError(as, "INCLUDE is not supported");
+    } else {
+        asmError(as, "%s needs a name", name);
+    }
+}
+
+static void assembleLine(struct Assembler *as, char *line) {
+    // the comment goes, unless the ; is quoted
+    bool quoted = false;
+    for (char *c = line; *c != '\0'; c++) {
+        if (*c == '\'') {
+            quoted = !quoted;
+        } else if (*c == ';' && !quoted) {
+            *c = '\0';
+            break;
+        }
+    }
+    // a label ends with a colon, or starts in the first column without one
+    char *label = 0x00;
+    char *p = line;
+    char *word = p + strspn(p, " \t");
+    char *end = word + strcspn(word, " \t:");
+    if (*end == ':') {
+        label = word;
+        *end = '\0';
+        p = end + 1;
+    } else if (!isspace((unsigned char)*p) && *p != '\0') {
+        char saved = *end;
+        *end = '\0';
+        if (!isKeyword(p)) {
+            label = p;
+            p = saved != '\0' ? end + 1 : end;
+        } else {
+            *end = saved;
+        }
+    }
+    p = trim(p);
+    char *mnemonic = p;
+    p += strcspn(p, " \t");
+    if (*p != '\0') {
+        *p++ = '\0';
+    }
+    char *operands = trim(p);
+    // NAME = value may be indented too
+    bool equ = strncasecmp(operands, "EQU", 3) == 0 && isspace((unsigned char)operands[3]);
+    if (label == 0x00 && (operands[0] == '=' || equ)) {
+        label = mnemonic;
+        mnemonic = operands[0] == '=' ? "=" : "EQU";
+        operands = trim(operands + (operands[0] == '=' ? 1 : 3));
+    }
+    if (strcasecmp(mnemonic, "IFDEF") == 0 || strcasecmp(mnemonic, "IFUND") == 0 ||
+        strcasecmp(mnemonic, "IFNDEF") == 0 || strcasecmp(mnemonic, "ELSE") == 0 ||
+        strcasecmp(mnemonic, "ENDIF") == 0) {
+        // a label in front belongs to the code around the conditional, which
+        // is assembled if either side of the line is
+        bool before = conditionalActive(as);
+        conditional(as, mnemonic, operands);
+        if (!before && !conditionalActive(as)) {
+            return;
+        }
+        mnemonic = "";
+    } else if (!conditionalActive(as)) {
+        return;
+    }
+    if (label != 0x00 && (strcmp(mnemonic, "=") == 0 || strcasecmp(mnemonic, "EQU") == 0)) {
+        int index = declare(as, label, SYM_EQU);
+        long value = 0;
+        if (index != -1 && evaluate(as, operands, &value) == 0) {
+            as->symbols[index].value = value;
+            as->symbols[index].defined = !as->unresolved;
+        }
+        return;
+    }
+    if (label != 0x00) {
+        int index = declare(as, label, SYM_LABEL);
+        if (index != -1 && as->pending_count < ASM_PENDING) {
+            as->pending[as->pending_count++] = index;
+        }
+    }
+    if (*mnemonic == '\0') {
+        return;
+    }
+    for (int i = 0; i < COUNT(directives); i++) {
+        if (strcasecmp(directives[i], mnemonic) == 0) {
+            directive(as, directives[i], operands);
+            return;
+        }
+    }
+    instruction(as, mnemonic, operands);
+}
+
+/**
+ * @brief asmInit(as, log) is used to start an assembler with no symbols
+ * @param as the assembler
+ * @param log where errors are printed, usually stderr
+ * @return void
+ */
+void asmInit(struct Assembler *as, FILE *log) {
+    memset(as, 0, sizeof(struct Assembler));
+    as->log = log;
+    as->file = "";
+    buildTemplates();
+    rebuildTable(as);
+}
+
+/**
+ * @brief asmDefine(as, name) is used to DEFINE name before assembling,
+ * like -D on the command line
+ * @param as the assembler
+ * @param name symbol IFDEF tests for
+ * @return void
+ */
+void asmDefine(struct Assembler *as, const char *name) {
+    setDefine(as, name, true);
+}
+
+/**
+ * @brief asmAssemble(as, source, len, file) is used to assemble a CHIPPER
+ * source into as->image, loaded at ROM_START; errors are printed to the log
+ * with their line numbers
+ * @param as an initialized assembler
+ * @param source the text, not necessarily terminated
+ * @param len its length
+ * @param file name used in error messages
+ * @return 0 on success, -1 if there were errors
+ */
+int asmAssemble(struct Assembler *as, const char *source, size_t len, const char *file) {
+    char line[ASM_LINE_MAX];
+    as->file = file;
+    for (as->pass = 1; as->pass <= 2; as->pass++) {
+        as->pc = ROM_START;
+        as->align = true;
+        as->ended = false;
+        as->depth = 0;
+        as->pending_count = 0;
+        as->line = 0;
+        // names DEFINEd by the source start over, the ones given before stay
+        for (int i = 0; i < as->define_count; i++) {
+            as->defines[i].defined = as->defines[i].line == 0;
+        }
+        const char *p = source, *end = source + len;
+        while (p < end && !as->ended) {
+            const char *eol = memchr(p, '\n', end - p);
+            eol = eol != 0x00 ? eol : end;
+            size_t n = eol - p;
+            as->line++;
+            if (n >= sizeof(line)) {
+                asmError(as, "line is longer than %d characters", ASM_LINE_MAX - 1);
+            } else {
+                memcpy(line, p, n);
+                line[n] = '\0';
+                assembleLine(as, line);
+            }
+            p = eol + 1;
+        }
+        bindLabels(as);
+        if (as->depth != 0) {
+            asmError(as, "IFDEF without ENDIF");
+        }
+    }
+    return as->errors > 0 ? -1 : 0;
+}
+
+static int byValue(const void *a, const void *b) {
+    const struct AsmSymbol *x = *(struct AsmSymbol *const *)a, *y = *(struct AsmSymbol *const *)b;
+    if (x->value != y->value) {
+        return x->value < y->value ? -1 : 1;
+    }
+    return strcasecmp(x->name, y->name);
+}
+
+/**
+ * @brief asmWriteSymbols(as, out) is used to write the symbol map, one
+ * "value kind name" line per label and EQU, sorted by value
+ * @param as an assembler that has run
+ * @param out file to write to
+ * @return 0 on success, -1 on errors
+ */
+int asmWriteSymbols(struct Assembler *as, FILE *out) {
+    struct AsmSymbol **sorted = malloc((as->count + 1) * sizeof(struct AsmSymbol *));
+    if (sorted == 0x00) {
+        return -1;
+    }
+    int n = 0;
+    for (int i = 0; i < as->count; i++) {
+        if (as->symbols[i].defined) {
+            sorted[n++] = &as->symbols[i];
+        }
+    }
+    qsort(sorted, n, sizeof(struct AsmSymbol *), byValue);
+    for (int i = 0; i < n; i++) {
+        fprintf(out, "%04lX %-5s %s\n", sorted[i]->value & 0xFFFFFF, sorted[i]->kind == SYM_LABEL ? "label" : "equ",
+                sorted[i]->name);
+    }
+    free(sorted);
+    return ferror(out) ? -1 : 0;
+}
+
+void asmFree(struct Assembler *as) {
+    for (int i = 0; i < as->count; i++) {
+        free(as->symbols[i].name);
+    }
+    free(as->symbols);
+    free(as->table);
+    for (int i = 0; i < as->define_count; i++) {
+        free(as->defines[i].name);
+    }
+    free(as->defines);
+    free(as->image);
+    memset(as, 0, sizeof(struct Assembler));
+}
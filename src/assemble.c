@@ -0,0 +1,82 @@
+#include "inc/asm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static char *readFile(const char *path, size_t *len) {
+    FILE *file = fopen(path, "rb");
+    if (file == 0x00) {
+        return 0x00;
+    }
+    size_t capacity = 1 << 16;
+    char *text = malloc(capacity);
+    if (text == 0x00) {
+        abort();
+    }
+    size_t n;
+    *len = 0;
+    while ((n = fread(&text[*len], 1, capacity - *len, file)) > 0) {
+        *len += n;
+        if (*len == capacity) {
+            capacity *= 2;
+            text = realloc(text, capacity);
+            if (text == 0x00) {
+                abort();
+            }
+        }
+    }
+    fclose(file);
+    return text;
+}
+
+// assembles a CHIPPER source into a ROM, and optionally writes its symbol map
+int main(int argc, char **argv) {
+    struct Assembler as;
+    asmInit(&as, stderr);
+    int arg = 1;
+    while (arg + 1 < argc && strcmp(argv[arg], "-D") == 0) {
+        asmDefine(&as, argv[arg + 1]);
+        arg += 2;
+    }
+    if (argc - arg != 2 && argc - arg != 3) {
+        printf("[Error] usage: ./chip8-asm [-D name]... <source file> <rom file> [symbol file]\n");
+        asmFree(&as);
+        return -1;
+    }
+    size_t len;
+    char *source = readFile(argv[arg], &len);
+    if (source == 0x00) {
+        printf("[Error] could not read %s\n", argv[arg]);
+        asmFree(&as);
+        return -1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = asmAssemble(&as, source, len, argv[arg]);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    free(source);
+    if (result == -1) {
+        printf("[Error] %s: %d errors\n", argv[arg], as.errors);
+        asmFree(&as);
+        return -1;
+    }
+    FILE *rom = fopen(argv[arg + 1], "wb");
+    if (rom == 0x00 || fwrite(as.image, 1, as.size, rom) != as.size || fclose(rom) != 0) {
+        printf("[Error] could not write %s\n", argv[arg + 1]);
+        asmFree(&as);
+        return -1;
+    }
+    if (argc - arg == 3) {
+        FILE *symbols = fopen(argv[arg + 2], "w");
+        if (symbols == 0x00 || asmWriteSymbols(&as, symbols) == -1 || fclose(symbols) != 0) {
+            printf("[Error] could not write %s\n", argv[arg + 2]);
+            asmFree(&as);
+            return -1;
+        }
+    }
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("%s: %u bytes, %d symbols, %.2f ms\n", argv[arg + 1], as.size, as.count, ms);
+    asmFree(&as);
+    return 0;
+}
@@ -0,0 +1,312 @@
+#include "inc/chip8.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+
+/*
+    Micro benchmarks run small looping programs through execOpcode(), one
+    per instruction family, so they measure the interpreter alone. Macro
+    benchmarks run every ROM of a directory through chFrame() with the same
+    scripted input, so translated ROMs (see inc/aot.h) run translated, and
+    are played once more to time each frame. Every benchmark runs RUNS
+    times and the fastest run counts. Results are written as JSON, one
+    benchmark per line, and can be compared with an earlier file.
+*/
+#define MICRO_INSTRUCTIONS 20000000
+#define ROM_FRAMES 300000
+#define RUNS 5
+#define MAX_BENCHMARKS 256
+// a benchmark losing more than this percentage of its MIPS is a regression
+#define TOLERANCE 10.0
+
+struct Program {
+    const char *name;
+    const unsigned char *code;
+    size_t size;
+};
+
+// 8XYN and 7XNN, after two loads
+static const unsigned char alu[] = {0x60, 0x01, 0x61, 0x03, 0x80, 0x14, 0x81, 0x25, 0x82, 0x32, 0x83, 0x01,
+                                    0x84, 0x13, 0x85, 0x06, 0x86, 0x0E, 0x70, 0x07, 0x80, 0x17, 0x12, 0x04};
+// font sprites drawn across the screen, wrapping around it
+static const unsigned char draw[] = {0x60, 0x00, 0x61, 0x00, 0xF0, 0x29, 0xD0, 0x15,
+                                     0x70, 0x05, 0x71, 0x03, 0xD0, 0x15, 0x12, 0x04};
+// three calls to a subroutine that adds and returns
+static const unsigned char call[] = {0x22, 0x08, 0x22, 0x08, 0x22, 0x08, 0x12, 0x00, 0x70, 0x01, 0x00, 0xEE};
+// FX33, FX55 and FX65 on the same bytes
+static const unsigned char store[] = {0xA3, 0x00, 0xF0, 0x33, 0xF2, 0x55, 0xF2, 0x65, 0x70, 0x01, 0x12, 0x00};
+
+static const struct Program programs[] = {
+    {"alu", alu, sizeof(alu)},
+    {"draw", draw, sizeof(draw)},
+    {"call", call, sizeof(call)},
+    {"store", store, sizeof(store)},
+};
+
+struct Result {
+    char name[256];
+    const char *profile;
+    const char *engine;
+    unsigned long long instructions;
+    unsigned long frames;
+    double seconds; // of the fastest run
+    double p50;     // frame time percentiles in ns, ROMs only
+    double p90;
+    double p99;
+    double max;
+};
+
+struct Baseline {
+    char name[256];
+    double mips;
+};
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double mips(struct Result *result) {
+    return result->instructions / result->seconds / 1e6;
+}
+
+static void runProgram(const struct Program *program, struct Result *result) {
+    static struct Chip8 chip8;
+    snprintf(result->name, sizeof(result->name), "micro/%s", program->name);
+    result->profile = profileName(PROFILE_CHIP8);
+    result->engine = "interpreter";
+    result->instructions = MICRO_INSTRUCTIONS;
+    for (int run = 0; run < RUNS; run++) {
+        chInit(&chip8);
+        chSetProfile(&chip8, PROFILE_CHIP8);
+        chSeed(&chip8, 1);
+        memcpy(&chip8.memory.memory[ROM_START], program->code, program->size);
+        chip8.registers.PC = ROM_START;
+        double start = now();
+        for (long i = 0; i < MICRO_INSTRUCTIONS; i++) {
+            unsigned short opcode = mergeBytes(&chip8.memory, chip8.registers.PC);
+            chip8.registers.PC += 2;
+            execOpcode(&chip8, opcode);
+        }
+        double seconds = now() - start;
+        if (run == 0 || seconds < result->seconds) {
+            result->seconds = seconds;
+        }
+        chFree(&chip8);
+    }
+}
+
+static int byTime(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+// one run of the ROM, frame_ns gets the time of each frame if it isn't 0x00
+static int playRom(struct Chip8 *chip8, const char *path, struct Result *result, double *frame_ns) {
+    chInit(chip8);
+    enum RomError error = chLoad(chip8, path);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", path, romError(error));
+        chFree(chip8);
+        return -1;
+    }
+    chSeed(chip8, 1);
+    result->profile = profileName(chip8->profile);
+    result->engine = chip8->aot != 0x00 ? "aot" : "interpreter";
+#ifdef CHIP8_HOTSPOTS
+    // counted as chip8 and chip8-headless count them, so the benchmark includes what that costs
+    static struct Hotspots hotspots;
+    hotInit(&hotspots, chip8->registers.PC);
+    chip8->hotspots = &hotspots;
+#endif
+    double start = now();
+    for (int frame = 0; frame < ROM_FRAMES; frame++) {
+        // every key in turn, held for half of each 97 frames
+        if (frame % 97 == 0) {
+            keyDown(&chip8->keyboard, frame / 97 % TOTAL_KEYS);
+        } else if (frame % 97 == 48) {
+            keyUp(&chip8->keyboard, frame / 97 % TOTAL_KEYS);
+        }
+        if (frame_ns == 0x00) {
+            chFrame(chip8);
+            continue;
+        }
+        double frame_start = now();
+        chFrame(chip8);
+        frame_ns[frame] = (now() - frame_start) * 1e9;
+    }
+    double seconds = now() - start;
+    if (frame_ns == 0x00 && (result->seconds == 0 || seconds < result->seconds)) {
+        result->seconds = seconds;
+        result->instructions = chip8->cycles;
+    }
+    chFree(chip8);
+    return 0;
+}
+
+// MIPS come from runs without the clock reads around each frame, the frame times from one more run
+static int runRom(const char *path, const char *name, struct Result *result) {
+    static struct Chip8 chip8;
+    static double frame_ns[ROM_FRAMES];
+    snprintf(result->name, sizeof(result->name), "rom/%s", name);
+    result->frames = ROM_FRAMES;
+    for (int run = 0; run < RUNS; run++) {
+        if (playRom(&chip8, path, result, 0x00) == -1) {
+            return -1;
+        }
+    }
+    playRom(&chip8, path, result, frame_ns);
+    qsort(frame_ns, ROM_FRAMES, sizeof(double), byTime);
+    result->p50 = frame_ns[ROM_FRAMES / 2];
+    result->p90 = frame_ns[ROM_FRAMES * 9 / 10];
+    result->p99 = frame_ns[ROM_FRAMES * 99 / 100];
+    result->max = frame_ns[ROM_FRAMES - 1];
+    return 0;
+}
+
+static int byName(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// the .ch8 files directly in dir, sorted so the output is stable
+static int listRoms(const char *dir, char **names, int capacity) {
+    DIR *d = opendir(dir);
+    if (d == 0x00) {
+        return -1;
+    }
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != 0x00 && count < capacity) {
+        size_t len = strlen(ent->d_name);
+        if (ent->d_name[0] != '.' && len > 4 && strcasecmp(ent->d_name + len - 4, ".ch8") == 0) {
+            names[count++] = strdup(ent->d_name);
+        }
+    }
+    closedir(d);
+    qsort(names, count, sizeof(char *), byName);
+    return count;
+}
+
+static int writeJson(struct Result *results, int count, FILE *out) {
+    fprintf(out, "{\n  \"benchmarks\": [\n");
+    for (int i = 0; i < count; i++) {
+        struct Result *r = &results[i];
+        fprintf(out, "    {\"name\": \"%s\", \"profile\": \"%s\", \"engine\": \"%s\", \"instructions\": %llu, ", r->name,
+                r->profile, r->engine, r->instructions);
+        fprintf(out, "\"seconds\": %.6f, \"mips\": %.2f, \"ns_per_instruction\": %.3f", r->seconds, mips(r),
+                r->seconds * 1e9 / r->instructions);
+        if (r->frames > 0) {
+            fprintf(out, ", \"frames\": %lu, \"frame_ns\": {\"p50\": %.0f, \"p90\": %.0f, \"p99\": %.0f, \"max\": %.0f}",
+                    r->frames, r->p50, r->p90, r->p99, r->max);
+        }
+        fprintf(out, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+    return ferror(out) ? -1 : 0;
+}
+
+// reads the name and MIPS of each benchmark line writeJson() wrote
+static int readBaseline(const char *path, struct Baseline *baseline, int capacity) {
+    FILE *in = fopen(path, "r");
+    if (in == 0x00) {
+        return -1;
+    }
+    char line[1024];
+    int count = 0;
+    while (fgets(line, sizeof(line), in) != 0x00 && count < capacity) {
+        char *name = strstr(line, "\"name\": \"");
+        char *value = strstr(line, "\"mips\": ");
+        if (name == 0x00 || value == 0x00 || sscanf(name + 9, "%255[^\"]", baseline[count].name) != 1) {
+            continue;
+        }
+        baseline[count].mips = strtod(value + 8, 0x00);
+        count++;
+    }
+    fclose(in);
+    return count;
+}
+
+// prints each benchmark next to its baseline, returns the number of regressions
+static int compare(struct Result *results, int count, struct Baseline *baseline, int baseline_count) {
+    int regressions = 0;
+    printf("%-24s %12s %12s %8s\n", "benchmark", "baseline", "MIPS", "change");
+    for (int i = 0; i < count; i++) {
+        struct Baseline *old = 0x00;
+        for (int j = 0; j < baseline_count; j++) {
+            if (strcmp(baseline[j].name, results[i].name) == 0) {
+                old = &baseline[j];
+                break;
+            }
+        }
+        if (old == 0x00) {
+            printf("%-24s %12s %12.2f %8s\n", results[i].name, "-", mips(&results[i]), "new");
+            continue;
+        }
+        double change = (mips(&results[i]) - old->mips) / old->mips * 100;
+        bool regressed = change < -TOLERANCE;
+        regressions += regressed;
+        printf("%-24s %12.2f %12.2f %+7.1f%%%s\n", results[i].name, old->mips, mips(&results[i]), change,
+               regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+// runs the micro and ROM benchmarks, and compares them with a baseline
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 4) {
+        printf("[Error] usage: ./chip8-bench <rom dir> <json output> [baseline json]\n");
+        return -1;
+    }
+    static struct Result results[MAX_BENCHMARKS];
+    static struct Baseline baseline[MAX_BENCHMARKS];
+    int baseline_count = 0;
+    // read first, the baseline may be the file about to be written
+    if (argc == 4 && (baseline_count = readBaseline(argv[3], baseline, MAX_BENCHMARKS)) == -1) {
+        printf("[Error] could not read %s\n", argv[3]);
+        return -1;
+    }
+    char *names[MAX_BENCHMARKS];
+    int program_count = sizeof(programs) / sizeof(programs[0]);
+    int rom_count = listRoms(argv[1], names, MAX_BENCHMARKS - program_count);
+    if (rom_count == -1) {
+        printf("[Error] could not read %s\n", argv[1]);
+        return -1;
+    }
+    int count = 0;
+    for (int i = 0; i < program_count; i++) {
+        runProgram(&programs[i], &results[count]);
+        fprintf(stderr, "%-24s %8.2f MIPS\n", results[count].name, mips(&results[count]));
+        count++;
+    }
+    for (int i = 0; i < rom_count; i++) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", argv[1], names[i]);
+        // the extension is dropped from the name
+        names[i][strlen(names[i]) - 4] = '\0';
+        if (runRom(path, names[i], &results[count]) == 0) {
+            fprintf(stderr, "%-24s %8.2f MIPS, p99 frame %.0f ns\n", results[count].name, mips(&results[count]),
+                    results[count].p99);
+            count++;
+        }
+        free(names[i]);
+    }
+    FILE *out = fopen(argv[2], "w");
+    int written = out != 0x00 ? writeJson(results, count, out) : -1;
+    if (out == 0x00 || fclose(out) != 0 || written == -1) {
+        printf("[Error] could not write %s\n", argv[2]);
+        return -1;
+    }
+    printf("%d benchmarks written to %s\n", count, argv[2]);
+    if (argc == 4) {
+        int regressions = compare(results, count, baseline, baseline_count);
+        if (regressions > 0) {
+            printf("[Error] %d benchmarks lost more than %.0f%% of their MIPS\n", regressions, TOLERANCE);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,514 @@
+#include "inc/cfg.h"
+#include "inc/decode.h"
+#include "inc/rom.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *flow_names[] = {"next", "jump", "call", "skip", "return", "indirect", "stop"};
+static const char *issue_names[ISSUES] = {"unknown", "unsupported", "sys", "overlap", "outside", "self-modify"};
+
+// every extension at once, to tell unsupported instructions from unknown ones
+#define ISA_ALL (ISA_SETS - 1)
+
+static void *grow(void *array, int *capacity, int count, size_t size) {
+    if (count < *capacity) {
+        return array;
+    }
+    *capacity = *capacity ? *capacity * 2 : 16;
+    array = realloc(array, *capacity * size);
+    if (array == 0x00) {
+        abort();
+    }
+    return array;
+}
+
+static int inImage(struct Cfg *cfg, unsigned int addr) {
+    return addr >= cfg->start && addr < cfg->end;
+}
+
+static unsigned short wordAt(struct Cfg *cfg, unsigned int addr) {
+    unsigned int hi = inImage(cfg, addr) ? cfg->data[addr - cfg->start] : 0;
+    unsigned int lo = inImage(cfg, addr + 1) ? cfg->data[addr + 1 - cfg->start] : 0;
+    return hi << 8 | lo;
+}
+
+static void mark(struct Cfg *cfg, unsigned int addr, unsigned char flags) {
+    if (inImage(cfg, addr)) {
+        cfg->flags[addr - cfg->start] |= flags;
+    }
+}
+
+static void note(struct Cfg *cfg, unsigned int addr, enum CfgIssue issue) {
+    if (cfg->reach_only) {
+        return;
+    }
+    cfg->notes = grow(cfg->notes, &cfg->note_capacity, cfg->note_count, sizeof(struct CfgNote));
+    cfg->notes[cfg->note_count++] = (struct CfgNote){addr, wordAt(cfg, addr), issue};
+}
+
+// branch targets waiting to be walked, each walked instruction queues at most one so size + 1 entries never grow
+struct Work {
+    unsigned int *addrs;
+    int count;
+    int capacity;
+};
+
+// starts a block at addr and walks it later, unless it has been walked already
+static void branch(struct Cfg *cfg, struct Work *work, unsigned int addr, unsigned char why) {
+    if (!inImage(cfg, addr)) {
+        return;
+    }
+    cfg->flags[addr - cfg->start] |= why | CFG_LEADER;
+    if ((cfg->flags[addr - cfg->start] & (CFG_CODE | CFG_OPERAND)) == 0) {
+        work->addrs = grow(work->addrs, &work->capacity, work->count, sizeof(unsigned int));
+        work->addrs[work->count++] = addr;
+    }
+}
+
+/*
+    Recursive descent from the entry point: straight-line code is followed
+    until something leaves for good, branch targets are queued and walked
+    the same way. Every byte is decoded at most once.
+*/
+static void walk(struct Cfg *cfg, struct Work *work) {
+    branch(cfg, work, cfg->start, 0);
+    while (work->count > 0) {
+        unsigned int pc = work->addrs[--work->count];
+        while (inImage(cfg, pc) && (cfg->flags[pc - cfg->start] & (CFG_CODE | CFG_OPERAND)) == 0) {
+            unsigned short opcode = wordAt(cfg, pc);
+            enum Op op = decodeOp(cfg->isa, opcode);
+            const struct OpInfo *info = &opTable[op];
+            if (!inImage(cfg, pc + info->size - 1)) {
+                note(cfg, pc, ISSUE_OUTSIDE);
+                break;
+            }
+            cfg->flags[pc - cfg->start] |= CFG_CODE;
+            for (unsigned int i = 1; i < info->size; i++) {
+                cfg->flags[pc + i - cfg->start] |= CFG_OPERAND;
+            }
+            if (op == OP_UNKNOWN) {
+                note(cfg, pc, decodeOp(ISA_ALL, opcode) == OP_UNKNOWN ? ISSUE_UNKNOWN : ISSUE_UNSUPPORTED);
+            } else if (op == OP_SYS) {
+                note(cfg, pc, ISSUE_SYS);
+            }
+            unsigned int next = pc + info->size;
+            unsigned int target = opcode & 0x0FFF;
+            if (op == OP_LD_I) {
+                mark(cfg, target, CFG_DATA);
+            } else if (op == OP_LD_LONG) {
+                mark(cfg, wordAt(cfg, pc + 2), CFG_DATA);
+            } else if (op == OP_LDHI) {
+                mark(cfg, (opcode & 0xFF) << 16 | wordAt(cfg, pc + 2), CFG_DATA);
+            }
+            switch (info->flow) {
+            case FLOW_JUMP:
+                branch(cfg, work, target, CFG_JUMP);
+                next = cfg->end;
+                break;
+            case FLOW_CALL:
+                branch(cfg, work, target, CFG_CALL);
+                mark(cfg, next, CFG_LEADER);
+                break;
+            case FLOW_SKIP:
+                // the skipped instruction may be 4 bytes long
+                mark(cfg, next, CFG_LEADER);
+                branch(cfg, work, next + opTable[decodeOp(cfg->isa, wordAt(cfg, next))].size, 0);
+                break;
+            case FLOW_INDIRECT:
+                if (!cfg->reach_only) {
+                    cfg->indirect =
+                        grow(cfg->indirect, &cfg->indirect_capacity, cfg->indirect_count, sizeof(unsigned int));
+                    cfg->indirect[cfg->indirect_count++] = pc;
+                }
+                branch(cfg, work, target, CFG_JUMP);
+                next = cfg->end;
+                break;
+            case FLOW_RETURN:
+            case FLOW_STOP:
+                next = cfg->end;
+                break;
+            }
+            pc = next;
+        }
+        // straight-line code that runs into the middle of an instruction
+        mark(cfg, pc, CFG_LEADER);
+    }
+}
+
+static void addSucc(struct Cfg *cfg, struct CfgBlock *block, unsigned int addr) {
+    if (!inImage(cfg, addr)) {
+        note(cfg, block->last, ISSUE_OUTSIDE);
+        return;
+    }
+    block->succ[block->succ_count++] = addr;
+}
+
+static void cutBlocks(struct Cfg *cfg) {
+    unsigned int addr = cfg->start;
+    while (addr < cfg->end) {
+        if ((cfg->flags[addr - cfg->start] & CFG_CODE) == 0) {
+            // a leader nothing could decode is a branch into another instruction
+            if ((cfg->flags[addr - cfg->start] & (CFG_LEADER | CFG_OPERAND)) == (CFG_LEADER | CFG_OPERAND)) {
+                note(cfg, addr, ISSUE_OVERLAP);
+            }
+            addr++;
+            continue;
+        }
+        struct CfgBlock block = {addr, addr, addr, {0, 0}, 0, 0, FLOW_NEXT, -1};
+        unsigned int pc = addr, next;
+        const struct OpInfo *info;
+        for (;;) {
+            info = &opTable[decodeOp(cfg->isa, wordAt(cfg, pc))];
+            next = pc + info->size;
+            if (info->flow != FLOW_NEXT || !inImage(cfg, next) ||
+                (cfg->flags[next - cfg->start] & (CFG_CODE | CFG_LEADER)) != CFG_CODE) {
+                break;
+            }
+            pc = next;
+        }
+        unsigned short opcode = wordAt(cfg, pc);
+        unsigned int target = opcode & 0x0FFF;
+        block.last = pc;
+        block.end = next;
+        block.flow = info->flow;
+        switch (info->flow) {
+        case FLOW_NEXT:
+            addSucc(cfg, &block, next);
+            break;
+        case FLOW_JUMP:
+        case FLOW_INDIRECT:
+            addSucc(cfg, &block, target);
+            break;
+        case FLOW_CALL:
+            block.callee = target;
+            if (!inImage(cfg, target)) {
+                note(cfg, pc, ISSUE_OUTSIDE);
+            }
+            addSucc(cfg, &block, next);
+            break;
+        case FLOW_SKIP:
+            addSucc(cfg, &block, next);
+            addSucc(cfg, &block, next + opTable[decodeOp(cfg->isa, wordAt(cfg, next))].size);
+            break;
+        }
+        cfg->blocks = grow(cfg->blocks, &cfg->block_capacity, cfg->block_count, sizeof(struct CfgBlock));
+        cfg->blocks[cfg->block_count++] = block;
+        addr = next;
+    }
+}
+
+// each subroutine owns what it reaches without calling, unless a subroutine before it got there first
+static void findSubroutines(struct Cfg *cfg) {
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (cfg->blocks[i].start == cfg->start || (cfg->flags[cfg->blocks[i].start - cfg->start] & CFG_CALL)) {
+            cfg->subs = grow(cfg->subs, &cfg->sub_capacity, cfg->sub_count, sizeof(unsigned int));
+            cfg->subs[cfg->sub_count++] = cfg->blocks[i].start;
+            cfg->blocks[i].sub = cfg->sub_count - 1;
+        }
+    }
+    int *work = malloc((cfg->block_count + 1) * sizeof(int));
+    if (work == 0x00) {
+        abort();
+    }
+    for (int sub = 0; sub < cfg->sub_count; sub++) {
+        int pending = 0;
+        work[pending++] = cfgFindBlock(cfg, cfg->subs[sub]);
+        while (pending > 0) {
+            struct CfgBlock *block = &cfg->blocks[work[--pending]];
+            for (int i = 0; i < block->succ_count; i++) {
+                int next = cfgFindBlock(cfg, block->succ[i]);
+                if (next != -1 && cfg->blocks[next].start == block->succ[i] && cfg->blocks[next].sub == -1) {
+                    cfg->blocks[next].sub = sub;
+                    work[pending++] = next;
+                }
+            }
+        }
+    }
+    free(work);
+}
+
+static void store(struct Cfg *cfg, unsigned int site, bool known, unsigned int addr, unsigned int len) {
+    cfg->writes = grow(cfg->writes, &cfg->write_capacity, cfg->write_count, sizeof(struct CfgWrite));
+    cfg->writes[cfg->write_count++] = (struct CfgWrite){site, known ? addr : 0, known ? len : 0};
+    if (!known) {
+        return;
+    }
+    bool code = false;
+    for (unsigned int a = addr; a < addr + len; a++) {
+        if (inImage(cfg, a)) {
+            code |= (cfg->flags[a - cfg->start] & (CFG_CODE | CFG_OPERAND)) != 0;
+            cfg->flags[a - cfg->start] |= CFG_WRITTEN;
+        }
+    }
+    if (code) {
+        note(cfg, site, ISSUE_SELF_MODIFY);
+    }
+}
+
+// follows I through each block, it is unknown again at the start of the next
+static void findWrites(struct Cfg *cfg) {
+    for (int b = 0; b < cfg->block_count; b++) {
+        struct CfgBlock *block = &cfg->blocks[b];
+        bool known = false;
+        unsigned int i = 0;
+        for (unsigned int pc = block->start; pc < block->end;) {
+            unsigned short opcode = wordAt(cfg, pc);
+            enum Op op = decodeOp(cfg->isa, opcode);
+            unsigned int x = opcode >> 8 & 0xF, y = opcode >> 4 & 0xF;
+            switch (op) {
+            case OP_LD_I:
+                known = true;
+                i = opcode & 0x0FFF;
+                break;
+            case OP_LD_LONG:
+                known = true;
+                i = wordAt(cfg, pc + 2);
+                break;
+            case OP_LDHI:
+                known = true;
+                i = (opcode & 0xFF) << 16 | wordAt(cfg, pc + 2);
+                break;
+            case OP_ADD_I:
+            case OP_LD_F:
+            case OP_LD_HF:
+            case OP_LD_VX_MEM:
+                known = false;
+                break;
+            case OP_LD_BCD:
+                store(cfg, pc, known, i, 3);
+                break;
+            case OP_LD_MEM:
+                store(cfg, pc, known, i, x + 1);
+                // some profiles move I past what was stored
+                known = false;
+                break;
+            case OP_SAVE:
+                store(cfg, pc, known, i, (x > y ? x - y : y - x) + 1);
+                break;
+            default:
+                break;
+            }
+            pc += opTable[op].size;
+        }
+    }
+}
+
+static int byAddress(const void *a, const void *b) {
+    const struct CfgNote *x = a, *y = b;
+    if (x->addr != y->addr) {
+        return x->addr < y->addr ? -1 : 1;
+    }
+    return x->issue - y->issue;
+}
+
+/**
+ * @brief cfgBuild(cfg, data, size, isa) is used to recover the control-flow
+ * graph of a ROM image loaded at ROM_START: its reachable code, basic
+ * blocks, subroutines, BNNN sites, stores through I and anything that
+ * won't run as written
+ * @param cfg graph to fill, free it with cfgFree()
+ * @param data ROM image
+ * @param size size of the image
+ * @param isa ISA_* extensions to decode with, see profileIsa()
+ * @return void
+ */
+void cfgBuild(struct Cfg *cfg, const unsigned char *data, size_t size, unsigned int isa) {
+    memset(cfg, 0, sizeof(struct Cfg));
+    decodeInit();
+    cfg->data = data;
+    cfg->start = ROM_START;
+    cfg->end = ROM_START + size;
+    cfg->isa = isa;
+    cfg->flags = calloc(size + 1, 1);
+    if (cfg->flags == 0x00) {
+        abort();
+    }
+    struct Work work = {0x00, 0, 0};
+    walk(cfg, &work);
+    free(work.addrs);
+    cutBlocks(cfg);
+    findSubroutines(cfg);
+    findWrites(cfg);
+    // notes is 0x00 when there are none, which qsort() may not be given
+    if (cfg->note_count > 0) {
+        qsort(cfg->notes, cfg->note_count, sizeof(struct CfgNote), byAddress);
+    }
+}
+
+/**
+ * @brief cfgReach(cfg, data, size, isa, flags, work) is used to find only the
+ * reachable code of a ROM image loaded at ROM_START, in scratch the caller
+ * owns: cfg->flags is filled and nothing is allocated, so there are no
+ * blocks, subroutines, stores or notes and cfgFree() isn't needed
+ * @param cfg graph whose flags are filled
+ * @param data ROM image
+ * @param size size of the image
+ * @param isa ISA_* extensions to decode with, see profileIsa()
+ * @param flags size + 1 bytes, becomes cfg->flags
+ * @param work size + 1 entries for the branches waiting to be walked
+ * @return void
+ */
+void cfgReach(struct Cfg *cfg, const unsigned char *data, size_t size, unsigned int isa, unsigned char *flags,
+              unsigned int *work) {
+    memset(cfg, 0, sizeof(struct Cfg));
+    decodeInit();
+    cfg->data = data;
+    cfg->start = ROM_START;
+    cfg->end = ROM_START + size;
+    cfg->isa = isa;
+    cfg->reach_only = true;
+    cfg->flags = memset(flags, 0, size + 1);
+    struct Work pending = {work, 0, size + 1};
+    walk(cfg, &pending);
+}
+
+/**
+ * @brief cfgFindBlock(cfg, addr) is used to find the basic block holding an address
+ * @param cfg a built graph
+ * @param addr any byte of an instruction
+ * @return index in cfg->blocks, -1 if addr isn't reachable code
+ */
+int cfgFindBlock(struct Cfg *cfg, unsigned int addr) {
+    int lo = 0, hi = cfg->block_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (addr < cfg->blocks[mid].start) {
+            hi = mid - 1;
+        } else if (addr >= cfg->blocks[mid].end) {
+            lo = mid + 1;
+        } else {
+            return mid;
+        }
+    }
+    return -1;
+}
+
+int cfgCountIssues(struct Cfg *cfg, enum CfgIssue issue) {
+    int count = 0;
+    for (int i = 0; i < cfg->note_count; i++) {
+        count += cfg->notes[i].issue == issue;
+    }
+    return count;
+}
+
+const char *cfgIssueName(enum CfgIssue issue) {
+    return issue < ISSUES ? issue_names[issue] : "?";
+}
+
+// the edge to addr if it starts a block, branches into other instructions have no node to go to
+static void dotEdge(struct Cfg *cfg, FILE *out, unsigned int from, unsigned int addr, const char *style) {
+    int to = cfgFindBlock(cfg, addr);
+    if (to != -1 && cfg->blocks[to].start == addr) {
+        fprintf(out, "    b%X -> b%X%s;\n", from, addr, style);
+    }
+}
+
+/**
+ * @brief cfgWriteDot(cfg, out) is used to write the graph for Graphviz,
+ * one cluster per subroutine with the disassembly of each block; calls
+ * are dashed and BNNN edges dotted, blocks with issues are red
+ * @param cfg a built graph
+ * @param out file to write to
+ * @return void
+ */
+void cfgWriteDot(struct Cfg *cfg, FILE *out) {
+    char text[64];
+    fprintf(out, "digraph cfg {\n    node [shape=box, fontname=\"monospace\"];\n");
+    // blocks no subroutine reaches go outside the clusters, in case there are any
+    for (int sub = -1; sub < cfg->sub_count; sub++) {
+        if (sub >= 0) {
+            fprintf(out, "    subgraph cluster_%X {\n        label=\"%s%03X\";\n", cfg->subs[sub],
+                    sub ? "sub_" : "start_", cfg->subs[sub]);
+        }
+        for (int b = 0; b < cfg->block_count; b++) {
+            struct CfgBlock *block = &cfg->blocks[b];
+            if (block->sub != sub) {
+                continue;
+            }
+            bool issues = false;
+            fprintf(out, "        b%X [label=\"", block->start);
+            for (unsigned int pc = block->start; pc < block->end;) {
+                unsigned short opcode = wordAt(cfg, pc);
+                enum Op op = decodeOp(cfg->isa, opcode);
+                formatOp(text, sizeof(text), opcode, op, wordAt(cfg, pc + 2), 0x00);
+                fprintf(out, "%04X  %s\\l", pc, text);
+                pc += opTable[op].size;
+            }
+            for (int i = 0; i < cfg->note_count; i++) {
+                issues |= cfg->notes[i].addr >= block->start && cfg->notes[i].addr < block->end;
+            }
+            fprintf(out, "\"%s];\n", issues ? ", color=red" : "");
+        }
+        if (sub >= 0) {
+            fprintf(out, "    }\n");
+        }
+    }
+    for (int b = 0; b < cfg->block_count; b++) {
+        struct CfgBlock *block = &cfg->blocks[b];
+        for (int i = 0; i < block->succ_count; i++) {
+            dotEdge(cfg, out, block->start, block->succ[i], block->flow == FLOW_INDIRECT ? " [style=dotted]" : "");
+        }
+        if (block->flow == FLOW_CALL) {
+            dotEdge(cfg, out, block->start, block->callee, " [style=dashed]");
+        }
+    }
+    fprintf(out, "}\n");
+}
+
+/**
+ * @brief cfgWriteJson(cfg, out) is used to write the graph as JSON, with
+ * addresses as numbers: blocks, subroutine entries, BNNN sites, stores
+ * and issues
+ * @param cfg a built graph
+ * @param out file to write to
+ * @return void
+ */
+void cfgWriteJson(struct Cfg *cfg, FILE *out) {
+    fprintf(out, "{\n  \"start\": %u,\n  \"end\": %u,\n  \"isa\": %u,\n  \"blocks\": [", cfg->start, cfg->end,
+            cfg->isa);
+    for (int b = 0; b < cfg->block_count; b++) {
+        struct CfgBlock *block = &cfg->blocks[b];
+        fprintf(out, "%s\n    {\"start\": %u, \"end\": %u, \"flow\": \"%s\", \"sub\": %d, \"succ\": [", b ? "," : "",
+                block->start, block->end, flow_names[block->flow], block->sub);
+        for (int i = 0; i < block->succ_count; i++) {
+            fprintf(out, "%s%u", i ? ", " : "", block->succ[i]);
+        }
+        fprintf(out, "]");
+        if (block->flow == FLOW_CALL) {
+            fprintf(out, ", \"callee\": %u", block->callee);
+        }
+        fprintf(out, "}");
+    }
+    fprintf(out, "\n  ],\n  \"subroutines\": [");
+    for (int i = 0; i < cfg->sub_count; i++) {
+        fprintf(out, "%s%u", i ? ", " : "", cfg->subs[i]);
+    }
+    fprintf(out, "],\n  \"indirect\": [");
+    for (int i = 0; i < cfg->indirect_count; i++) {
+        fprintf(out, "%s%u", i ? ", " : "", cfg->indirect[i]);
+    }
+    fprintf(out, "],\n  \"writes\": [");
+    for (int i = 0; i < cfg->write_count; i++) {
+        struct CfgWrite *write = &cfg->writes[i];
+        fprintf(out, "%s\n    {\"site\": %u, \"start\": %u, \"len\": %u}", i ? "," : "", write->site, write->start,
+                write->len);
+    }
+    fprintf(out, "\n  ],\n  \"issues\": [");
+    for (int i = 0; i < cfg->note_count; i++) {
+        struct CfgNote *note = &cfg->notes[i];
+        fprintf(out, "%s\n    {\"addr\": %u, \"opcode\": %u, \"issue\": \"%s\"}", i ? "," : "", note->addr,
+                note->opcode, issue_names[note->issue]);
+    }
+    fprintf(out, "\n  ]\n}\n");
+}
+
+void cfgFree(struct Cfg *cfg) {
+    free(cfg->flags);
+    free(cfg->blocks);
+    free(cfg->subs);
+    free(cfg->indirect);
+    free(cfg->writes);
+    free(cfg->notes);
+    memset(cfg, 0, sizeof(struct Cfg));
+}
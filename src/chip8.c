@@ -1,11 +1,19 @@
 #include "inc/chip8.h"
-#include "inc/SDL2/SDL.h"
+#include "inc/aot.h"
+#include "inc/hash.h"
+#include "inc/quirks.h"
 #include <assert.h>
 #include <memory.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <time.h>
+
+// build with -DCHIP8_TRACE to print every executed opcode
+#ifdef CHIP8_TRACE
+#define trace(...) printf(__VA_ARGS__)
+#else
+#define trace(...)
+#endif
 
 /*
     Main components of CHIP-8 :
@@ -71,11 +79,26 @@ const unsigned char fontSet[80] = {
     0xF0, 0x80, 0xF0, 0x80, 0x80  // F
 };
 
+// SUPER-CHIP 8x10 digits 0-9, used by FX30
+const unsigned char bigFontSet[100] = {
+    0x3C, 0x7E, 0xE7, 0xC3, 0xC3, 0xC3, 0xC3, 0xE7, 0x7E, 0x3C, // 0
+    0x18, 0x38, 0x58, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x3C, // 1
+    0x3E, 0x7F, 0xC3, 0x06, 0x0C, 0x18, 0x30, 0x60, 0xFF, 0xFF, // 2
+    0x3C, 0x7E, 0xC3, 0x03, 0x0E, 0x0E, 0x03, 0xC3, 0x7E, 0x3C, // 3
+    0x06, 0x0E, 0x1E, 0x36, 0x66, 0xC6, 0xFF, 0xFF, 0x06, 0x06, // 4
+    0xFF, 0xFF, 0xC0, 0xC0, 0xFC, 0xFE, 0x03, 0xC3, 0x7E, 0x3C, // 5
+    0x3E, 0x7C, 0xE0, 0xC0, 0xFC, 0xFE, 0xC3, 0xC3, 0x7E, 0x3C, // 6
+    0xFF, 0xFF, 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x60, 0x60, // 7
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7E, 0x7E, 0xC3, 0xC3, 0x7E, 0x3C, // 8
+    0x3C, 0x7E, 0xC3, 0xC3, 0x7F, 0x3F, 0x03, 0x03, 0x3E, 0x7C  // 9
+};
+
 // -----------CHIP-8 implementation--------------
 
 /**
  * @brief chInit(chip8) is used to load the fonts into the memory
- * it pupulates memory rooms from 0x00(0) to 0x4F(79)
+ * it pupulates memory rooms from 0x00(0) to 0x4F(79); the memory is
+ * allocated here, release it with chFree() before calling chInit() again
  * @param struct Chip8 *chip8
  * @return void
  */
@@ -83,359 +106,277 @@ void chInit(struct Chip8 *chip8) {
     // pupulates memory rooms from 0x00(0)to 0x4F(79)with font[] elements
     // rooms 0x4F to 0x200 are reserved for VM operations
     memset(chip8, 0, sizeof(struct Chip8));
+    decodeInit();
+    memResize(&chip8->memory, MEMORY_SIZE);
+    chip8->screen.planes = 1;
+    chip8->pitch = 64;
     int n = sizeof(fontSet);
     for (int i = 0; i < n; i++) {
         chip8->memory.memory[i] = fontSet[i];
     }
+    // the SUPER-CHIP digits follow right after, 0x50 to 0xB3
+    memcpy(&chip8->memory.memory[BIG_FONT_START], bigFontSet, sizeof(bigFontSet));
+}
+
+void chFree(struct Chip8 *chip8) {
+    memFree(&chip8->memory);
+    free(chip8->mega);
+    chip8->mega = 0x00;
 }
 
 /**
- * @brief loadROM(chip8, buf) is used to load the ROM program to the memory
- * starting from 0x200(512) to 0xFFF(4095), it pupulates the needed memory rooms
- * depending on the size/needs of the program
+ * @brief chLoad(chip8, buf) is used to load the ROM program to the memory
+ * starting from 0x200(512) up to the end of the profile's memory, the file
+ * is mapped read-only and handed to chLoadData()
  * @param chip8 chip8's memory
  * @param buf (read-only-memory) file to read from
- * @return void
+ * @return ROM_OK, or the reason the ROM could not be loaded (see romError())
+ */
+enum RomError chLoad(struct Chip8 *chip8, const char *buf) {
+    struct Rom rom;
+    enum RomError error = romOpen(&rom, buf);
+    if (error != ROM_OK) {
+        return error;
+    }
+    error = chLoadData(chip8, rom.data, rom.size);
+    romClose(&rom);
+    return error;
+}
+
+/**
+ * @brief chLoadData(chip8, data, size) is used to load a ROM that is already
+ * in memory with the quirk profile of the detected platform, see chLoadDataAs()
+ * @param chip8 chip8's memory
+ * @param data the ROM bytes
+ * @param size number of bytes
+ * @return ROM_OK, or the reason the ROM could not be loaded (see romError())
  */
-void chLoad(struct Chip8 *chip8, const char *buf) {
+enum RomError chLoadData(struct Chip8 *chip8, const unsigned char *data, size_t size) {
+    return chLoadDataAs(chip8, data, size, defaultProfile(detectPlatform(data, size)));
+}
 
-    FILE *ptr;
-    int i, c;
-    if ((ptr = fopen(buf, "r+")) == 0x00) {
-        printf("Error opening file\n");
+/**
+ * @brief chLoadDataAs(chip8, data, size, profile) is used to load a ROM that is
+ * already in memory with a profile the caller picked, it is copied and hashed
+ * into chip8->rom_hash in one pass
+ * @param chip8 chip8's memory
+ * @param data the ROM bytes
+ * @param size number of bytes
+ * @param profile enum Profile to run it with
+ * @return ROM_OK, or the reason the ROM could not be loaded (see romError())
+ */
+enum RomError chLoadDataAs(struct Chip8 *chip8, const unsigned char *data, size_t size, enum Profile profile) {
+    if (size == 0) {
+        return ROM_ERR_EMPTY;
     }
-    for (i = 0; (c = fgetc(ptr)) != EOF; i++) {
-        chip8->memory.memory[i + 0x200] = c;
-        // i + 0x200 guarantees that ROM is loaded beyound room 0x200
+    // a ROM that doesn't fit leaves the machine as it was
+    if (size > profileMemory(profile) - ROM_START) {
+        return ROM_ERR_TOO_LARGE;
     }
-    fclose(ptr);
-    chip8->registers.PC = 0x200;
+    chSetProfile(chip8, profile);
+    // ROM_START guarantees that ROM is loaded beyound room 0x200
+    chip8->rom_hash = hashCopy(&chip8->memory.memory[ROM_START], data, size);
+    chip8->aot = aotFind(chip8->rom_hash, chip8->profile);
+    chip8->registers.PC = ROM_START;
+    return ROM_OK;
 }
 
-static char chip8_wait_for_key_press(struct Chip8 *chip8) {
-    SDL_Event event;
-    while (SDL_WaitEvent(&event)) {
-        if (event.type != SDL_KEYDOWN)
-            continue;
-
-        char c = event.key.keysym.sym;
-        char chip8_key = mapKey(&chip8->keyboard, c);
-        if (chip8_key != -1) {
-            return chip8_key;
-        }
+/**
+ * @brief chSetProfile(chip8, profile) is used to select the interpreter
+ * that matches the quirks the ROM expects, and to size memory for it;
+ * the MegaChip framebuffer only exists while the MegaChip profile is selected,
+ * and a translation of the ROM (see inc/aot.h) is only used for its own profile
+ * @param chip8 chip8's state
+ * @param profile enum Profile
+ * @return void
+ */
+void chSetProfile(struct Chip8 *chip8, enum Profile profile) {
+    chip8->profile = profile < PROFILES ? profile : PROFILE_CHIP8;
+    memResize(&chip8->memory, profileMemory(chip8->profile));
+    if (chip8->profile != PROFILE_MEGACHIP) {
+        free(chip8->mega);
+        chip8->mega = 0x00;
+    } else if (chip8->mega == 0x00 && (chip8->mega = calloc(1, sizeof(struct Mega))) == 0x00) {
+        abort();
     }
+    chip8->aot = aotFind(chip8->rom_hash, chip8->profile);
+}
+
+/**
+ * @brief chSeed(chip8, seed) is used to seed the CXNN random number generator,
+ * the same seed and the same key presses always replay the same game
+ * @param chip8 chip8's state
+ * @param seed any value, 0 is mapped to 1 since xorshift can't leave 0
+ * @return void
+ */
+void chSeed(struct Chip8 *chip8, unsigned int seed) {
+    chip8->rng = seed ? seed : 1;
+}
+
+/**
+ * @brief chRandom(chip8) is used by CXNN, in the interpreters and in translated ROMs
+ * @param chip8 chip8's state
+ * @return the next byte of the seeded sequence
+ */
+unsigned char chRandom(struct Chip8 *chip8) {
+    // xorshift32
+    unsigned int x = chip8->rng;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    chip8->rng = x;
+    return x >> 24;
+}
 
-    return -1;
+#ifdef CHIP8_CHECKED
+// prints the instruction at pc that reached past the end of memory
+static void reportFault(struct Chip8 *chip8, unsigned short pc, unsigned short opcode) {
+    chip8->memory.faulted = false;
+    if (chip8->memory.violations <= CHECKED_REPORTS) {
+        printf("[checked] PC 0x%03X opcode 0x%04X: address 0x%X is past the end of memory\n", pc, opcode,
+               chip8->memory.fault);
+    }
 }
+#endif
+
+// one interpreter per quirk profile, see inc/interp.h, with the quirks of inc/quirks.h
+#define INTERP_EXEC execChip8
+#define INTERP_FRAME frameChip8
+#define QUIRK_SHIFT_VY PROFILE_CHIP8_SHIFT_VY
+#define QUIRK_INC_I PROFILE_CHIP8_INC_I
+#define QUIRK_JUMP_VX PROFILE_CHIP8_JUMP_VX
+#define QUIRK_CLIP PROFILE_CHIP8_CLIP
+#define HAS_SCHIP 0
+#define HAS_XOCHIP 0
+#define HAS_MEGACHIP 0
+#include "inc/interp.h"
+
+#define INTERP_EXEC execVip
+#define INTERP_FRAME frameVip
+#define QUIRK_SHIFT_VY PROFILE_VIP_SHIFT_VY
+#define QUIRK_INC_I PROFILE_VIP_INC_I
+#define QUIRK_JUMP_VX PROFILE_VIP_JUMP_VX
+#define QUIRK_CLIP PROFILE_VIP_CLIP
+#define HAS_SCHIP 0
+#define HAS_XOCHIP 0
+#define HAS_MEGACHIP 0
+#include "inc/interp.h"
+
+#define INTERP_EXEC execSchip
+#define INTERP_FRAME frameSchip
+#define QUIRK_SHIFT_VY PROFILE_SCHIP_SHIFT_VY
+#define QUIRK_INC_I PROFILE_SCHIP_INC_I
+#define QUIRK_JUMP_VX PROFILE_SCHIP_JUMP_VX
+#define QUIRK_CLIP PROFILE_SCHIP_CLIP
+#define HAS_SCHIP 1
+#define HAS_XOCHIP 0
+#define HAS_MEGACHIP 0
+#include "inc/interp.h"
+
+#define INTERP_EXEC execXochip
+#define INTERP_FRAME frameXochip
+#define QUIRK_SHIFT_VY PROFILE_XOCHIP_SHIFT_VY
+#define QUIRK_INC_I PROFILE_XOCHIP_INC_I
+#define QUIRK_JUMP_VX PROFILE_XOCHIP_JUMP_VX
+#define QUIRK_CLIP PROFILE_XOCHIP_CLIP
+#define HAS_SCHIP 1
+#define HAS_XOCHIP 1
+#define HAS_MEGACHIP 0
+#include "inc/interp.h"
+
+#define INTERP_EXEC execMegachip
+#define INTERP_FRAME frameMegachip
+#define QUIRK_SHIFT_VY PROFILE_MEGACHIP_SHIFT_VY
+#define QUIRK_INC_I PROFILE_MEGACHIP_INC_I
+#define QUIRK_JUMP_VX PROFILE_MEGACHIP_JUMP_VX
+#define QUIRK_CLIP PROFILE_MEGACHIP_CLIP
+#define HAS_SCHIP 1
+#define HAS_XOCHIP 0
+#define HAS_MEGACHIP 1
+#include "inc/interp.h"
+
+struct Interpreter {
+    void (*exec)(struct Chip8 *chip8, unsigned short opcode);
+    void (*frame)(struct Chip8 *chip8);
+};
+
+// indexed by enum Profile
+static const struct Interpreter interpreters[PROFILES] = {
+    {execChip8, frameChip8},
+    {execVip, frameVip},
+    {execSchip, frameSchip},
+    {execXochip, frameXochip},
+    {execMegachip, frameMegachip},
+};
 
 /**
  * @brief execOpcode(chip8, opcode) is used to execute the chip8 instruction
- * uses long nested switch statements to get and match the full opcode
+ * with the interpreter of the current profile, which switches on the
+ * instruction decodeOp() finds for the full opcode (see inc/interp.h)
  * @param chip8 chip8's memory
  * @param opcode the opcode which defines the instruction
  * @return void
  */
 void execOpcode(struct Chip8 *chip8, unsigned short opcode) {
+    interpreters[chip8->profile].exec(chip8, opcode);
+}
 
-    // https://en.wikipedia.org/wiki/CHIP-8
-    // https://tobiasvl.github.io/blog/write-a-chip-8-emulator/
-
-    // x and y = instructions like 5XY0
-    // X: The second nibble.
-    // Used to look up one of the 16 registers (VX)
-    // from V0 through VF.
-    unsigned char X = (opcode & 0x0F00) >> 8;
-    // Y: The third nibble.
-    // Also used to look up one of the 16 registers (VY)
-    // from V0 through VF.
-    unsigned char Y = (opcode & 0x00F0) >> 4;
-    // N: The fourth nibble. A 4-bit number.
-    unsigned char N = opcode & 0x000F;
-    // NN: The second byte (third and fourth nibbles).
-    // An 8-bit immediate number.
-    unsigned char NN = opcode & 0x00FF;
-    // NNN: The second, third and fourth nibbles.
-    // A 12-bit immediate memory address.
-    unsigned short NNN = opcode & 0x0FFF;
-
-    // bitwise AND the 1st nibble
-    // then swicth and match all values in that F place
-    switch (opcode & 0xF000) {
-    case 0x0000: {
-        // 0 is 1st nibble in more than one opcode
-        // swaitch on the opcode with the last two nibbles
-        switch (opcode & 0x00FF) {
-        // 00E0: Clears the screen
-        case 0x00E0: {
-            printf("0x%X: 00E0\n", opcode);
-            clearScreen(&chip8->screen);
-        } break;
-            // 00EE: Return from subroutine
-        case 0x00EE: {
-            printf("0x%X: 00EE\n", opcode);
-            chip8->registers.PC = stackPop(chip8);
-        } break;
-        default:
-            // printf("unknown opcode");
-            break;
-        }
-    } break;
-    // 1NNN: Jumps to address NNN
-    case 0x1000: {
-        printf("0x%X: 1NNN\n", opcode);
-        chip8->registers.PC = NNN;
-    } break;
-    // 2NNN: Calls subroutine at NNN
-    case 0x2000: {
-        printf("0x%X: 2NNN\n", opcode);
-        stackPush(chip8, chip8->registers.PC);
-        chip8->registers.PC = NNN;
-
-    } break;
-
-    // 3XNN: Skips the next instruction if Vx equals NN
-    case 0x3000: {
-        printf("0x%X: 3XNN\n", opcode);
-        if (chip8->registers.V[X] == NN) {
-            chip8->registers.PC += 2;
-        }
-    } break;
-    // 4XNN: Skips the next instruction if Vx !equal NN
-    case 0x4000: {
-        printf("0x%X: 4XNN\n", opcode);
-        if (chip8->registers.V[X] != NN) {
-            chip8->registers.PC += 2;
-        }
-    } break;
-
-    // 5XY0: Skips the next instruction if Vx equals Vy
-    case 0x5000: {
-        printf("0x%X: 5XY0\n", opcode);
-        if (chip8->registers.V[X] == chip8->registers.V[Y]) {
-            chip8->registers.PC += 2;
-        }
-    } break;
-
-    // 6XNN: Sets Vx to NN
-    case 0x6000: {
-        printf("0x%X: 6XNN\n", opcode);
-        chip8->registers.V[X] = NN;
-    } break;
-
-    // 7XNN: Adds NN to Vx
-    case 0x7000: {
-        printf("0x%X: 7XNN\n", opcode);
-        chip8->registers.V[X] += NN;
-    } break;
-
-    case 0x8000: {
-        switch (opcode & 0x000F) {
-        // 8XY0: Sets Vx to the value of Vy
-        case 0x0000: {
-            printf("0x%X: 8XY0\n", opcode);
-            chip8->registers.V[X] = chip8->registers.V[Y];
-        } break;
-
-        // 8XY1: Sets VX to VX or VY. (bitwise OR operation)
-        case 0x0001: {
-            printf("0x%X: 8XY1\n", opcode);
-            chip8->registers.V[X] = chip8->registers.V[X] | chip8->registers.V[Y];
-        } break;
-
-        // 8XY2: Sets VX to VX and VY. (bitwise AND operation)
-        case 0x0002: {
-            printf("0x%X: 8XY2\n", opcode);
-            chip8->registers.V[X] = chip8->registers.V[X] & chip8->registers.V[Y];
-        } break;
-
-        // 8XY3: Sets VX to VX xor VY (bitwise OR operation)
-        case 0x0003: {
-            printf("0x%X: 8XY3\n", opcode);
-            chip8->registers.V[X] = chip8->registers.V[X] ^ chip8->registers.V[Y];
-        } break;
-
-        // 8XY4: Adds VY to VX. VF is set to 1 when there's a carry,
-        // and to 0 when there is not.
-        case 0x0004: {
-            printf("0x%X: 8XY4\n", opcode);
-            unsigned short tmp = 0;
-            tmp = chip8->registers.V[X] + chip8->registers.V[Y];
-            chip8->registers.V[0x0F] = false;
-            if (tmp > 0xFF) {
-                chip8->registers.V[0x0F] = true;
-            }
-            chip8->registers.V[X] = tmp;
-        } break;
-
-        // 8XY5: VY is subtracted from VX. VF is set to 0 when there's a borrow,
-        // and 1 when there is not.
-        case 0x0005: {
-            printf("0x%X: 8XY5\n", opcode);
-            chip8->registers.V[0x0F] = false;
-            if (chip8->registers.V[X] > chip8->registers.V[Y]) {
-                chip8->registers.V[0x0F] = true;
-            }
-            chip8->registers.V[X] = chip8->registers.V[X] - chip8->registers.V[Y];
-        } break;
-
-        // 8XY6: Stores the least significant bit of VX in VF
-        // and then shifts VX to the right by 1
-        case 0x0006: {
-            printf("0x%X: 8XY6\n", opcode);
-            chip8->registers.V[0x0F] = chip8->registers.V[X] & 0x01;
-            chip8->registers.V[X] = chip8->registers.V[X] >> 1;
-        } break;
-
-        // 8XY7: Sets VX to VY minus VX. VF is set to 0 when there's a borrow,
-        // and 1 when there is not.
-        case 0x0007: {
-            printf("0x%X: 8XY7\n", opcode);
-            chip8->registers.V[0x0F] = chip8->registers.V[Y] > chip8->registers.V[X];
-            chip8->registers.V[X] = chip8->registers.V[Y] - chip8->registers.V[X];
-        } break;
-
-        // 8XYE: Stores the most significant bit of VX in VF
-        // and then shifts VX to the left by 1
-        case 0x000E: {
-            printf("0x%X: 8XYE\n", opcode);
-            chip8->registers.V[0x0F] = chip8->registers.V[X] & 0x01;
-            chip8->registers.V[X] = chip8->registers.V[X] << 1;
-        } break;
-        }
-    } break;
-
-    // 9XY0: Skips the next instruction if VX does not equal VY.
-    // (Usually the next instruction is a jump to skip a code block);
-    case 0x9000: {
-        printf("0x%X: 9XY0\n", opcode);
-        if (chip8->registers.V[X] != chip8->registers.V[Y]) {
-            chip8->registers.PC += 2;
-        }
-    } break;
-
-    // ANNN: Sets I to the address NNN.
-    case 0xA000: {
-        printf("0x%X: ANNN\n", opcode);
-        chip8->registers.I = NNN;
-    } break;
-
-    // BNNN: Jumps to the address NNN plus V0.
-    case 0xB000: {
-        printf("0x%X: BNNN\n", opcode);
-        chip8->registers.PC = NNN + chip8->registers.V[0x00];
-    } break;
-    // CXNN: Sets VX to the result of a bitwise and operation
-    // on a random number (Typically: 0 to 255) and NN.
-    // 0xFF == 255
-    case 0xC000: {
-        printf("0x%X: CXNN\n", opcode);
-        srand(clock());
-        chip8->registers.V[X] = (rand() % 0xFF) & NN;
-    } break;
-
-    // DXYN - DRW Vx, Vy, nibble. Draws sprite to the screen
-    // bool drawSprite(struct Screen *screen, int x, int y, const char *sprite, int num)
-    case 0xD000: {
-        printf("0x%X: DXYN\n", opcode);
-        const char *sprite = (const char *)&chip8->memory.memory[chip8->registers.I];
-        chip8->registers.V[0x0F] = drawSprite(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite, N);
-    } break;
-
-    // Keyboard operations
-    case 0xE000: {
-        switch (opcode & 0x00FF) {
-        // EX9E: Skips the next instruction if the key stored in VX is pressed (usually the next instruction is a jump
-        // to skip a code block).
-        case 0x009E: {
-            printf("0x%X: EX9E\n", opcode);
-            if (keyIsDown(&chip8->keyboard, chip8->registers.V[X])) {
-                chip8->registers.PC += 2;
-            }
-        } break;
-
-        // EXA1: Skips the next instruction if the key stored in VX is not pressed (usually the next instruction is a
-        // jump to skip a code block).
-        case 0x00A1: {
-            printf("0x%X: EXA1\n", opcode);
-            if (!keyIsDown(&chip8->keyboard, chip8->registers.V[X])) {
-                chip8->registers.PC += 2;
-            }
-        } break;
-        }
-    } break;
-
-    case 0xF000: {
-        switch (opcode & 0x00FF) {
-        // FX07: Sets VX to the value of the delay timer.
-        case 0x0007: {
-            printf("0x%X: EX07\n", opcode);
-            chip8->registers.V[X] = chip8->registers.delay_timer;
-        } break;
-        // FX0A: A key press is awaited, and then stored in VX
-        // (blocking operation, all instruction halted until next key event).
-        case 0x000A: {
-            printf("0x%X: FX0A\n", opcode);
-            char pressed_key = chip8_wait_for_key_press(chip8);
-            chip8->registers.V[X] = pressed_key;
-        } break;
-        // FX15: Sets the delay timer to VX.
-        case 0x0015: {
-            printf("0x%X: FX15\n", opcode);
-            chip8->registers.delay_timer = chip8->registers.V[X];
-        } break;
-
-        // FX18: Sets the sound timer to VX.
-        case 0x0018: {
-            printf("0x%X: FX18\n", opcode);
-            chip8->registers.sound_timer = chip8->registers.V[X];
-        } break;
-        // FX1E: Adds VX to I. VF is not affected
-        case 0x001E: {
-            printf("0x%X: FX1E\n", opcode);
-            chip8->registers.I += chip8->registers.V[X];
-        } break;
-
-        // FX29: Sets I to the location of the sprite for the character in VX.
-        // Characters 0-F (in hexadecimal) are represented by a 4x5 font.
-        case 0x0029: {
-            printf("0x%X: FX29\n", opcode);
-            chip8->registers.I = chip8->registers.V[X] * 5;
-        } break;
-
-        // FX33: Stores the binary-coded decimal representation of VX,
-        // with the hundreds digit in memory at location in I,
-        // the tens digit at location I + 1,
-        // and the ones digit at location I + 2.
-        case 0x0033: {
-            printf("0x%X: FX33\n", opcode);
-            unsigned char hundreds = chip8->registers.V[X] / 100;
-            unsigned char tens = chip8->registers.V[X] / 10 % 10;
-            unsigned char units = chip8->registers.V[X] % 10;
-            chip8->memory.memory[chip8->registers.I] = hundreds;
-            chip8->memory.memory[chip8->registers.I + 1] = tens;
-            chip8->memory.memory[chip8->registers.I + 2] = units;
-        } break;
+/**
+ * @brief chStep(chip8) is used to fetch, decode and execute the instruction at PC
+ * @param chip8 chip8's state
+ * @return void
+ */
+void chStep(struct Chip8 *chip8) {
+    unsigned short pc = chip8->registers.PC;
+    unsigned short opcode = mergeBytes(&chip8->memory, pc);
+    chip8->registers.PC += 2;
+    execOpcode(chip8, opcode);
+#ifdef CHIP8_CHECKED
+    if (chip8->memory.faulted) {
+        reportFault(chip8, pc, opcode);
+    }
+#endif
+    chip8->cycles++;
+}
 
-        // FX55: Stores from V0 to VX (including VX) in memory, starting at address I.
-        // The offset from I is increased by 1 for each value written,
-        // but I itself is left unmodified.
-        case 0x0055: {
-            printf("0x%X: FX55\n", opcode);
-            for (int i = 0; i <= X; i++) {
-                chip8->memory.memory[chip8->registers.I + i] = chip8->registers.V[i];
-            }
-        } break;
+/**
+ * @brief chTick(chip8) is used to count down both timers, called at 60 Hz
+ * @param chip8 chip8's state
+ * @return void
+ */
+void chTick(struct Chip8 *chip8) {
+    chip8->stats.timer_ticks += chip8->registers.delay_timer > 0 || chip8->registers.sound_timer > 0;
+    if (chip8->registers.delay_timer > 0) {
+        chip8->registers.delay_timer -= 1;
+    }
+    if (chip8->registers.sound_timer > 0) {
+        chip8->registers.sound_timer -= 1;
+    }
+    chip8->frames++;
+}
 
-        // FX65: Fills from V0 to VX (including VX) with values from memory, starting at address I.
-        // The offset from I is increased by 1 for each value read,
-        // but I itself is left unmodified.
-        case 0x0065: {
-            printf("0x%X: FX65\n", opcode);
-            for (int i = 0; i <= X; i++) {
-                chip8->registers.V[i] = getMemory(&chip8->memory, chip8->registers.I + i);
-            }
-        } break;
-        }
-    } break;
+/**
+ * @brief chFrame(chip8) is used to run one 60 Hz frame:
+ * CYCLES_PER_FRAME instructions followed by a timer tick,
+ * with the ROM's translation when it has one
+ * @param chip8 chip8's state
+ * @return void
+ */
+void chFrame(struct Chip8 *chip8) {
+    if (chip8->aot != 0x00) {
+        aotFrame(chip8);
+        return;
     }
+    interpreters[chip8->profile].frame(chip8);
+}
+
+/**
+ * @brief chScreenHash(chip8) is used to fingerprint what the machine shows,
+ * the MegaChip picture is included when the profile has one
+ * @param chip8 chip8's state
+ * @return 64-bit hash, equal to screenHash() on every other profile
+ */
+unsigned long long chScreenHash(struct Chip8 *chip8) {
+    unsigned long long hash = screenHash(&chip8->screen);
+    return chip8->mega != 0x00 ? megaHash(chip8->mega, hash) : hash;
 }
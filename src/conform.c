@@ -0,0 +1,205 @@
+#include "inc/chip8.h"
+#include "inc/hash.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+    Conformance check of the test ROMs. Each .ch8 file of the directory
+    runs headless, with no keys pressed and a pinned seed, for a fixed
+    number of cycles; its final state is written as text and compared with
+    the <name>.golden file next to it, which --update rewrites. The state
+    holds the registers, the stack, hashes of memory and of the screen, and
+    the screen itself so a failing diff shows what changed. Every ROM runs
+    in its own process, all at once.
+*/
+#define CONFORM_CYCLES 200000
+#define CONFORM_SEED 1
+#define MAX_ROMS 256
+// differing lines printed per ROM
+#define DIFF_LINES 8
+
+// pixel values 0 to 3, the XO-CHIP planes
+static const char pixels[] = ".#+*";
+
+static void writeState(struct Chip8 *chip8, const char *name, FILE *out) {
+    struct Registers *r = &chip8->registers;
+    fprintf(out, "rom %s\nprofile %s\nseed %d\ncycles %llu\nframes %lu\n", name, profileName(chip8->profile),
+            CONFORM_SEED, chip8->cycles, chip8->frames);
+    fprintf(out, "V");
+    for (int i = 0; i < DATA_REGISTERS; i++) {
+        fprintf(out, " %02X", r->V[i]);
+    }
+    fprintf(out, "\nI %04X\nPC %04X\nSP %02X\nDT %02X\nST %02X\nstack", r->I, r->PC, r->SP, r->delay_timer,
+            r->sound_timer);
+    for (int i = 0; i < STACK_SIZE; i++) {
+        fprintf(out, " %04X", chip8->stack.stack[i]);
+    }
+    fprintf(out, "\nmemory %016llx\nscreen %016llx\n", hashBytes(chip8->memory.memory, chip8->memory.size),
+            chScreenHash(chip8));
+    for (int y = 0; y < screenHeight(&chip8->screen); y++) {
+        for (int x = 0; x < screenWidth(&chip8->screen); x++) {
+            fputc(pixels[screenPixel(&chip8->screen, x, y) & 3], out);
+        }
+        fputc('\n', out);
+    }
+}
+
+static char *readFile(const char *path) {
+    FILE *in = fopen(path, "rb");
+    if (in == 0x00) {
+        return 0x00;
+    }
+    fseek(in, 0, SEEK_END);
+    long len = ftell(in);
+    fseek(in, 0, SEEK_SET);
+    char *text = malloc(len + 1);
+    if (text == 0x00) {
+        abort();
+    }
+    text[fread(text, 1, len, in)] = '\0';
+    fclose(in);
+    return text;
+}
+
+// prints the first lines that differ, both texts are consumed
+static void printDiff(char *expected, char *actual, FILE *out) {
+    char *e_save, *a_save;
+    char *e = strtok_r(expected, "\n", &e_save);
+    char *a = strtok_r(actual, "\n", &a_save);
+    int printed = 0;
+    for (int line = 1; (e != 0x00 || a != 0x00) && printed < DIFF_LINES; line++) {
+        if (e == 0x00 || a == 0x00 || strcmp(e, a) != 0) {
+            fprintf(out, "    line %d\n      - %s\n      + %s\n", line, e ? e : "(end)", a ? a : "(end)");
+            printed++;
+        }
+        e = e ? strtok_r(0x00, "\n", &e_save) : 0x00;
+        a = a ? strtok_r(0x00, "\n", &a_save) : 0x00;
+    }
+}
+
+/*
+    Runs one ROM and checks or writes its golden file, the report goes to
+    stdout in one piece. Returns 0 if it matches or was written, 1 if it
+    differs and -1 on errors.
+*/
+static int check(const char *dir, const char *name, bool update) {
+    static struct Chip8 chip8;
+    char path[4096], golden[4096];
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    snprintf(golden, sizeof(golden), "%.*s.golden", (int)(strlen(path) - 4), path);
+    chInit(&chip8);
+    enum RomError error = chLoad(&chip8, path);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", path, romError(error));
+        chFree(&chip8);
+        return -1;
+    }
+    chSeed(&chip8, CONFORM_SEED);
+    while (chip8.cycles < CONFORM_CYCLES) {
+        chFrame(&chip8);
+    }
+    char *actual;
+    size_t len;
+    FILE *state = open_memstream(&actual, &len);
+    writeState(&chip8, name, state);
+    fclose(state);
+    chFree(&chip8);
+
+    int result = 0;
+    char *report;
+    FILE *out = open_memstream(&report, &len);
+    if (update) {
+        FILE *file = fopen(golden, "w");
+        if (file == 0x00 || fputs(actual, file) == EOF || fclose(file) != 0) {
+            fprintf(out, "[Error] could not write %s\n", golden);
+            result = -1;
+        } else {
+            fprintf(out, "[OK] %s written\n", golden);
+        }
+    } else {
+        char *expected = readFile(golden);
+        if (expected == 0x00) {
+            fprintf(out, "[Error] %s has no golden file %s\n", path, golden);
+            result = -1;
+        } else if (strcmp(expected, actual) != 0) {
+            fprintf(out, "[Error] %s differs from %s\n", path, golden);
+            printDiff(expected, actual, out);
+            result = 1;
+        } else {
+            fprintf(out, "[OK] %s\n", path);
+        }
+        free(expected);
+    }
+    fclose(out);
+    fputs(report, stdout);
+    free(report);
+    free(actual);
+    return result;
+}
+
+static int byName(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// checks every test ROM of a directory against its golden state, in parallel
+int main(int argc, char **argv) {
+    if ((argc != 2 && argc != 3) || (argc == 3 && strcmp(argv[2], "--update") != 0)) {
+        printf("[Error] usage: ./chip8-conform <test rom dir> [--update]\n");
+        return -1;
+    }
+    bool update = argc == 3;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    DIR *d = opendir(argv[1]);
+    if (d == 0x00) {
+        printf("[Error] could not read %s\n", argv[1]);
+        return -1;
+    }
+    char *names[MAX_ROMS];
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != 0x00 && count < MAX_ROMS) {
+        size_t len = strlen(ent->d_name);
+        if (ent->d_name[0] != '.' && len > 4 && strcasecmp(ent->d_name + len - 4, ".ch8") == 0) {
+            names[count++] = strdup(ent->d_name);
+        }
+    }
+    closedir(d);
+    qsort(names, count, sizeof(char *), byName);
+
+    fflush(stdout);
+    pid_t pids[MAX_ROMS];
+    int results[MAX_ROMS];
+    for (int i = 0; i < count; i++) {
+        pids[i] = fork();
+        if (pids[i] == 0) {
+            int result = check(argv[1], names[i], update);
+            fflush(stdout);
+            _exit(result == 0 ? 0 : 1);
+        }
+        if (pids[i] == -1) {
+            // no more processes, this one runs here
+            results[i] = check(argv[1], names[i], update);
+        }
+    }
+    int passed = 0;
+    for (int i = 0; i < count; i++) {
+        int status;
+        if (pids[i] != -1) {
+            bool exited = waitpid(pids[i], &status, 0) != -1 && WIFEXITED(status);
+            results[i] = exited ? WEXITSTATUS(status) : -1;
+        }
+        passed += results[i] == 0;
+        free(names[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    printf("%d ROMs, %d passed, %d failed, %.2f ms\n", count, passed, count - passed, ms);
+    return passed == count ? 0 : 1;
+}
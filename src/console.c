@@ -0,0 +1,196 @@
+#include "inc/debugger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    The console front end of the debugger, a REPL on stdin. Addresses are
+    hexadecimal with or without 0x, counts are decimal.
+*/
+
+// bytes per line of mem
+#define DUMP_WIDTH 16
+
+static const char *help =
+    "  c, continue            run until a breakpoint, a watchpoint or F12\n"
+    "  s, step [n]            run n instructions, 1 by default\n"
+    "  r, regs                print the registers\n"
+    "  bt, stack              print the call stack\n"
+    "  x, mem <addr> [n]      dump n bytes of memory, 64 by default\n"
+    "  l, dis [addr] [n]      disassemble n instructions from addr, PC and 8 by default\n"
+    "  b, break <addr>        stop when PC reaches addr\n"
+    "  d, delete <addr>       remove the breakpoint at addr\n"
+    "  w, watch <addr> [n]    stop after a store to the n bytes at addr, 1 by default\n"
+    "  uw, unwatch <addr>     remove the watchpoint starting at addr\n"
+    "  i, info                list the breakpoints and watchpoints\n"
+    "  detach                 remove them all and continue\n"
+    "  q, quit                leave the emulator\n";
+
+// parses the next argument, or gives fallback if there is none; false if it isn't a number
+static bool argument(int base, unsigned long fallback, unsigned long *value) {
+    char *arg = strtok(0x00, " \t\n");
+    if (arg == 0x00) {
+        *value = fallback;
+        return true;
+    }
+    char *end;
+    *value = strtoul(arg, &end, base);
+    return *end == '\0';
+}
+
+static bool is(const char *command, const char *shorthand, const char *name) {
+    return strcmp(command, shorthand) == 0 || strcmp(command, name) == 0;
+}
+
+// prints the instruction at addr, returns its size
+static unsigned int printOp(struct Debugger *dbg, struct Chip8 *chip8, unsigned int addr) {
+    char text[64];
+    unsigned short opcode = mergeBytes(&chip8->memory, addr);
+    unsigned short operand = mergeBytes(&chip8->memory, addr + 2);
+    enum Op op = decodeOp(profileIsa(chip8->profile), opcode);
+    formatOp(text, sizeof(text), opcode, op, operand, 0x00);
+    const char *mark = addr == chip8->registers.PC ? "=>" : "  ";
+    if (opTable[op].size == 4) {
+        printf("%s%c%04X: %04X %04X  %s\n", mark, dbgIsBreak(dbg, addr) ? '*' : ' ', addr, opcode, operand, text);
+    } else {
+        printf("%s%c%04X: %04X       %s\n", mark, dbgIsBreak(dbg, addr) ? '*' : ' ', addr, opcode, text);
+    }
+    return opTable[op].size;
+}
+
+static void printRegisters(struct Chip8 *chip8) {
+    struct Registers *r = &chip8->registers;
+    for (int i = 0; i < DATA_REGISTERS; i++) {
+        printf("V%X=%02X%s", i, r->V[i], i % 8 == 7 ? "\n" : " ");
+    }
+    printf("I=%04X PC=%04X SP=%02X DT=%02X ST=%02X\n", r->I, r->PC, r->SP, r->delay_timer, r->sound_timer);
+    printf("cycles=%llu frames=%lu\n", chip8->cycles, chip8->frames);
+}
+
+// newest entry first, stackPush() keeps the newest at SP
+static void printStack(struct Chip8 *chip8) {
+    if (chip8->registers.SP == 0) {
+        printf("stack is empty\n");
+    }
+    for (int i = chip8->registers.SP; i > 0 && i > chip8->registers.SP - STACK_SIZE; i--) {
+        printf("#%-2d %04X\n", chip8->registers.SP - i, chip8->stack.stack[i & (STACK_SIZE - 1)]);
+    }
+}
+
+static void printMemory(struct Chip8 *chip8, unsigned int addr, unsigned int len) {
+    for (unsigned int line = 0; line < len; line += DUMP_WIDTH) {
+        printf("%04X:", (addr + line) & (chip8->memory.size - 1));
+        for (unsigned int i = line; i < line + DUMP_WIDTH && i < len; i++) {
+            printf(" %02X", getMemory(&chip8->memory, (addr + i) & (chip8->memory.size - 1)));
+        }
+        printf("\n");
+    }
+}
+
+static void printPoints(struct Debugger *dbg) {
+    printf("%d breakpoints, %d watchpoints\n", dbg->break_count, dbg->watch_count);
+    for (unsigned int addr = 0; addr < DBG_ADDRESSES; addr++) {
+        if (dbgIsBreak(dbg, addr)) {
+            printf("  break %04X\n", addr);
+        }
+    }
+    for (int i = 0; i < dbg->watch_count; i++) {
+        printf("  watch %04X-%04X\n", dbg->watches[i].start, dbg->watches[i].start + dbg->watches[i].len - 1);
+    }
+}
+
+static void printStop(struct Debugger *dbg, struct Chip8 *chip8) {
+    switch (dbg->reason) {
+    case STOP_BREAK:
+        printf("\nbreakpoint at %04X\n", chip8->registers.PC);
+        break;
+    case STOP_WATCH:
+        printf("\nwatchpoint: %04X written, now %02X\n", dbg->hit, getMemory(&chip8->memory, dbg->hit));
+        break;
+    case STOP_INTERRUPT:
+        printf("\nstopped, type help for the commands\n");
+        break;
+    default:
+        break;
+    }
+    printOp(dbg, chip8, chip8->registers.PC);
+}
+
+/**
+ * @brief dbgConsole(dbg, chip8) is used as the debugger's stop function in
+ * the SDL front end, it reads commands from stdin until one of them runs
+ * the machine again; end of input quits
+ * @param dbg the debugger
+ * @param chip8 chip8's state
+ * @return void
+ */
+void dbgConsole(struct Debugger *dbg, struct Chip8 *chip8) {
+    printStop(dbg, chip8);
+    char line[256];
+    while (1) {
+        printf("(chip8) ");
+        fflush(stdout);
+        if (fgets(line, sizeof(line), stdin) == 0x00) {
+            dbg->quit = true;
+            return;
+        }
+        char *command = strtok(line, " \t\n");
+        unsigned long addr, count;
+        if (command == 0x00) {
+            continue;
+        } else if (is(command, "c", "continue")) {
+            dbgContinue(dbg);
+            return;
+        } else if (is(command, "s", "step")) {
+            if (!argument(10, 1, &count) || count == 0) {
+                printf("usage: step [n]\n");
+                continue;
+            }
+            dbgStep(dbg, count);
+            return;
+        } else if (is(command, "r", "regs")) {
+            printRegisters(chip8);
+        } else if (is(command, "bt", "stack")) {
+            printStack(chip8);
+        } else if (is(command, "x", "mem")) {
+            if (!argument(16, chip8->registers.I, &addr) || !argument(10, 64, &count)) {
+                printf("usage: mem <addr> [n]\n");
+                continue;
+            }
+            printMemory(chip8, addr, count);
+        } else if (is(command, "l", "dis")) {
+            if (!argument(16, chip8->registers.PC, &addr) || !argument(10, 8, &count)) {
+                printf("usage: dis [addr] [n]\n");
+                continue;
+            }
+            for (unsigned long i = 0; i < count; i++) {
+                addr += printOp(dbg, chip8, addr & (chip8->memory.size - 1));
+            }
+        } else if (is(command, "b", "break") || is(command, "d", "delete")) {
+            bool on = command[0] == 'b';
+            if (!argument(16, ~0ul, &addr) || dbgBreak(dbg, addr, on) == -1) {
+                printf("usage: %s <addr>, below %X\n", on ? "break" : "delete", DBG_ADDRESSES);
+            }
+        } else if (is(command, "w", "watch")) {
+            if (!argument(16, ~0ul, &addr) || !argument(10, 1, &count) || dbgWatch(dbg, addr, count) == -1) {
+                printf("usage: watch <addr> [n], at most %d\n", DBG_WATCHES);
+            }
+        } else if (is(command, "uw", "unwatch")) {
+            if (!argument(16, ~0ul, &addr) || dbgUnwatch(dbg, addr) == -1) {
+                printf("usage: unwatch <addr> of a watchpoint\n");
+            }
+        } else if (is(command, "i", "info")) {
+            printPoints(dbg);
+        } else if (strcmp(command, "detach") == 0) {
+            dbgDetach(dbg);
+            return;
+        } else if (is(command, "q", "quit")) {
+            dbg->quit = true;
+            return;
+        } else if (is(command, "h", "help")) {
+            printf("%s", help);
+        } else {
+            printf("unknown command %s, type help for the commands\n", command);
+        }
+    }
+}
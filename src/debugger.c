@@ -0,0 +1,186 @@
+#include "inc/debugger.h"
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * @brief dbgInit(dbg, stop, data) is used to set up a debugger with no
+ * breakpoints or watchpoints, the machine runs until dbgInterrupt()
+ * @param dbg the debugger
+ * @param stop called each time the machine stops, such as dbgConsole()
+ * @param data kept in dbg->data for stop()
+ * @return void
+ */
+void dbgInit(struct Debugger *dbg, void (*stop)(struct Debugger *dbg, struct Chip8 *chip8), void *data) {
+    memset(dbg, 0, sizeof(*dbg));
+    dbg->stop = stop;
+    dbg->data = data;
+}
+
+/**
+ * @brief dbgBreak(dbg, addr, on) is used to set or clear the breakpoint at addr
+ * @return 0, or -1 if addr is past the first 4 KB
+ */
+int dbgBreak(struct Debugger *dbg, unsigned int addr, bool on) {
+    if (addr >= DBG_ADDRESSES) {
+        return -1;
+    }
+    if (dbgIsBreak(dbg, addr) != on) {
+        dbg->breakpoints[addr / 32] ^= 1u << (addr % 32);
+        dbg->break_count += on ? 1 : -1;
+    }
+    return 0;
+}
+
+// the breakpoint at addr is set
+bool dbgIsBreak(struct Debugger *dbg, unsigned int addr) {
+    return addr < DBG_ADDRESSES && (dbg->breakpoints[addr / 32] >> (addr % 32) & 1);
+}
+
+static void markPages(struct Debugger *dbg, unsigned int start, unsigned int len) {
+    for (unsigned int page = start / PAGE_SIZE; page <= (start + len - 1) / PAGE_SIZE; page++) {
+        dbg->watch_pages[page / 32] |= 1u << (page % 32);
+    }
+}
+
+/**
+ * @brief dbgWatch(dbg, start, len) is used to stop after every store to the
+ * len bytes at start
+ * @return 0, or -1 if the range is empty or out of memory, or DBG_WATCHES are set
+ */
+int dbgWatch(struct Debugger *dbg, unsigned int start, unsigned int len) {
+    if (len == 0 || start >= MEGA_MEMORY_SIZE || len > MEGA_MEMORY_SIZE - start || dbg->watch_count == DBG_WATCHES) {
+        return -1;
+    }
+    dbg->watches[dbg->watch_count++] = (struct DbgWatch){start, len};
+    markPages(dbg, start, len);
+    return 0;
+}
+
+/**
+ * @brief dbgUnwatch(dbg, start) is used to remove the watchpoint starting at start
+ * @return 0, or -1 if there is none
+ */
+int dbgUnwatch(struct Debugger *dbg, unsigned int start) {
+    int found = -1;
+    for (int i = 0; i < dbg->watch_count; i++) {
+        if (dbg->watches[i].start == start) {
+            found = i;
+            break;
+        }
+    }
+    if (found == -1) {
+        return -1;
+    }
+    dbg->watches[found] = dbg->watches[--dbg->watch_count];
+    // other watches may share the pages, so the mask is built again
+    memset(dbg->watch_pages, 0, sizeof(dbg->watch_pages));
+    for (int i = 0; i < dbg->watch_count; i++) {
+        markPages(dbg, dbg->watches[i].start, dbg->watches[i].len);
+    }
+    return 0;
+}
+
+// stops before the next instruction
+void dbgInterrupt(struct Debugger *dbg) {
+    dbg->stopped = true;
+    dbg->reason = STOP_INTERRUPT;
+}
+
+// runs count instructions, then stops
+void dbgStep(struct Debugger *dbg, unsigned long count) {
+    dbg->steps = count;
+}
+
+// runs until a breakpoint, a watchpoint or dbgInterrupt()
+void dbgContinue(struct Debugger *dbg) {
+    dbg->steps = 0;
+}
+
+// clears every breakpoint and watchpoint and runs on, dbgActive() turns false at the end of the frame
+void dbgDetach(struct Debugger *dbg) {
+    memset(dbg->breakpoints, 0, sizeof(dbg->breakpoints));
+    memset(dbg->watch_pages, 0, sizeof(dbg->watch_pages));
+    dbg->break_count = 0;
+    dbg->watch_count = 0;
+    dbg->steps = 0;
+}
+
+/*
+    Finds the first watched byte the instruction at PC is about to store to,
+    the same bytes interp.h writes for FX33, FX55 and 5XY2.
+*/
+static bool storesWatched(struct Debugger *dbg, struct Chip8 *chip8, unsigned int *hit) {
+    unsigned short opcode = mergeBytes(&chip8->memory, chip8->registers.PC);
+    unsigned int X = opcode >> 8 & 0xF;
+    unsigned int Y = opcode >> 4 & 0xF;
+    unsigned int len;
+    switch (decodeOp(profileIsa(chip8->profile), opcode)) {
+    case OP_LD_BCD:
+        len = 3;
+        break;
+    case OP_LD_MEM:
+        len = X + 1;
+        break;
+    case OP_SAVE:
+        len = abs((int)Y - (int)X) + 1;
+        break;
+    default:
+        return false;
+    }
+    for (unsigned int i = 0; i < len; i++) {
+        unsigned int addr = (chip8->registers.I + i) & (chip8->memory.size - 1);
+        unsigned int page = addr / PAGE_SIZE;
+        if ((dbg->watch_pages[page / 32] >> (page % 32) & 1) == 0) {
+            continue;
+        }
+        for (int w = 0; w < dbg->watch_count; w++) {
+            if (addr - dbg->watches[w].start < dbg->watches[w].len) {
+                *hit = addr;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief dbgFrame(dbg, chip8) is used in place of chFrame() while dbgActive():
+ * it runs what is left of the frame one instruction at a time, calling
+ * dbg->stop() whenever the machine stops, and ticks the timers at its end
+ * @param dbg the debugger
+ * @param chip8 chip8's state
+ * @return void, with the frame unfinished if dbg->stop() set dbg->quit
+ */
+void dbgFrame(struct Debugger *dbg, struct Chip8 *chip8) {
+    while (dbg->cycle < CYCLES_PER_FRAME) {
+        unsigned short pc = chip8->registers.PC;
+        if (!dbg->resumed && dbgIsBreak(dbg, pc)) {
+            dbg->stopped = true;
+            dbg->reason = STOP_BREAK;
+        }
+        if (dbg->stopped) {
+            dbg->stopped = false;
+            dbg->stop(dbg, chip8);
+            if (dbg->quit) {
+                return;
+            }
+            // stop() may have moved PC, check it again
+            dbg->resumed = chip8->registers.PC == pc;
+            continue;
+        }
+        dbg->resumed = false;
+        bool watched = dbg->watch_count > 0 && storesWatched(dbg, chip8, &dbg->hit);
+        chStep(chip8);
+        dbg->cycle++;
+        if (watched) {
+            dbg->stopped = true;
+            dbg->reason = STOP_WATCH;
+        }
+        if (dbg->steps > 0 && --dbg->steps == 0 && !dbg->stopped) {
+            dbg->stopped = true;
+            dbg->reason = STOP_STEP;
+        }
+    }
+    dbg->cycle = 0;
+    chTick(chip8);
+}
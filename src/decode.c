@@ -0,0 +1,178 @@
+#include "inc/decode.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+    Operands in the formats:
+        %x VX        %y VY        %n N        %m X as a number
+        %b #NN       %a NNN, or the label given to formatOp()
+        %l the 16-bit operand word, or the label     %L NN and the operand word
+        %w the whole opcode
+*/
+const struct OpInfo opTable[OPS] = {
+    [OP_UNKNOWN] = {0x0000, 0x0000, 0, FLOW_NEXT, 2, "DW #%w"},
+    [OP_SYS] = {0xF000, 0x0000, 0, FLOW_NEXT, 2, "SYS %a"},
+    [OP_CLS] = {0xFFFF, 0x00E0, 0, FLOW_NEXT, 2, "CLS"},
+    [OP_RET] = {0xFFFF, 0x00EE, 0, FLOW_RETURN, 2, "RET"},
+    [OP_SCD] = {0xFFF0, 0x00C0, ISA_SCHIP, FLOW_NEXT, 2, "SCD %n"},
+    [OP_SCU] = {0xFFF0, 0x00D0, ISA_XOCHIP, FLOW_NEXT, 2, "SCU %n"},
+    [OP_SCR] = {0xFFFF, 0x00FB, ISA_SCHIP, FLOW_NEXT, 2, "SCR"},
+    [OP_SCL] = {0xFFFF, 0x00FC, ISA_SCHIP, FLOW_NEXT, 2, "SCL"},
+    [OP_EXIT] = {0xFFFF, 0x00FD, ISA_SCHIP, FLOW_STOP, 2, "EXIT"},
+    [OP_LOW] = {0xFFFF, 0x00FE, ISA_SCHIP, FLOW_NEXT, 2, "LOW"},
+    [OP_HIGH] = {0xFFFF, 0x00FF, ISA_SCHIP, FLOW_NEXT, 2, "HIGH"},
+    [OP_MEGAOFF] = {0xFFFF, 0x0010, ISA_MEGACHIP, FLOW_NEXT, 2, "MEGAOFF"},
+    [OP_MEGAON] = {0xFFFF, 0x0011, ISA_MEGACHIP, FLOW_NEXT, 2, "MEGAON"},
+    [OP_SCRU] = {0xFFF0, 0x00B0, ISA_MEGACHIP, FLOW_NEXT, 2, "SCRU %n"},
+    [OP_LDHI] = {0xFF00, 0x0100, ISA_MEGACHIP, FLOW_NEXT, 4, "LDHI I, %L"},
+    [OP_LDPAL] = {0xFF00, 0x0200, ISA_MEGACHIP, FLOW_NEXT, 2, "LDPAL %b"},
+    [OP_SPRW] = {0xFF00, 0x0300, ISA_MEGACHIP, FLOW_NEXT, 2, "SPRW %b"},
+    [OP_SPRH] = {0xFF00, 0x0400, ISA_MEGACHIP, FLOW_NEXT, 2, "SPRH %b"},
+    [OP_ALPHA] = {0xFF00, 0x0500, ISA_MEGACHIP, FLOW_NEXT, 2, "ALPHA %b"},
+    [OP_DIGISND] = {0xFFF0, 0x0600, ISA_MEGACHIP, FLOW_NEXT, 2, "DIGISND %n"},
+    [OP_STOPSND] = {0xFFFF, 0x0700, ISA_MEGACHIP, FLOW_NEXT, 2, "STOPSND"},
+    [OP_BMODE] = {0xFFF0, 0x0800, ISA_MEGACHIP, FLOW_NEXT, 2, "BMODE %n"},
+    [OP_CCOL] = {0xFF00, 0x0900, ISA_MEGACHIP, FLOW_NEXT, 2, "CCOL %b"},
+    [OP_JP] = {0xF000, 0x1000, 0, FLOW_JUMP, 2, "JP %a"},
+    [OP_CALL] = {0xF000, 0x2000, 0, FLOW_CALL, 2, "CALL %a"},
+    [OP_SE_BYTE] = {0xF000, 0x3000, 0, FLOW_SKIP, 2, "SE %x, %b"},
+    [OP_SNE_BYTE] = {0xF000, 0x4000, 0, FLOW_SKIP, 2, "SNE %x, %b"},
+    [OP_SE_REG] = {0xF00F, 0x5000, 0, FLOW_SKIP, 2, "SE %x, %y"},
+    [OP_SAVE] = {0xF00F, 0x5002, ISA_XOCHIP, FLOW_NEXT, 2, "SAVE %x, %y"},
+    [OP_LOAD] = {0xF00F, 0x5003, ISA_XOCHIP, FLOW_NEXT, 2, "LOAD %x, %y"},
+    [OP_LD_BYTE] = {0xF000, 0x6000, 0, FLOW_NEXT, 2, "LD %x, %b"},
+    [OP_ADD_BYTE] = {0xF000, 0x7000, 0, FLOW_NEXT, 2, "ADD %x, %b"},
+    [OP_LD_REG] = {0xF00F, 0x8000, 0, FLOW_NEXT, 2, "LD %x, %y"},
+    [OP_OR] = {0xF00F, 0x8001, 0, FLOW_NEXT, 2, "OR %x, %y"},
+    [OP_AND] = {0xF00F, 0x8002, 0, FLOW_NEXT, 2, "AND %x, %y"},
+    [OP_XOR] = {0xF00F, 0x8003, 0, FLOW_NEXT, 2, "XOR %x, %y"},
+    [OP_ADD_REG] = {0xF00F, 0x8004, 0, FLOW_NEXT, 2, "ADD %x, %y"},
+    [OP_SUB] = {0xF00F, 0x8005, 0, FLOW_NEXT, 2, "SUB %x, %y"},
+    [OP_SHR] = {0xF00F, 0x8006, 0, FLOW_NEXT, 2, "SHR %x, %y"},
+    [OP_SUBN] = {0xF00F, 0x8007, 0, FLOW_NEXT, 2, "SUBN %x, %y"},
+    [OP_SHL] = {0xF00F, 0x800E, 0, FLOW_NEXT, 2, "SHL %x, %y"},
+    [OP_SNE_REG] = {0xF00F, 0x9000, 0, FLOW_SKIP, 2, "SNE %x, %y"},
+    [OP_LD_I] = {0xF000, 0xA000, 0, FLOW_NEXT, 2, "LD I, %a"},
+    [OP_JP_V0] = {0xF000, 0xB000, 0, FLOW_INDIRECT, 2, "JP V0, %a"},
+    [OP_RND] = {0xF000, 0xC000, 0, FLOW_NEXT, 2, "RND %x, %b"},
+    [OP_DRW] = {0xF000, 0xD000, 0, FLOW_NEXT, 2, "DRW %x, %y, %n"},
+    [OP_SKP] = {0xF0FF, 0xE09E, 0, FLOW_SKIP, 2, "SKP %x"},
+    [OP_SKNP] = {0xF0FF, 0xE0A1, 0, FLOW_SKIP, 2, "SKNP %x"},
+    [OP_LD_LONG] = {0xFFFF, 0xF000, ISA_XOCHIP, FLOW_NEXT, 4, "LD I, LONG %l"},
+    [OP_PLANE] = {0xF0FF, 0xF001, ISA_XOCHIP, FLOW_NEXT, 2, "PLANE %m"},
+    [OP_AUDIO] = {0xFFFF, 0xF002, ISA_XOCHIP, FLOW_NEXT, 2, "AUDIO"},
+    [OP_LD_VX_DT] = {0xF0FF, 0xF007, 0, FLOW_NEXT, 2, "LD %x, DT"},
+    [OP_LD_VX_K] = {0xF0FF, 0xF00A, 0, FLOW_NEXT, 2, "LD %x, K"},
+    [OP_LD_DT] = {0xF0FF, 0xF015, 0, FLOW_NEXT, 2, "LD DT, %x"},
+    [OP_LD_ST] = {0xF0FF, 0xF018, 0, FLOW_NEXT, 2, "LD ST, %x"},
+    [OP_ADD_I] = {0xF0FF, 0xF01E, 0, FLOW_NEXT, 2, "ADD I, %x"},
+    [OP_LD_F] = {0xF0FF, 0xF029, 0, FLOW_NEXT, 2, "LD F, %x"},
+    [OP_LD_HF] = {0xF0FF, 0xF030, ISA_SCHIP, FLOW_NEXT, 2, "LD HF, %x"},
+    [OP_LD_BCD] = {0xF0FF, 0xF033, 0, FLOW_NEXT, 2, "LD B, %x"},
+    [OP_PITCH] = {0xF0FF, 0xF03A, ISA_XOCHIP, FLOW_NEXT, 2, "PITCH %x"},
+    [OP_LD_MEM] = {0xF0FF, 0xF055, 0, FLOW_NEXT, 2, "LD [I], %x"},
+    [OP_LD_VX_MEM] = {0xF0FF, 0xF065, 0, FLOW_NEXT, 2, "LD %x, [I]"},
+    [OP_LD_R] = {0xF0FF, 0xF075, ISA_SCHIP, FLOW_NEXT, 2, "LD R, %x"},
+    [OP_LD_VX_R] = {0xF0FF, 0xF085, ISA_SCHIP, FLOW_NEXT, 2, "LD %x, R"},
+};
+
+unsigned char decodeTables[ISA_SETS][65536];
+
+/**
+ * @brief decodeInit() is used to expand opTable into decodeTables, once per
+ * process; an opcode matched by several entries gets the one with the most
+ * mask bits, so 00E0 wins over 0NNN and 5XY2 over 5XY0
+ * @return void
+ */
+void decodeInit(void) {
+    static bool done = false;
+    if (done) {
+        return;
+    }
+    for (int isa = 0; isa < ISA_SETS; isa++) {
+        for (int bits = 0; bits <= 16; bits++) {
+            for (int op = OP_UNKNOWN + 1; op < OPS; op++) {
+                const struct OpInfo *info = &opTable[op];
+                if (__builtin_popcount(info->mask) != bits || (info->isa & ~isa) != 0) {
+                    continue;
+                }
+                // every value of the bits outside the mask
+                unsigned int free = ~info->mask & 0xFFFF;
+                unsigned int bit = 0;
+                do {
+                    decodeTables[isa][info->match | bit] = op;
+                    bit = (bit - free) & free;
+                } while (bit != 0);
+            }
+        }
+    }
+    done = true;
+}
+
+/**
+ * @brief formatOp(buf, len, opcode, op, operand, label) is used to write an
+ * instruction in CHIPPER syntax, the way chip8-dis prints it
+ * @param buf output, always terminated
+ * @param len size of buf
+ * @param opcode the instruction
+ * @param op decodeOp() of opcode
+ * @param operand the word after opcode, used by 4-byte instructions
+ * @param label printed in place of the address operand, or 0x00 for the number
+ * @return the length of the text, as snprintf()
+ */
+int formatOp(char *buf, size_t len, unsigned short opcode, enum Op op, unsigned int operand, const char *label) {
+    const char *format = opTable[op < OPS ? op : OP_UNKNOWN].format;
+    size_t used = 0;
+    for (const char *c = format; *c != '\0'; c++) {
+        char text[16];
+        const char *piece = text;
+        if (*c != '%') {
+            text[0] = *c;
+            text[1] = '\0';
+        } else {
+            switch (*++c) {
+            case 'x':
+                snprintf(text, sizeof(text), "V%X", opcode >> 8 & 0xF);
+                break;
+            case 'y':
+                snprintf(text, sizeof(text), "V%X", opcode >> 4 & 0xF);
+                break;
+            case 'n':
+                snprintf(text, sizeof(text), "%d", opcode & 0xF);
+                break;
+            case 'm':
+                snprintf(text, sizeof(text), "%d", opcode >> 8 & 0xF);
+                break;
+            case 'b':
+                snprintf(text, sizeof(text), "#%02X", opcode & 0xFF);
+                break;
+            case 'a':
+                snprintf(text, sizeof(text), "#%03X", opcode & 0xFFF);
+                piece = label ? label : text;
+                break;
+            case 'l':
+                snprintf(text, sizeof(text), "#%04X", operand & 0xFFFF);
+                piece = label ? label : text;
+                break;
+            case 'L':
+                snprintf(text, sizeof(text), "#%06X", (opcode & 0xFF) << 16 | (operand & 0xFFFF));
+                break;
+            case 'w':
+                snprintf(text, sizeof(text), "%04X", opcode);
+                break;
+            default:
+                text[0] = '\0';
+                break;
+            }
+        }
+        for (; *piece != '\0'; piece++, used++) {
+            if (used + 1 < len) {
+                buf[used] = *piece;
+            }
+        }
+    }
+    if (len > 0) {
+        buf[used < len ? used : len - 1] = '\0';
+    }
+    return used;
+}
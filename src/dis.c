@@ -0,0 +1,114 @@
+#include "inc/cfg.h"
+#include "inc/decode.h"
+#include "inc/platform.h"
+#include "inc/rom.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+// bytes of data per DB line
+#define DB_WIDTH 8
+
+static unsigned short wordAt(struct Cfg *cfg, unsigned int addr) {
+    unsigned int hi = addr < cfg->end ? cfg->data[addr - cfg->start] : 0;
+    unsigned int lo = addr + 1 < cfg->end ? cfg->data[addr + 1 - cfg->start] : 0;
+    return hi << 8 | lo;
+}
+
+// the strongest reason names a label, labels inside an instruction can't be
+// printed so those references stay numeric
+static const char *labelName(struct Cfg *cfg, unsigned int addr, char *buf, size_t len) {
+    if (addr < cfg->start || addr >= cfg->end) {
+        return 0x00;
+    }
+    unsigned char flags = cfg->flags[addr - cfg->start];
+    if ((flags & (CFG_CALL | CFG_JUMP | CFG_DATA)) == 0 || (flags & CFG_OPERAND)) {
+        return 0x00;
+    }
+    const char *prefix = flags & CFG_CALL ? "sub_" : flags & CFG_JUMP ? "L" : "data_";
+    snprintf(buf, len, "%s%03X", prefix, addr);
+    return buf;
+}
+
+static void print(struct Cfg *cfg, FILE *out) {
+    char name[32], text[64];
+    unsigned int addr = cfg->start;
+    while (addr < cfg->end) {
+        unsigned int i = addr - cfg->start;
+        if (labelName(cfg, addr, name, sizeof(name)) != 0x00) {
+            fprintf(out, "%s:\n", name);
+        }
+        if (cfg->flags[i] & CFG_CODE) {
+            unsigned short opcode = wordAt(cfg, addr);
+            enum Op op = decodeOp(cfg->isa, opcode);
+            unsigned short operand = wordAt(cfg, addr + 2);
+            const char *label = 0x00;
+            if (op == OP_LD_LONG) {
+                label = labelName(cfg, operand, name, sizeof(name));
+            } else if (strstr(opTable[op].format, "%a") != 0x00) {
+                label = labelName(cfg, opcode & 0x0FFF, name, sizeof(name));
+            }
+            formatOp(text, sizeof(text), opcode, op, operand, label);
+            if (opTable[op].size == 4) {
+                fprintf(out, "    %-24s ; %04X: %04X %04X\n", text, addr, opcode, operand);
+            } else {
+                fprintf(out, "    %-24s ; %04X: %04X\n", text, addr, opcode);
+            }
+            addr += opTable[op].size;
+            continue;
+        }
+        // a run of data, cut at labels and code
+        fprintf(out, "    DB #%02X", cfg->data[i]);
+        unsigned int n = 1;
+        while (n < DB_WIDTH && addr + n < cfg->end && (cfg->flags[i + n] & (CFG_CODE | CFG_OPERAND)) == 0 &&
+               labelName(cfg, addr + n, name, sizeof(name)) == 0x00) {
+            fprintf(out, ", #%02X", cfg->data[i + n]);
+            n++;
+        }
+        fputc('\n', out);
+        addr += n;
+    }
+}
+
+// prints a labelled disassembly of a ROM in CHIPPER syntax
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 3) {
+        printf("[Error] usage: ./chip8-dis <rom file> [profile]\n");
+        return -1;
+    }
+    struct Rom rom;
+    enum RomError error = romOpen(&rom, argv[1]);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", argv[1], romError(error));
+        return -1;
+    }
+    enum Platform platform = detectPlatform(rom.data, rom.size);
+    int profile = defaultProfile(platform);
+    if (argc == 3 && (profile = profileFromName(argv[2])) == -1) {
+        printf("[Error] unknown profile %s\n", argv[2]);
+        romClose(&rom);
+        return -1;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    struct Cfg cfg;
+    cfgBuild(&cfg, rom.data, rom.size, profileIsa(profile));
+    unsigned int code = 0;
+    for (size_t i = 0; i < rom.size; i++) {
+        code += (cfg.flags[i] & (CFG_CODE | CFG_OPERAND)) != 0;
+    }
+    static char buffer[1 << 16];
+    setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    printf("; %s: %zu bytes, %s, %s profile\n", argv[1], rom.size, platformName(platform), profileName(profile));
+    printf("; %u bytes of code, %zu bytes of data\n\n", code, rom.size - code);
+    // data may leave instructions at odd addresses, which CHIPPER would pad
+    printf("option binary\nalign off\n\n");
+    print(&cfg, stdout);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    fflush(stdout);
+    fprintf(stderr, "%s: %u bytes of code, %.2f ms\n", argv[1], code, ms);
+    cfgFree(&cfg);
+    romClose(&rom);
+    return 0;
+}
@@ -0,0 +1,279 @@
+#include "inc/farm.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NS_PER_FRAME (1000000000LL / 60)
+
+// upper bounds of the frame time buckets in nanoseconds, the last bucket has none
+static const long long bounds[FARM_BUCKETS - 1] = {250,   500,    1000,   2500,   5000,    10000,
+                                                   25000, 50000, 100000, 250000, 1000000, NS_PER_FRAME};
+
+long long farmNow(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000000LL + t.tv_nsec;
+}
+
+// adds to a counter only the calling worker writes, a load and a store rather than a locked add
+static inline void bump(counter_t *counter, unsigned long long n) {
+    atomic_store_explicit(counter, atomic_load_explicit(counter, memory_order_relaxed) + n, memory_order_relaxed);
+}
+
+static unsigned long long load(counter_t *counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+// ROMs don't run past 00FD or a jump to itself, and FX0A waits for keys the farm never presses
+static bool isIdle(struct Chip8 *chip8) {
+    unsigned short opcode = mergeBytes(&chip8->memory, chip8->registers.PC);
+    return chip8->keyboard.waiting || opcode == 0x00FD || opcode == (0x1000 | (chip8->registers.PC & 0x0FFF));
+}
+
+static void runFrame(struct Worker *w, struct Instance *inst) {
+    struct Chip8 *chip8 = &inst->chip8;
+    unsigned long long cycles = chip8->cycles;
+    long long start = farmNow();
+    chFrame(chip8);
+    long long end = farmNow();
+    int bucket = 0;
+    while (bucket < FARM_BUCKETS - 1 && end - start > bounds[bucket]) {
+        bucket++;
+    }
+    bump(&w->buckets[inst->rom * FARM_BUCKETS + bucket], 1);
+    bump(&w->sum_ns[inst->rom], end - start);
+    bump(&w->instructions, chip8->cycles - cycles);
+    bump(&w->frames, 1);
+    atomic_store_explicit(&inst->last_frame, end, memory_order_relaxed);
+}
+
+static void *workerRun(void *arg) {
+    struct Worker *w = arg;
+    struct Farm *farm = w->farm;
+    while (!atomic_load_explicit(&farm->stop, memory_order_relaxed)) {
+        long long now = farmNow();
+        // every instance owes the frames since farm->start it has neither run nor dropped
+        unsigned long long due = (now - farm->start) / NS_PER_FRAME + 1;
+        unsigned long long queue = 0;
+        for (int i = w->id; i < farm->instance_count; i += farm->worker_count) {
+            struct Instance *inst = &farm->instances[i];
+            unsigned long long owed = due - inst->skipped - inst->chip8.frames;
+            if (owed > FARM_MAX_BEHIND) {
+                inst->skipped += owed - FARM_MAX_BEHIND;
+                bump(&w->dropped, owed - FARM_MAX_BEHIND);
+                owed = FARM_MAX_BEHIND;
+            }
+            // the frame of this tick isn't late yet
+            queue += owed > 0 ? owed - 1 : 0;
+        }
+        atomic_store_explicit(&w->queue, queue, memory_order_relaxed);
+        for (int i = w->id; i < farm->instance_count; i += farm->worker_count) {
+            struct Instance *inst = &farm->instances[i];
+            while (inst->skipped + inst->chip8.frames < due) {
+                runFrame(w, inst);
+            }
+            atomic_store_explicit(&inst->idle, isIdle(&inst->chip8), memory_order_relaxed);
+        }
+        // sleeps until the next frame is due
+        long long next = farm->start + (long long)due * NS_PER_FRAME;
+        struct timespec t = {next / 1000000000LL, next % 1000000000LL};
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, 0x00);
+    }
+    return 0x00;
+}
+
+// count zeroed counters on whole cache lines, which no other worker's counters share
+static counter_t *lineAlloc(size_t count) {
+    size_t size = (count * sizeof(counter_t) + FARM_CACHE_LINE - 1) / FARM_CACHE_LINE * FARM_CACHE_LINE;
+    counter_t *counters = aligned_alloc(FARM_CACHE_LINE, size);
+    if (counters == 0x00) {
+        abort();
+    }
+    memset(counters, 0, size);
+    return counters;
+}
+
+/**
+ * @brief farmInit(farm, paths, rom_count, instances, workers) is used to load the
+ * instances, ROM i % rom_count runs on instance i and instance i on worker i % workers
+ * @param farm the farm to set up, free it with farmFree()
+ * @param paths ROM files
+ * @param rom_count number of paths, at most FARM_MAX_ROMS
+ * @param instances number of machines
+ * @param workers number of threads, at most FARM_MAX_WORKERS
+ * @return 0, or -1 if a ROM could not be loaded
+ */
+int farmInit(struct Farm *farm, char **paths, int rom_count, int instances, int workers) {
+    memset(farm, 0, sizeof(struct Farm));
+    farm->rom_count = rom_count < FARM_MAX_ROMS ? rom_count : FARM_MAX_ROMS;
+    farm->worker_count = workers < FARM_MAX_WORKERS ? workers : FARM_MAX_WORKERS;
+    for (int r = 0; r < farm->rom_count; r++) {
+        // the file name up to the extension, without the characters a label would have to escape
+        const char *name = strrchr(paths[r], '/') != 0x00 ? strrchr(paths[r], '/') + 1 : paths[r];
+        size_t n = 0;
+        for (; name[n] != '\0' && name[n] != '.' && n + 1 < sizeof(farm->names[r]); n++) {
+            farm->names[r][n] = name[n] == '"' || name[n] == '\\' || name[n] == '\n' ? '_' : name[n];
+        }
+        farm->names[r][n] = '\0';
+    }
+    farm->instances = calloc(instances, sizeof(struct Instance));
+    if (farm->instances == 0x00) {
+        abort();
+    }
+    for (int i = 0; i < instances; i++) {
+        struct Instance *inst = &farm->instances[i];
+        inst->rom = i % farm->rom_count;
+        chInit(&inst->chip8);
+        enum RomError error = chLoad(&inst->chip8, paths[inst->rom]);
+        if (error != ROM_OK) {
+            printf("[Error] %s: %s\n", paths[inst->rom], romError(error));
+            chFree(&inst->chip8);
+            farm->instance_count = i;
+            farmFree(farm);
+            return -1;
+        }
+        chSeed(&inst->chip8, i + 1);
+        farm->instance_count = i + 1;
+    }
+    for (int w = 0; w < farm->worker_count; w++) {
+        struct Worker *worker = &farm->workers[w];
+        worker->farm = farm;
+        worker->id = w;
+        worker->buckets = lineAlloc(farm->rom_count * FARM_BUCKETS);
+        worker->sum_ns = lineAlloc(farm->rom_count);
+    }
+    return 0;
+}
+
+/**
+ * @brief farmStart(farm) is used to start the workers, frame 0 of every instance is due now
+ * @param farm an initialized farm
+ * @return 0, or -1 if a thread could not be created, the ones that were are stopped
+ */
+int farmStart(struct Farm *farm) {
+    farm->start = farm->scraped = farmNow();
+    for (int i = 0; i < farm->instance_count; i++) {
+        atomic_store_explicit(&farm->instances[i].last_frame, farm->start, memory_order_relaxed);
+    }
+    for (int w = 0; w < farm->worker_count; w++) {
+        if (pthread_create(&farm->workers[w].thread, 0x00, workerRun, &farm->workers[w]) != 0) {
+            printf("[Error] could not start worker %d\n", w);
+            atomic_store(&farm->stop, true);
+            for (int started = 0; started < w; started++) {
+                pthread_join(farm->workers[started].thread, 0x00);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief farmStop(farm) is used to stop the workers after the frame they are on,
+ * the counters stay readable
+ * @param farm a started farm
+ * @return void
+ */
+void farmStop(struct Farm *farm) {
+    atomic_store(&farm->stop, true);
+    for (int w = 0; w < farm->worker_count; w++) {
+        pthread_join(farm->workers[w].thread, 0x00);
+    }
+}
+
+void farmFree(struct Farm *farm) {
+    for (int i = 0; i < farm->instance_count; i++) {
+        chFree(&farm->instances[i].chip8);
+    }
+    free(farm->instances);
+    for (int w = 0; w < FARM_MAX_WORKERS; w++) {
+        free(farm->workers[w].buckets);
+        free(farm->workers[w].sum_ns);
+    }
+    memset(farm, 0, sizeof(struct Farm));
+}
+
+// a bucket bound in seconds, as Prometheus labels it
+static void formatBound(char *buf, size_t len, int bucket) {
+    if (bucket == FARM_BUCKETS - 1) {
+        snprintf(buf, len, "+Inf");
+    } else {
+        snprintf(buf, len, "%g", bounds[bucket] / 1e9);
+    }
+}
+
+/**
+ * @brief farmWriteMetrics(farm, out) is used to sum the workers' counters into
+ * the Prometheus text format, from any thread but one at a time; chip8_mips
+ * covers the time since the previous call
+ * @param farm a started farm
+ * @param out where to write
+ * @return 0, -1 if the output could not be written
+ */
+int farmWriteMetrics(struct Farm *farm, FILE *out) {
+    int workers = farm->worker_count;
+    unsigned long long instructions = 0, frames = 0, dropped = 0;
+    for (int w = 0; w < workers; w++) {
+        instructions += load(&farm->workers[w].instructions);
+        frames += load(&farm->workers[w].frames);
+        dropped += load(&farm->workers[w].dropped);
+    }
+    long long now = farmNow();
+    double mips = now > farm->scraped ? (instructions - farm->scraped_instructions) / ((now - farm->scraped) / 1e3) : 0;
+    farm->scraped = now;
+    farm->scraped_instructions = instructions;
+
+    int running = 0, idle = 0, stalled = 0;
+    for (int i = 0; i < farm->instance_count; i++) {
+        struct Instance *inst = &farm->instances[i];
+        if (now - atomic_load_explicit(&inst->last_frame, memory_order_relaxed) > FARM_STALL_NS) {
+            stalled++;
+        } else if (atomic_load_explicit(&inst->idle, memory_order_relaxed)) {
+            idle++;
+        } else {
+            running++;
+        }
+    }
+
+    fprintf(out, "# HELP chip8_instructions_total Instructions retired by every instance.\n"
+                 "# TYPE chip8_instructions_total counter\nchip8_instructions_total %llu\n",
+            instructions);
+    fprintf(out, "# HELP chip8_frames_total Frames run by every instance.\n"
+                 "# TYPE chip8_frames_total counter\nchip8_frames_total %llu\n",
+            frames);
+    fprintf(out, "# HELP chip8_frames_dropped_total Frames skipped by instances more than %d frames behind.\n"
+                 "# TYPE chip8_frames_dropped_total counter\nchip8_frames_dropped_total %llu\n",
+            FARM_MAX_BEHIND, dropped);
+    fprintf(out, "# HELP chip8_mips Million instructions per second over every instance since the last scrape.\n"
+                 "# TYPE chip8_mips gauge\nchip8_mips %.3f\n",
+            mips);
+    fprintf(out, "# HELP chip8_instances Instances by state, stalled ones have not finished a frame for %gs.\n"
+                 "# TYPE chip8_instances gauge\n",
+            FARM_STALL_NS / 1e9);
+    fprintf(out, "chip8_instances{state=\"running\"} %d\nchip8_instances{state=\"idle\"} %d\n", running, idle);
+    fprintf(out, "chip8_instances{state=\"stalled\"} %d\n", stalled);
+    fprintf(out, "# HELP chip8_worker_queue_depth Frames overdue on the worker's instances when it last looked.\n"
+                 "# TYPE chip8_worker_queue_depth gauge\n");
+    for (int w = 0; w < workers; w++) {
+        fprintf(out, "chip8_worker_queue_depth{worker=\"%d\"} %llu\n", w, load(&farm->workers[w].queue));
+    }
+    fprintf(out, "# HELP chip8_frame_seconds Time to run one frame, by ROM.\n"
+                 "# TYPE chip8_frame_seconds histogram\n");
+    for (int r = 0; r < farm->rom_count; r++) {
+        unsigned long long count = 0, sum_ns = 0;
+        for (int w = 0; w < workers; w++) {
+            sum_ns += load(&farm->workers[w].sum_ns[r]);
+        }
+        for (int b = 0; b < FARM_BUCKETS; b++) {
+            for (int w = 0; w < workers; w++) {
+                count += load(&farm->workers[w].buckets[r * FARM_BUCKETS + b]);
+            }
+            char le[32];
+            formatBound(le, sizeof(le), b);
+            fprintf(out, "chip8_frame_seconds_bucket{rom=\"%s\",le=\"%s\"} %llu\n", farm->names[r], le, count);
+        }
+        fprintf(out, "chip8_frame_seconds_sum{rom=\"%s\"} %.9f\n", farm->names[r], sum_ns / 1e9);
+        fprintf(out, "chip8_frame_seconds_count{rom=\"%s\"} %llu\n", farm->names[r], count);
+    }
+    return ferror(out) ? -1 : 0;
+}
@@ -0,0 +1,170 @@
+#include "inc/fork.h"
+#include <stdlib.h>
+#include <string.h>
+
+static struct Page *pageNew(const unsigned char *data) {
+    struct Page *page = malloc(sizeof(struct Page));
+    if (page == 0x00) {
+        abort();
+    }
+    page->refs = 1;
+    memcpy(page->data, data, PAGE_SIZE);
+    return page;
+}
+
+static void pageRelease(struct Page *page) {
+    if (page != 0x00 && --page->refs == 0) {
+        free(page);
+    }
+}
+
+// makes *slot a copy of mega, or frees it if mega is 0x00
+static void megaCopy(struct Mega **slot, const struct Mega *mega) {
+    if (mega == 0x00) {
+        free(*slot);
+        *slot = 0x00;
+        return;
+    }
+    if (*slot == 0x00 && (*slot = malloc(sizeof(struct Mega))) == 0x00) {
+        abort();
+    }
+    memcpy(*slot, mega, sizeof(struct Mega));
+}
+
+// makes *slot point to page, moving the reference
+static void pageAssign(struct Page **slot, struct Page *page) {
+    if (page != 0x00) {
+        page->refs++;
+    }
+    pageRelease(*slot);
+    *slot = page;
+}
+
+static struct Branch *branchNew(unsigned int count, const struct Mega *mega) {
+    struct Branch *branch = malloc(sizeof(struct Branch) + count * sizeof(struct Page *));
+    if (branch == 0x00) {
+        abort();
+    }
+    branch->count = count;
+    branch->mega = 0x00;
+    megaCopy(&branch->mega, mega);
+    return branch;
+}
+
+/**
+ * @brief forkRoot(chip8) is used to snapshot a running machine as the root of a search
+ * @param chip8 chip8's state, left untouched
+ * @return a new branch, free it with forkRelease()
+ */
+struct Branch *forkRoot(struct Chip8 *chip8) {
+    struct Branch *branch = branchNew(memPages(&chip8->memory), chip8->mega);
+    for (unsigned int i = 0; i < branch->count; i++) {
+        branch->pages[i] = pageNew(&chip8->memory.memory[i * PAGE_SIZE]);
+    }
+    memcpy(branch->machine, &chip8->stack, FORK_MACHINE_SIZE);
+    return branch;
+}
+
+/**
+ * @brief forkBranch(parent) is used to fork a child that shares every page with its parent
+ * @param parent the branch to fork
+ * @return a new branch, free it with forkRelease()
+ */
+struct Branch *forkBranch(struct Branch *parent) {
+    struct Branch *branch = branchNew(parent->count, parent->mega);
+    for (unsigned int i = 0; i < branch->count; i++) {
+        branch->pages[i] = parent->pages[i];
+        branch->pages[i]->refs++;
+    }
+    memcpy(branch->machine, parent->machine, FORK_MACHINE_SIZE);
+    return branch;
+}
+
+/**
+ * @brief forkEnter(cursor, branch) is used to load a branch into the cursor's machine,
+ * siblings entered one after the other only copy the pages the previous run wrote
+ * @param cursor the machine to run on, zero it before first use
+ * @param branch the branch to run
+ * @return void
+ */
+void forkEnter(struct ForkCursor *cursor, struct Branch *branch) {
+    struct Memory *memory = &cursor->chip8.memory;
+    if (cursor->count != branch->count) {
+        // first use or a branch of another profile, nothing loaded can be reused
+        forkCursorFree(cursor);
+        cursor->loaded = calloc(branch->count, sizeof(struct Page *));
+        if (cursor->loaded == 0x00) {
+            abort();
+        }
+        cursor->count = branch->count;
+        memResize(memory, branch->count * PAGE_SIZE);
+    }
+    // 32 pages at a time, MegaChip has 131072 and a run only writes a few
+    for (unsigned int first = 0; first < branch->count; first += 32) {
+        unsigned int n = branch->count - first < 32 ? branch->count - first : 32;
+        unsigned int dirty = memory->dirty[first / 32];
+        if (dirty == 0 && memcmp(&cursor->loaded[first], &branch->pages[first], n * sizeof(struct Page *)) == 0) {
+            continue;
+        }
+        for (unsigned int i = first; i < first + n; i++) {
+            if (cursor->loaded[i] != branch->pages[i] || (dirty >> (i - first) & 1)) {
+                memcpy(&memory->memory[i * PAGE_SIZE], branch->pages[i]->data, PAGE_SIZE);
+                pageAssign(&cursor->loaded[i], branch->pages[i]);
+            }
+        }
+    }
+    clearDirty(memory);
+    memcpy(&cursor->chip8.stack, branch->machine, FORK_MACHINE_SIZE);
+    megaCopy(&cursor->chip8.mega, branch->mega);
+}
+
+/**
+ * @brief forkLeave(cursor, branch) is used to store the cursor's machine back into
+ * the branch it was entered with; pages written during the run are copied,
+ * every other page stays shared
+ * @param cursor the machine the branch ran on
+ * @param branch the branch passed to forkEnter()
+ * @return void
+ */
+void forkLeave(struct ForkCursor *cursor, struct Branch *branch) {
+    struct Memory *memory = &cursor->chip8.memory;
+    // a word of dirty bits at a time, MegaChip has 131072 pages
+    for (unsigned int word = 0; word < (branch->count + 31) / 32; word++) {
+        for (unsigned int bits = memory->dirty[word]; bits != 0; bits &= bits - 1) {
+            unsigned int i = word * 32 + __builtin_ctz(bits);
+            struct Page *page = pageNew(&memory->memory[i * PAGE_SIZE]);
+            pageRelease(branch->pages[i]);
+            branch->pages[i] = page;
+            pageAssign(&cursor->loaded[i], page);
+        }
+    }
+    clearDirty(memory);
+    memcpy(branch->machine, &cursor->chip8.stack, FORK_MACHINE_SIZE);
+    megaCopy(&branch->mega, cursor->chip8.mega);
+}
+
+/**
+ * @brief forkRelease(branch) is used to free a branch along with any pages no
+ * other branch shares, branches forked from it keep their own references
+ * @param branch the branch to release
+ * @return void
+ */
+void forkRelease(struct Branch *branch) {
+    for (unsigned int i = 0; i < branch->count; i++) {
+        pageRelease(branch->pages[i]);
+    }
+    free(branch->mega);
+    free(branch);
+}
+
+void forkCursorFree(struct ForkCursor *cursor) {
+    for (unsigned int i = 0; i < cursor->count; i++) {
+        pageAssign(&cursor->loaded[i], 0x00);
+    }
+    free(cursor->loaded);
+    free(cursor->chip8.mega);
+    memFree(&cursor->chip8.memory);
+    cursor->chip8.mega = 0x00;
+    cursor->loaded = 0x00;
+    cursor->count = 0;
+}
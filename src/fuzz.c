@@ -0,0 +1,493 @@
+#include "inc/aot.h"
+#include "inc/debugger.h"
+#include "inc/fork.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+    Differential fuzzing of the execution engines. Each case is a random
+    program with a random machine state, or a translated ROM (see
+    inc/aot.h) with a random state, and random keys for every frame. It
+    runs on the reference, execOpcode() one instruction at a time, and on
+    each engine in engines[], and the whole machine is compared after
+    every frame. A case that diverges is minimized, by cutting the frames
+    after the divergence and replacing every instruction and key press
+    that isn't needed to reproduce it, and printed with its seed.
+
+    Every FORK_EVERY-th case also runs on FORK_SIBLINGS branches forked
+    from one root (see inc/fork.h), entered on a single ForkCursor in turn
+    for every frame, each against a machine running the same frames
+    directly. The siblings start with different V0 and press the case's
+    keys from different frames, so they store to different pages, and
+    halfway they are forked again. At the end the root must still hold
+    the machine it was forked from.
+*/
+#define PROGRAM_WORDS 64
+#define PROGRAM_FRAMES 64
+#define ROM_FRAMES 600
+// what minimization puts in place of an instruction, 8000 is LD V0, V0
+#define FILLER 0x8000
+#define FORK_SIBLINGS 4
+// one case in this many also runs on forks, a MegaChip cursor looks at 131072 pages per frame
+#define FORK_EVERY 64
+
+struct Case {
+    unsigned int seed;        // what generated it, ./chip8-fuzz 1 <seed> runs it again
+    unsigned char profile;    // enum Profile
+    const struct AotRom *aot; // the ROM it runs, 0x00 to run program
+    unsigned short program[PROGRAM_WORDS];
+    unsigned char V[DATA_REGISTERS];
+    unsigned int I;
+    unsigned char delay_timer;
+    unsigned char sound_timer;
+    unsigned char SP;
+    unsigned short stack[STACK_SIZE];
+    unsigned int rng;
+    unsigned short keys[ROM_FRAMES]; // keys held during each frame, one bit per key
+    int frames;
+};
+
+struct Engine {
+    const char *name;
+    void (*frame)(struct Chip8 *chip8);
+    bool translated; // only runs the cases with a translation
+};
+
+static struct Debugger debugger;
+// what the forks of every case run on
+static struct ForkCursor cursor;
+
+// the reference, what chStep() does without its hooks
+static void referenceFrame(struct Chip8 *chip8) {
+    for (int i = 0; i < CYCLES_PER_FRAME; i++) {
+        unsigned short opcode = mergeBytes(&chip8->memory, chip8->registers.PC);
+        chip8->registers.PC += 2;
+        execOpcode(chip8, opcode);
+        chip8->cycles++;
+    }
+    chTick(chip8);
+}
+
+// the profile's interpreter loop, or the translation when the machine has one
+static void chipFrame(struct Chip8 *chip8) {
+    chFrame(chip8);
+}
+
+// every instruction stopped at and every store watched, the stop function only continues
+static void debuggerFrame(struct Chip8 *chip8) {
+    dbgFrame(&debugger, chip8);
+}
+
+static void keepRunning(struct Debugger *dbg, struct Chip8 *chip8) {
+    (void)chip8;
+    dbgContinue(dbg);
+}
+
+static const struct Engine engines[] = {
+    {"interpreter loop", chipFrame, false},
+    {"debugger", debuggerFrame, false},
+    {"translation", chipFrame, true},
+};
+
+static unsigned int next(unsigned int *state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// an instruction of the profile, with jumps, calls and ANNN mostly pointing into the program
+static unsigned short randomOp(unsigned int *state, unsigned int isa) {
+    enum Op op;
+    do {
+        op = next(state) % OPS;
+    } while ((opTable[op].isa & ~isa) != 0);
+    unsigned short opcode = opTable[op].match | (next(state) & ~opTable[op].mask);
+    if ((op == OP_JP || op == OP_CALL || op == OP_JP_V0 || op == OP_LD_I) && next(state) % 8 != 0) {
+        opcode = (opcode & 0xF000) | (ROM_START + next(state) % PROGRAM_WORDS * 2);
+    }
+    return opcode;
+}
+
+static void generate(struct Case *c, unsigned int seed) {
+    unsigned int state = seed != 0 ? seed : 1;
+    memset(c, 0, sizeof(*c));
+    c->seed = seed;
+    // one case in eight runs a translation, when there are any
+    int translations = 0;
+    while (aotTranslation(translations) != 0x00) {
+        translations++;
+    }
+    if (translations > 0 && next(&state) % 8 == 0) {
+        c->aot = aotTranslation(next(&state) % translations);
+        c->profile = c->aot->profile;
+        c->frames = ROM_FRAMES;
+    } else {
+        c->profile = next(&state) % PROFILES;
+        c->frames = PROGRAM_FRAMES;
+        for (int i = 0; i < PROGRAM_WORDS; i++) {
+            c->program[i] = randomOp(&state, profileIsa(c->profile));
+        }
+    }
+    for (int i = 0; i < DATA_REGISTERS; i++) {
+        c->V[i] = next(&state);
+    }
+    c->I = next(&state) % MEMORY_SIZE;
+    c->delay_timer = next(&state);
+    c->sound_timer = next(&state);
+    c->SP = next(&state) % (STACK_SIZE + 1);
+    for (int i = 0; i < STACK_SIZE; i++) {
+        c->stack[i] = ROM_START + next(&state) % PROGRAM_WORDS * 2;
+    }
+    c->rng = next(&state) | 1;
+    unsigned short keys = 0;
+    for (int i = 0; i < c->frames; i++) {
+        if (next(&state) % 8 == 0) {
+            keys ^= 1 << next(&state) % TOTAL_KEYS;
+        }
+        c->keys[i] = keys;
+    }
+}
+
+static void build(struct Chip8 *chip8, struct Case *c, const struct Engine *engine) {
+    chInit(chip8);
+    chSetProfile(chip8, c->profile);
+    if (c->aot != 0x00) {
+        memcpy(&chip8->memory.memory[ROM_START], c->aot->image, c->aot->size);
+    } else {
+        for (int i = 0; i < PROGRAM_WORDS; i++) {
+            chip8->memory.memory[ROM_START + i * 2] = c->program[i] >> 8;
+            chip8->memory.memory[ROM_START + i * 2 + 1] = c->program[i] & 0xFF;
+        }
+    }
+    struct Registers *r = &chip8->registers;
+    memcpy(r->V, c->V, sizeof(r->V));
+    r->I = c->I;
+    r->PC = ROM_START;
+    r->delay_timer = c->delay_timer;
+    r->sound_timer = c->sound_timer;
+    r->SP = c->SP;
+    memcpy(chip8->stack.stack, c->stack, sizeof(c->stack));
+    chip8->rng = c->rng;
+    chip8->aot = engine != 0x00 && engine->translated ? c->aot : 0x00;
+    clearDirty(&chip8->memory);
+}
+
+static void setKeys(struct Chip8 *chip8, unsigned short keys) {
+    for (int k = 0; k < TOTAL_KEYS; k++) {
+        bool down = keys >> k & 1;
+        if (keyIsDown(&chip8->keyboard, k) != down) {
+            if (down) {
+                keyDown(&chip8->keyboard, k);
+            } else {
+                keyUp(&chip8->keyboard, k);
+            }
+        }
+    }
+}
+
+// both machines start with the same memory, build() clears the dirty bits so only pages stored to can differ
+static bool memoryDiffers(struct Memory *a, struct Memory *b) {
+    if (a->size != b->size) {
+        return true;
+    }
+    for (int page = 0; page < memPages(a); page++) {
+        if ((a->dirty[page / 32] | b->dirty[page / 32]) == 0) {
+            page += 31;
+            continue;
+        }
+        unsigned int start = page * PAGE_SIZE;
+        if ((pageIsDirty(a, page) || pageIsDirty(b, page)) &&
+            memcmp(&a->memory[start], &b->memory[start], PAGE_SIZE) != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// names the first part of the machine that differs, or gives 0x00
+static const char *stateDiff(struct Chip8 *a, struct Chip8 *b) {
+    struct Registers *x = &a->registers, *y = &b->registers;
+    if (memcmp(x->V, y->V, sizeof(x->V)) != 0) {
+        return "V registers";
+    }
+    if (x->I != y->I || x->PC != y->PC || x->SP != y->SP) {
+        return x->I != y->I ? "I" : x->PC != y->PC ? "PC" : "SP";
+    }
+    if (x->delay_timer != y->delay_timer || x->sound_timer != y->sound_timer) {
+        return "timers";
+    }
+    if (memcmp(x->flags, y->flags, sizeof(x->flags)) != 0) {
+        return "RPL flags";
+    }
+    if (memcmp(a->stack.stack, b->stack.stack, sizeof(a->stack.stack)) != 0) {
+        return "stack";
+    }
+    if (memoryDiffers(&a->memory, &b->memory)) {
+        return "memory";
+    }
+    if (memcmp(a->screen.rows, b->screen.rows, sizeof(a->screen.rows)) != 0 || a->screen.planes != b->screen.planes ||
+        a->screen.hires != b->screen.hires) {
+        return "screen";
+    }
+    if ((a->mega == 0x00) != (b->mega == 0x00)) {
+        return "MegaChip state";
+    }
+    if (a->mega != 0x00) {
+        struct Mega *m = a->mega, *n = b->mega;
+        if (memcmp(m->pixels, n->pixels, sizeof(m->pixels)) != 0 || memcmp(m->front, n->front, sizeof(m->front)) != 0 ||
+            memcmp(m->palette, n->palette, sizeof(m->palette)) != 0 || m->sprite_width != n->sprite_width ||
+            m->sprite_height != n->sprite_height || m->collision != n->collision || m->blend != n->blend ||
+            m->alpha != n->alpha || m->enabled != n->enabled) {
+            return "MegaChip state";
+        }
+    }
+    if (a->keyboard.waiting != b->keyboard.waiting || a->keyboard.pressed != b->keyboard.pressed) {
+        return "FX0A state";
+    }
+    if (a->cycles != b->cycles || a->frames != b->frames) {
+        return "cycle count";
+    }
+    struct Stats *s = &a->stats, *t = &b->stats;
+    if (s->draws != t->draws || s->collisions != t->collisions || s->clears != t->clears ||
+        s->timer_ticks != t->timer_ticks || s->key_waits != t->key_waits || s->unknown != t->unknown ||
+        s->stack_high != t->stack_high) {
+        return "statistics";
+    }
+    if (a->rng != b->rng) {
+        return "random state";
+    }
+    if (memcmp(a->pattern, b->pattern, sizeof(a->pattern)) != 0 || a->pitch != b->pitch) {
+        return "audio";
+    }
+    return 0x00;
+}
+
+static struct Chip8 start, direct[FORK_SIBLINGS];
+
+// pages differ only where one of the direct runs stored, what the forks load and store comes from those runs
+static const char *forkDiff(struct Chip8 *a, struct Chip8 *b) {
+    if (a->memory.size != b->memory.size) {
+        return "memory";
+    }
+    for (int word = 0; word < (memPages(&a->memory) + 31) / 32; word++) {
+        unsigned int written = 0;
+        for (int s = 0; s < FORK_SIBLINGS; s++) {
+            written |= direct[s].memory.dirty[word];
+        }
+        for (; written != 0; written &= written - 1) {
+            unsigned int start = (word * 32 + __builtin_ctz(written)) * PAGE_SIZE;
+            if (memcmp(&a->memory.memory[start], &b->memory.memory[start], PAGE_SIZE) != 0) {
+                return "memory";
+            }
+        }
+    }
+    return stateDiff(a, b);
+}
+
+/*
+    Runs the case on forks of one root and directly. Returns the first
+    frame after which a sibling differs from its direct run, PROGRAM_FRAMES
+    or ROM_FRAMES when only the root changed, or -1.
+*/
+static int forkDiverges(struct Case *c, int *sibling, const char **what) {
+    struct Branch *branches[FORK_SIBLINGS];
+    build(&start, c, 0x00);
+    struct Branch *root = forkRoot(&start);
+    for (int s = 0; s < FORK_SIBLINGS; s++) {
+        build(&direct[s], c, 0x00);
+        direct[s].registers.V[0] += s;
+        branches[s] = forkBranch(root);
+    }
+    int frame = -1;
+    for (int i = 0; i < c->frames && frame == -1; i++) {
+        for (int s = 0; s < FORK_SIBLINGS && frame == -1; s++) {
+            unsigned short keys = c->keys[(i + s * 7) % c->frames];
+            if (i == c->frames / 2) {
+                struct Branch *child = forkBranch(branches[s]);
+                forkRelease(branches[s]);
+                branches[s] = child;
+            }
+            forkEnter(&cursor, branches[s]);
+            if (i == 0) {
+                cursor.chip8.registers.V[0] += s;
+            }
+            setKeys(&cursor.chip8, keys);
+            chFrame(&cursor.chip8);
+            forkLeave(&cursor, branches[s]);
+            setKeys(&direct[s], keys);
+            chFrame(&direct[s]);
+            if ((*what = forkDiff(&cursor.chip8, &direct[s])) != 0x00) {
+                frame = i;
+                *sibling = s;
+            }
+        }
+    }
+    if (frame == -1) {
+        forkEnter(&cursor, root);
+        if ((*what = forkDiff(&cursor.chip8, &start)) != 0x00) {
+            frame = c->frames;
+            *sibling = -1;
+        }
+    }
+    for (int s = 0; s < FORK_SIBLINGS; s++) {
+        forkRelease(branches[s]);
+        chFree(&direct[s]);
+    }
+    forkRelease(root);
+    chFree(&start);
+    return frame;
+}
+
+/*
+    Runs the case on the reference and on engine, comparing after every
+    frame. Returns the first frame after which they differ, or -1.
+*/
+static int diverges(struct Case *c, const struct Engine *engine, const char **what) {
+    static struct Chip8 reference, machine;
+    // nothing of the last case is left for the debugger to resume from
+    debugger.stopped = debugger.resumed = false;
+    build(&reference, c, 0x00);
+    build(&machine, c, engine);
+    int frame = -1;
+    for (int i = 0; i < c->frames && frame == -1; i++) {
+        setKeys(&reference, c->keys[i]);
+        setKeys(&machine, c->keys[i]);
+        referenceFrame(&reference);
+        engine->frame(&machine);
+        if ((*what = stateDiff(&reference, &machine)) != 0x00) {
+            frame = i;
+        }
+    }
+    chFree(&reference);
+    chFree(&machine);
+    return frame;
+}
+
+// takes away whatever the divergence doesn't need
+static void minimize(struct Case *c, const struct Engine *engine) {
+    const char *what;
+    c->frames = diverges(c, engine, &what) + 1;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < PROGRAM_WORDS && c->aot == 0x00; i++) {
+            unsigned short kept = c->program[i];
+            if (kept == FILLER) {
+                continue;
+            }
+            c->program[i] = FILLER;
+            if (diverges(c, engine, &what) == -1) {
+                c->program[i] = kept;
+            } else {
+                changed = true;
+            }
+        }
+        for (int i = 0; i < c->frames; i++) {
+            unsigned short kept = c->keys[i];
+            if (kept == 0) {
+                continue;
+            }
+            c->keys[i] = 0;
+            if (diverges(c, engine, &what) == -1) {
+                c->keys[i] = kept;
+            } else {
+                changed = true;
+            }
+        }
+        int frame = diverges(c, engine, &what);
+        if (frame + 1 < c->frames) {
+            c->frames = frame + 1;
+            changed = true;
+        }
+    }
+}
+
+static void printCase(struct Case *c) {
+    printf("    profile %s, %d frames\n    V", profileName(c->profile), c->frames);
+    for (int i = 0; i < DATA_REGISTERS; i++) {
+        printf(" %02X", c->V[i]);
+    }
+    printf("\n    I %04X DT %02X ST %02X SP %02X rng %08X\n    stack", c->I, c->delay_timer, c->sound_timer, c->SP,
+           c->rng);
+    for (int i = 0; i < STACK_SIZE; i++) {
+        printf(" %04X", c->stack[i]);
+    }
+    printf("\n    keys");
+    for (int i = 0; i < c->frames; i++) {
+        if (c->keys[i] != 0) {
+            printf(" %d:%04X", i, c->keys[i]);
+        }
+    }
+    printf("\n");
+    if (c->aot != 0x00) {
+        printf("    translated ROM %016llx\n", c->aot->hash);
+        return;
+    }
+    for (int i = 0; i < PROGRAM_WORDS; i++) {
+        if (c->program[i] != FILLER) {
+            char text[64];
+            unsigned short operand = i + 1 < PROGRAM_WORDS ? c->program[i + 1] : 0;
+            enum Op op = decodeOp(profileIsa(c->profile), c->program[i]);
+            formatOp(text, sizeof(text), c->program[i], op, operand, 0x00);
+            printf("    %04X: %04X  %s\n", ROM_START + i * 2, c->program[i], text);
+        }
+    }
+}
+
+// runs random cases on every engine, or one case again
+int main(int argc, char **argv) {
+    if (argc != 2 && argc != 3) {
+        printf("[Error] usage: ./chip8-fuzz <cases> [first seed]\n");
+        return -1;
+    }
+    long cases = strtol(argv[1], 0x00, 10);
+    unsigned int seed = argc == 3 ? strtoul(argv[2], 0x00, 0) : 1;
+    // the debugger stops at every instruction of the program and watches all of XO-CHIP's memory
+    dbgInit(&debugger, keepRunning, 0x00);
+    for (int i = 0; i < PROGRAM_WORDS; i++) {
+        dbgBreak(&debugger, ROM_START + i * 2, true);
+    }
+    dbgWatch(&debugger, 0, XO_MEMORY_SIZE);
+    int failures = 0;
+    static struct Case c;
+    for (long n = 0; n < cases; n++, seed++) {
+        generate(&c, seed);
+        bool failed = false;
+        for (size_t e = 0; e < sizeof(engines) / sizeof(engines[0]) && !failed; e++) {
+            const char *what;
+            if (engines[e].translated && c.aot == 0x00) {
+                continue;
+            }
+            int frame = diverges(&c, &engines[e], &what);
+            if (frame == -1) {
+                continue;
+            }
+            printf("[Error] seed %u: the %s diverged from execOpcode() after frame %d, %s differs\n", seed,
+                   engines[e].name, frame, what);
+            minimize(&c, &engines[e]);
+            diverges(&c, &engines[e], &what);
+            printf("    minimized, %s differs after the last frame\n", what);
+            failed = true;
+        }
+        // the forks only run cases the engines agree on
+        int sibling = 0;
+        const char *what = "";
+        int frame = failed || n % FORK_EVERY != 0 ? -1 : forkDiverges(&c, &sibling, &what);
+        if (frame == c.frames) {
+            printf("[Error] seed %u: running its forks changed the root, %s differs\n", seed, what);
+        } else if (frame != -1) {
+            printf("[Error] seed %u: fork %d diverged from a direct run after frame %d, %s differs\n", seed, sibling,
+                   frame, what);
+        }
+        if (failed || frame != -1) {
+            printCase(&c);
+            failures++;
+        }
+    }
+    forkCursorFree(&cursor);
+    printf("%ld cases, %d diverged\n", cases, failures);
+    return failures > 0 ? 1 : 0;
+}
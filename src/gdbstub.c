@@ -0,0 +1,522 @@
+#include "inc/gdbstub.h"
+#include "inc/listen.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static const char target_xml[] = "<?xml version=\"1.0\"?>\n"
+                                 "<!DOCTYPE target SYSTEM \"gdb-target.dtd\">\n"
+                                 "<target version=\"1.0\">\n"
+                                 "  <feature name=\"org.chip8.core\">\n"
+                                 "    <reg name=\"v0\" bitsize=\"8\" regnum=\"0\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v1\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v2\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v3\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v4\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v5\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v6\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v7\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v8\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"v9\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"va\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"vb\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"vc\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"vd\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"ve\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"vf\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"i\" bitsize=\"32\" type=\"data_ptr\"/>\n"
+                                 "    <reg name=\"pc\" bitsize=\"16\" type=\"code_ptr\"/>\n"
+                                 "    <reg name=\"sp\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"dt\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "    <reg name=\"st\" bitsize=\"8\" type=\"uint8\"/>\n"
+                                 "  </feature>\n"
+                                 "</target>\n";
+
+static const char hex_digits[] = "0123456789abcdef";
+
+/**
+ * @brief gdbOpen(stub, address) is used to start listening for a client,
+ * gdbPoll() accepts it
+ * @param stub the server
+ * @param address a port number for 127.0.0.1, anything else is the path of a Unix domain socket
+ * @return 0, or -1 if the socket could not be opened
+ */
+int gdbOpen(struct GdbStub *stub, const char *address) {
+    memset(stub, 0, sizeof(*stub));
+    stub->client = -1;
+    stub->listener = listenOn(address, 1);
+    return stub->listener == -1 ? -1 : 0;
+}
+
+static void disconnect(struct GdbStub *stub) {
+    if (stub->client != -1) {
+        close(stub->client);
+    }
+    stub->client = -1;
+    stub->running = false;
+    stub->no_ack = false;
+    stub->in_len = stub->in_pos = 0;
+}
+
+// the next byte from the client, -1 once it is gone
+static int readByte(struct GdbStub *stub) {
+    if (stub->in_pos == stub->in_len) {
+        ssize_t n = recv(stub->client, stub->in, sizeof(stub->in), 0);
+        while (n == -1 && errno == EINTR) {
+            n = recv(stub->client, stub->in, sizeof(stub->in), 0);
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        stub->in_len = n;
+        stub->in_pos = 0;
+    }
+    return stub->in[stub->in_pos++];
+}
+
+static int hexValue(int c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+/*
+    Reads packets into stub->packet until one has the right checksum, acks
+    are skipped and so is ^C, which means nothing while the machine is
+    stopped. Returns its length, or -1 once the client is gone.
+*/
+static int readPacket(struct GdbStub *stub) {
+    for (;;) {
+        int c;
+        while ((c = readByte(stub)) != '$') {
+            if (c == -1) {
+                return -1;
+            }
+        }
+        int len = 0;
+        unsigned char sum = 0;
+        while ((c = readByte(stub)) != '#') {
+            if (c == -1) {
+                return -1;
+            }
+            sum += c;
+            // escaped bytes of binary data are kept escaped, the packets that carry them are not supported
+            if (len < GDB_PACKET_SIZE) {
+                stub->packet[len++] = c;
+            }
+        }
+        int hi = hexValue(readByte(stub));
+        int lo = hexValue(readByte(stub));
+        stub->packet[len] = '\0';
+        bool valid = hi != -1 && lo != -1 && (hi << 4 | lo) == sum;
+        if (!stub->no_ack && send(stub->client, valid ? "+" : "-", 1, MSG_NOSIGNAL) != 1) {
+            return -1;
+        }
+        if (valid) {
+            return len;
+        }
+    }
+}
+
+// sends data as a packet and waits for the ack, returns -1 once the client is gone
+static int writePacket(struct GdbStub *stub, const char *data) {
+    char frame[GDB_PACKET_SIZE + 4];
+    size_t len = strlen(data);
+    unsigned char sum = 0;
+    frame[0] = '$';
+    for (size_t i = 0; i < len; i++) {
+        sum += data[i];
+    }
+    memcpy(frame + 1, data, len);
+    frame[len + 1] = '#';
+    frame[len + 2] = hex_digits[sum >> 4];
+    frame[len + 3] = hex_digits[sum & 0xF];
+    for (;;) {
+        if (send(stub->client, frame, len + 4, MSG_NOSIGNAL) != (ssize_t)(len + 4)) {
+            return -1;
+        }
+        if (stub->no_ack) {
+            return 0;
+        }
+        int c;
+        while ((c = readByte(stub)) != '+' && c != '-') {
+            if (c == -1) {
+                return -1;
+            }
+        }
+        if (c == '+') {
+            return 0;
+        }
+    }
+}
+
+/**
+ * @brief gdbPoll(stub, dbg) is used once per frame while the machine runs:
+ * it accepts a new client and stops the machine for it, and stops it when
+ * the client sends ^C
+ * @param stub the server
+ * @param dbg the debugger whose stop function is gdbStop()
+ * @return void
+ */
+void gdbPoll(struct GdbStub *stub, struct Debugger *dbg) {
+    if (stub->client == -1) {
+        if (stub->listener == -1 || (stub->client = accept(stub->listener, 0x00, 0x00)) == -1) {
+            return;
+        }
+        // clients expect a stopped target when they attach
+        dbgInterrupt(dbg);
+        return;
+    }
+    if (stub->in_pos == stub->in_len) {
+        ssize_t n = recv(stub->client, stub->in, sizeof(stub->in), MSG_DONTWAIT);
+        if (n == 0 || (n == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            dbgDetach(dbg);
+            disconnect(stub);
+            return;
+        }
+        if (n <= 0) {
+            return;
+        }
+        stub->in_len = n;
+        stub->in_pos = 0;
+    }
+    // ^C, or a packet from a client that doesn't wait for the stop reply
+    if (stub->in[stub->in_pos] == 0x03) {
+        stub->in_pos++;
+    }
+    dbgInterrupt(dbg);
+}
+
+/**
+ * @brief gdbClose(stub) is used to close the client's connection and stop listening
+ * @return void
+ */
+void gdbClose(struct GdbStub *stub) {
+    disconnect(stub);
+    if (stub->listener != -1) {
+        close(stub->listener);
+    }
+    stub->listener = -1;
+}
+
+static unsigned int registerSize(int n) {
+    return n == 16 ? 4 : n == 17 ? 2 : 1;
+}
+
+static unsigned int getRegister(struct Chip8 *chip8, int n) {
+    struct Registers *r = &chip8->registers;
+    switch (n) {
+    case 16:
+        return r->I;
+    case 17:
+        return r->PC;
+    case 18:
+        return r->SP;
+    case 19:
+        return r->delay_timer;
+    case 20:
+        return r->sound_timer;
+    default:
+        return r->V[n];
+    }
+}
+
+static void setRegister(struct Chip8 *chip8, int n, unsigned int value) {
+    struct Registers *r = &chip8->registers;
+    switch (n) {
+    case 16:
+        r->I = value;
+        break;
+    case 17:
+        r->PC = value;
+        break;
+    case 18:
+        r->SP = value;
+        break;
+    case 19:
+        r->delay_timer = value;
+        break;
+    case 20:
+        r->sound_timer = value;
+        break;
+    default:
+        r->V[n] = value;
+        break;
+    }
+}
+
+// writes register n as little endian hex, returns the characters written
+static int putRegister(struct Chip8 *chip8, int n, char *out) {
+    unsigned int value = getRegister(chip8, n);
+    unsigned int size = registerSize(n);
+    for (unsigned int i = 0; i < size; i++, value >>= 8) {
+        out[i * 2] = hex_digits[value >> 4 & 0xF];
+        out[i * 2 + 1] = hex_digits[value & 0xF];
+    }
+    out[size * 2] = '\0';
+    return size * 2;
+}
+
+// reads register n as little endian hex, returns the characters read or -1
+static int takeRegister(struct Chip8 *chip8, int n, const char *in) {
+    unsigned int size = registerSize(n);
+    unsigned int value = 0;
+    for (unsigned int i = 0; i < size; i++) {
+        int hi = hexValue(in[i * 2]);
+        int lo = hi == -1 ? -1 : hexValue(in[i * 2 + 1]);
+        if (lo == -1) {
+            return -1;
+        }
+        value |= (unsigned int)(hi << 4 | lo) << (i * 8);
+    }
+    setRegister(chip8, n, value);
+    return size * 2;
+}
+
+// reads addr,len as in m, M, Z and z packets, returns the text after them or 0x00
+static const char *addressLength(const char *text, unsigned long *addr, unsigned long *len) {
+    char *end;
+    *addr = strtoul(text, &end, 16);
+    if (end == text || *end != ',') {
+        return 0x00;
+    }
+    text = end + 1;
+    *len = strtoul(text, &end, 16);
+    return end == text ? 0x00 : end;
+}
+
+static void stopReply(struct Debugger *dbg, char *out, size_t len) {
+    switch (dbg->reason) {
+    case STOP_INTERRUPT:
+        snprintf(out, len, "T02");
+        break;
+    case STOP_BREAK:
+        snprintf(out, len, "T05swbreak:;");
+        break;
+    case STOP_WATCH:
+        snprintf(out, len, "T05watch:%x;", dbg->hit);
+        break;
+    default:
+        snprintf(out, len, "T05");
+        break;
+    }
+}
+
+static void readMemory(struct Chip8 *chip8, unsigned long addr, unsigned long len, char *out) {
+    // two characters per byte have to fit in a packet
+    if (len > GDB_PACKET_SIZE / 2) {
+        len = GDB_PACKET_SIZE / 2;
+    }
+    for (unsigned long i = 0; i < len; i++) {
+        unsigned char byte = getMemory(&chip8->memory, (addr + i) & (chip8->memory.size - 1));
+        out[i * 2] = hex_digits[byte >> 4];
+        out[i * 2 + 1] = hex_digits[byte & 0xF];
+    }
+    out[len * 2] = '\0';
+}
+
+static bool writeMemory(struct Chip8 *chip8, unsigned long addr, unsigned long len, const char *in) {
+    if (strlen(in) != len * 2) {
+        return false;
+    }
+    for (unsigned long i = 0; i < len; i++) {
+        int hi = hexValue(in[i * 2]);
+        int lo = hexValue(in[i * 2 + 1]);
+        if (hi == -1 || lo == -1) {
+            return false;
+        }
+        // through setMemory() so forks see the page as dirty
+        setMemory(&chip8->memory, (addr + i) & (chip8->memory.size - 1), hi << 4 | lo);
+    }
+    return true;
+}
+
+// qXfer:features:read:target.xml:offset,length
+static void readFeatures(const char *annex, char *out, size_t len) {
+    unsigned long offset, length;
+    if (strncmp(annex, "target.xml:", 11) != 0 || addressLength(annex + 11, &offset, &length) == 0x00) {
+        snprintf(out, len, "E00");
+        return;
+    }
+    size_t size = sizeof(target_xml) - 1;
+    if (offset >= size) {
+        snprintf(out, len, "l");
+        return;
+    }
+    if (length > len - 2) {
+        length = len - 2;
+    }
+    size_t chunk = size - offset < length ? size - offset : length;
+    out[0] = offset + chunk < size ? 'm' : 'l';
+    memcpy(out + 1, target_xml + offset, chunk);
+    out[chunk + 1] = '\0';
+}
+
+/*
+    Answers the packet in stub->packet, out holds the reply. Returns true
+    if the machine should run again.
+*/
+static bool handlePacket(struct GdbStub *stub, struct Debugger *dbg, struct Chip8 *chip8, char *out, size_t len) {
+    const char *p = stub->packet;
+    unsigned long addr, size;
+    const char *rest;
+    out[0] = '\0';
+    switch (p[0]) {
+    case '?':
+        stopReply(dbg, out, len);
+        break;
+    case 'g':
+        for (int n = 0, used = 0; n < GDB_REGISTERS; n++) {
+            used += putRegister(chip8, n, out + used);
+        }
+        break;
+    case 'G': {
+        const char *in = p + 1;
+        int n = 0;
+        for (int used; n < GDB_REGISTERS && (used = takeRegister(chip8, n, in)) != -1; n++) {
+            in += used;
+        }
+        snprintf(out, len, n == GDB_REGISTERS ? "OK" : "E01");
+    } break;
+    case 'p':
+        addr = strtoul(p + 1, 0x00, 16);
+        if (addr < GDB_REGISTERS) {
+            putRegister(chip8, addr, out);
+        } else {
+            snprintf(out, len, "E01");
+        }
+        break;
+    case 'P': {
+        char *end;
+        addr = strtoul(p + 1, &end, 16);
+        bool valid = *end == '=' && addr < GDB_REGISTERS && takeRegister(chip8, addr, end + 1) != -1;
+        snprintf(out, len, valid ? "OK" : "E01");
+    } break;
+    case 'm':
+        if (addressLength(p + 1, &addr, &size) == 0x00) {
+            snprintf(out, len, "E01");
+        } else {
+            readMemory(chip8, addr, size, out);
+        }
+        break;
+    case 'M':
+        rest = addressLength(p + 1, &addr, &size);
+        if (rest == 0x00 || *rest != ':' || !writeMemory(chip8, addr, size, rest + 1)) {
+            snprintf(out, len, "E01");
+        } else {
+            snprintf(out, len, "OK");
+        }
+        break;
+    case 'c':
+    case 's':
+        if (p[1] != '\0') {
+            chip8->registers.PC = strtoul(p + 1, 0x00, 16);
+        }
+        if (p[0] == 'c') {
+            dbgContinue(dbg);
+        } else {
+            dbgStep(dbg, 1);
+        }
+        return true;
+    case 'Z':
+    case 'z': {
+        bool on = p[0] == 'Z';
+        rest = p[1] != '\0' && p[2] == ',' ? addressLength(p + 3, &addr, &size) : 0x00;
+        if (rest == 0x00) {
+            snprintf(out, len, "E01");
+        } else if (p[1] == '0' || p[1] == '1') {
+            snprintf(out, len, dbgBreak(dbg, addr, on) == 0 ? "OK" : "E01");
+        } else if (p[1] == '2') {
+            snprintf(out, len, (on ? dbgWatch(dbg, addr, size) : dbgUnwatch(dbg, addr)) == 0 ? "OK" : "E01");
+        }
+    } break;
+    case 'H':
+        snprintf(out, len, "OK");
+        break;
+    case 'D':
+        writePacket(stub, "OK");
+        dbgDetach(dbg);
+        disconnect(stub);
+        return true;
+    case 'k':
+        dbg->quit = true;
+        disconnect(stub);
+        return true;
+    case 'q':
+        if (strncmp(p, "qSupported", 10) == 0) {
+            snprintf(out, len, "PacketSize=%x;qXfer:features:read+;swbreak+;QStartNoAckMode+", GDB_PACKET_SIZE);
+        } else if (strncmp(p, "qXfer:features:read:", 20) == 0) {
+            readFeatures(p + 20, out, len);
+        } else if (strcmp(p, "qAttached") == 0) {
+            snprintf(out, len, "1");
+        } else if (strcmp(p, "qC") == 0) {
+            snprintf(out, len, "QC1");
+        } else if (strcmp(p, "qfThreadInfo") == 0) {
+            snprintf(out, len, "m1");
+        } else if (strcmp(p, "qsThreadInfo") == 0) {
+            snprintf(out, len, "l");
+        }
+        break;
+    case 'Q':
+        if (strcmp(p, "QStartNoAckMode") == 0) {
+            writePacket(stub, "OK");
+            stub->no_ack = true;
+            return false;
+        }
+        break;
+    default:
+        // an empty reply tells the client the packet is not supported
+        break;
+    }
+    writePacket(stub, out);
+    return false;
+}
+
+/**
+ * @brief gdbStop(dbg, chip8) is used as the debugger's stop function when a
+ * client debugs over RSP: it sends the stop reply the client waits for and
+ * answers packets until one runs the machine again
+ * @param dbg the debugger, dbg->data is the struct GdbStub
+ * @param chip8 chip8's state
+ * @return void
+ */
+void gdbStop(struct Debugger *dbg, struct Chip8 *chip8) {
+    struct GdbStub *stub = dbg->data;
+    char out[GDB_PACKET_SIZE + 1];
+    if (stub->client == -1) {
+        return;
+    }
+    if (stub->running) {
+        stub->running = false;
+        stopReply(dbg, out, sizeof(out));
+        if (writePacket(stub, out) == -1) {
+            dbgDetach(dbg);
+            disconnect(stub);
+            return;
+        }
+    }
+    for (;;) {
+        if (readPacket(stub) == -1) {
+            dbgDetach(dbg);
+            disconnect(stub);
+            return;
+        }
+        if (handlePacket(stub, dbg, chip8, out, sizeof(out))) {
+            stub->running = stub->client != -1;
+            return;
+        }
+        if (stub->client == -1) {
+            return;
+        }
+    }
+}
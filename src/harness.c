@@ -0,0 +1,199 @@
+#include "inc/chip8.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*
+    Coverage-guided fuzzing entry point of the core, built with sanitizers
+    and without SDL. LLVMFuzzerTestOneInput() is what libFuzzer calls; built
+    without -DCHIP8_LIBFUZZER the same function gets a main() that runs
+    input files, or stdin for AFL, in a loop (__AFL_LOOP persistent mode
+    when built with afl-clang-fast).
+
+    An input is laid out as
+        byte 0      bits 0-5: frames to run - 1, bit 6: single-step through
+                    chStep() and execOpcode() instead of chFrame()
+        byte 1      number of key events that follow
+        key events  bits 0-3: key, bit 4: 1 down / 0 up, bits 5-7: frames
+                    to wait after the previous event
+        the rest    the ROM, loaded with chLoadDataAs()
+    drawSprite(), the stack and memory are reached through the instructions
+    the ROM runs.
+
+    There is one machine per profile, sized once. The ROM's platform is
+    detected once per input and chLoadDataAs() is handed its profile, so
+    the machine of that profile is used and nothing is resized. Between inputs the machine goes back to the
+    state it had after chInit() by copying the struct saved then and zeroing
+    the pages the last input wrote, no allocation per iteration.
+*/
+#define HARNESS_SEED 1
+#define MAX_FRAMES 64
+#define STEP_MODE 0x40
+
+static struct Chip8 machines[PROFILES];
+static struct Chip8 boot[PROFILES];
+// the fonts chInit() puts below ROM_START
+static unsigned char low[ROM_START];
+static size_t loaded[PROFILES];
+
+static void setup(void) {
+    for (int p = 0; p < PROFILES; p++) {
+        chInit(&machines[p]);
+        chSetProfile(&machines[p], p);
+        chSeed(&machines[p], HARNESS_SEED);
+        clearDirty(&machines[p].memory);
+        boot[p] = machines[p];
+    }
+    memcpy(low, machines[0].memory.memory, ROM_START);
+}
+
+// undoes the last input, memory, dirty bits and mega pointers are the same as in boot
+static void reset(int p) {
+    struct Chip8 *chip8 = &machines[p];
+    struct Memory *memory = &chip8->memory;
+    // a word of dirty bits at a time, MegaChip has 131072 pages
+    for (int word = 0; word < (memPages(memory) + 31) / 32; word++) {
+        for (unsigned int bits = memory->dirty[word]; bits != 0; bits &= bits - 1) {
+            unsigned int start = (word * 32 + __builtin_ctz(bits)) * PAGE_SIZE;
+            if (start < ROM_START) {
+                memcpy(&memory->memory[start], &low[start], PAGE_SIZE);
+            } else {
+                memset(&memory->memory[start], 0, PAGE_SIZE);
+            }
+        }
+    }
+    // chLoadDataAs() copies the ROM without marking pages
+    memset(&memory->memory[ROM_START], 0, loaded[p]);
+    loaded[p] = 0;
+    clearDirty(memory);
+    if (chip8->mega != 0x00) {
+        memset(chip8->mega, 0, sizeof(struct Mega));
+    }
+    *chip8 = boot[p];
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    static bool ready = false;
+    if (!ready) {
+        setup();
+        ready = true;
+    }
+    if (size < 2) {
+        return 0;
+    }
+    int frames = (data[0] & (MAX_FRAMES - 1)) + 1;
+    bool step = data[0] & STEP_MODE;
+    size_t events = data[1];
+    if (events > size - 2) {
+        events = size - 2;
+    }
+    const uint8_t *keys = data + 2;
+    const uint8_t *rom = keys + events;
+    size_t rom_size = size - 2 - events;
+    if (rom_size == 0 || rom_size > MEGA_MEMORY_SIZE - ROM_START) {
+        return 0;
+    }
+
+    enum Profile p = defaultProfile(detectPlatform(rom, rom_size));
+    struct Chip8 *chip8 = &machines[p];
+    if (chLoadDataAs(chip8, rom, rom_size, p) != ROM_OK) {
+        return 0;
+    }
+    loaded[p] = rom_size;
+
+    size_t next = 0;
+    int wait = next < events ? keys[next] >> 5 : 0;
+    for (int frame = 0; frame < frames; frame++) {
+        while (next < events && wait == 0) {
+            if (keys[next] & 0x10) {
+                keyDown(&chip8->keyboard, keys[next] & 0xF);
+            } else {
+                keyUp(&chip8->keyboard, keys[next] & 0xF);
+            }
+            next++;
+            wait = next < events ? keys[next] >> 5 : 0;
+        }
+        wait--;
+        if (step) {
+            for (int i = 0; i < CYCLES_PER_FRAME; i++) {
+                chStep(chip8);
+            }
+            chTick(chip8);
+        } else {
+            chFrame(chip8);
+        }
+    }
+    reset(p);
+    return 0;
+}
+
+#ifndef CHIP8_LIBFUZZER
+#define MAX_INPUT (1 << 20)
+
+static unsigned char input[MAX_INPUT];
+
+// the input is copied to a block of its own size so the sanitizers see reads past its end
+static unsigned char *readInput(FILE *in, size_t *size) {
+    *size = fread(input, 1, sizeof(input), in);
+    unsigned char *data = malloc(*size ? *size : 1);
+    if (data == 0x00) {
+        abort();
+    }
+    memcpy(data, input, *size);
+    return data;
+}
+
+// runs input files, each <runs> times, or stdin until AFL stops the loop
+int main(int argc, char **argv) {
+    long runs = 1;
+    int first = 1;
+    if (argc >= 3 && strcmp(argv[1], "-r") == 0) {
+        runs = strtol(argv[2], 0x00, 10);
+        first = 3;
+    }
+    if (runs < 1) {
+        printf("[Error] usage: ./chip8-harness [-r <runs>] [input files]\n");
+        return -1;
+    }
+    if (first == argc) {
+#ifdef __AFL_HAVE_MANUAL_CONTROL
+        while (__AFL_LOOP(10000)) {
+            size_t size;
+            unsigned char *data = readInput(stdin, &size);
+            LLVMFuzzerTestOneInput(data, size);
+            free(data);
+        }
+#else
+        size_t size;
+        unsigned char *data = readInput(stdin, &size);
+        LLVMFuzzerTestOneInput(data, size);
+        free(data);
+#endif
+        return 0;
+    }
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    long execs = 0;
+    for (int i = first; i < argc; i++) {
+        FILE *in = fopen(argv[i], "rb");
+        if (in == 0x00) {
+            printf("[Error] could not read %s\n", argv[i]);
+            return -1;
+        }
+        size_t size;
+        unsigned char *data = readInput(in, &size);
+        fclose(in);
+        for (long r = 0; r < runs; r++) {
+            LLVMFuzzerTestOneInput(data, size);
+        }
+        free(data);
+        execs += runs;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%ld execs, %.0f execs/s\n", execs, execs / seconds);
+    return 0;
+}
+#endif
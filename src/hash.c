@@ -0,0 +1,44 @@
+#include "inc/hash.h"
+
+#define HASH_PRIME 0x100000001b3ULL
+
+/**
+ * @brief hashUpdate(hash, data, len) is used to feed more bytes into a running
+ * 64-bit FNV-1a hash, start from HASH_INIT
+ * @param hash the hash so far
+ * @param data bytes to add
+ * @param len number of bytes
+ * @return the updated hash
+ */
+unsigned long long hashUpdate(unsigned long long hash, const void *data, size_t len) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+unsigned long long hashBytes(const void *data, size_t len) {
+    return hashUpdate(HASH_INIT, data, len);
+}
+
+/**
+ * @brief hashCopy(dst, src, len) is used to copy bytes and hash them in the same
+ * pass, so a ROM is only read once on its way into memory
+ * @param dst where the bytes go, not overlapping src
+ * @param src bytes to copy
+ * @param len number of bytes
+ * @return the FNV-1a hash of the bytes, as hashBytes() gives
+ */
+unsigned long long hashCopy(void *dst, const void *src, size_t len) {
+    unsigned char *out = dst;
+    const unsigned char *bytes = src;
+    unsigned long long hash = HASH_INIT;
+    for (size_t i = 0; i < len; i++) {
+        out[i] = bytes[i];
+        hash ^= bytes[i];
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
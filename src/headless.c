@@ -0,0 +1,96 @@
+#include "inc/chip8.h"
+#include "inc/replay.h"
+#include <stdio.h>
+#include <time.h>
+
+// runs the emulator without SDL, as fast as the CPU allows
+struct Chip8 chip8;
+#ifdef CHIP8_PROFILE
+struct Profiler profiler;
+#endif
+#ifdef CHIP8_HOTSPOTS
+struct Hotspots hotspots; // also written to <rom file>.hot.csv
+#endif
+
+int main(int argc, char **argv) {
+#ifdef CHIP8_PROFILE
+    if (argc != 3 && argc != 4) {
+        printf("[Error] usage: ./chip8-headless <rom file> <input log> [folded stacks output]\n");
+        return -1;
+    }
+#else
+    if (argc != 3) {
+        printf("[Error] usage: ./chip8-headless <rom file> <input log>\n");
+        return -1;
+    }
+#endif
+    struct Replay replay;
+    if (replayOpen(&replay, argv[2]) == -1) {
+        return -1;
+    }
+    chInit(&chip8);
+    enum RomError error = chLoad(&chip8, argv[1]);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", argv[1], romError(error));
+        replayClose(&replay);
+        return -1;
+    }
+    if (chip8.rom_hash != replay.rom_hash) {
+        printf("[Error] %s is not the ROM this log was recorded with\n", argv[1]);
+        replayClose(&replay);
+        return -1;
+    }
+#ifdef CHIP8_PROFILE
+    profInit(&profiler, chip8.cycles);
+    chip8.profiler = &profiler;
+#endif
+#ifdef CHIP8_HOTSPOTS
+    hotInit(&hotspots, chip8.registers.PC);
+    chip8.hotspots = &hotspots;
+#endif
+    clock_t start = clock();
+    int result = replayRun(&replay, &chip8);
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    replayClose(&replay);
+    printf("frames: %lu\ncycles: %llu\ntime: %.3fs\n", chip8.frames, chip8.cycles, seconds);
+    printf("screen: %016llx\nstats: ", chScreenHash(&chip8));
+    statsWrite(&chip8, stdout);
+#ifdef CHIP8_CHECKED
+    printf("violations: %lu\n", chip8.memory.violations);
+#endif
+#ifdef CHIP8_PROFILE
+    profWriteReport(&profiler, stdout, chip8.cycles);
+    if (argc == 4) {
+        FILE *folded = fopen(argv[3], "w");
+        int written = folded != 0x00 ? profWriteFolded(&profiler, folded, chip8.cycles) : -1;
+        if (folded == 0x00 || fclose(folded) != 0 || written == -1) {
+            printf("[Error] could not write %s\n", argv[3]);
+        }
+    }
+    profFree(&profiler);
+#endif
+#ifdef CHIP8_HOTSPOTS
+    hotWriteReport(&hotspots, stdout, &chip8.memory, profileIsa(chip8.profile), chip8.registers.PC);
+    char csv_path[4096];
+    snprintf(csv_path, sizeof(csv_path), "%s.hot.csv", argv[1]);
+    FILE *csv = fopen(csv_path, "w");
+    int written =
+        csv != 0x00 ? hotWriteCsv(&hotspots, csv, &chip8.memory, profileIsa(chip8.profile), chip8.registers.PC) : -1;
+    if (csv == 0x00 || fclose(csv) != 0 || written == -1) {
+        printf("[Error] could not write %s\n", csv_path);
+    }
+#endif
+    switch (result) {
+    case 0:
+        printf("[OK] replay matches the recording\n");
+        break;
+    case 1:
+        printf("[Error] replay diverged from the recording\n");
+        break;
+    default:
+        printf("[Error] input log is truncated\n");
+        break;
+    }
+    chFree(&chip8);
+    return result;
+}
@@ -0,0 +1,197 @@
+#include "inc/hotspots.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CHIP8_HOTSPOTS
+
+// rows of the hottest addresses table, the CSV has all of them
+#define HOT_REPORT_ADDRESSES 32
+
+static const char *family_names[HOT_FAMILIES] = {"0NNN", "1NNN", "2NNN", "3XNN", "4XNN", "5XYN", "6XNN", "7XNN",
+                                                 "8XYN", "9XY0", "ANNN", "BNNN", "CXNN", "DXYN", "EXNN", "FXNN"};
+
+struct HotLine {
+    unsigned int key; // address, family or enum Op
+    unsigned long long count;
+};
+
+/**
+ * @brief hotInit(hot, pc) is used to clear the counters before they are
+ * attached to a machine about to run from pc
+ * @param hot the counters
+ * @param pc chip8->registers.PC
+ * @return void
+ */
+void hotInit(struct Hotspots *hot, unsigned short pc) {
+    memset(hot, 0, sizeof(struct Hotspots));
+    hot->flow[pc] = 1;
+}
+
+// the instruction's syntax with its operands spelled as in opcode patterns, "ADD VX, VY"
+static void opName(enum Op op, char *buf, size_t len) {
+    static const char *operands[128] = {['x'] = "VX", ['y'] = "VY", ['n'] = "N", ['m'] = "X", ['b'] = "NN",
+                                        ['a'] = "NNN", ['l'] = "NNNN", ['L'] = "NN NNNN", ['w'] = "NNNN"};
+    if (op == OP_UNKNOWN) {
+        snprintf(buf, len, "(unknown)");
+        return;
+    }
+    size_t used = 0;
+    for (const char *c = opTable[op].format; *c != '\0' && used + 1 < len; c++) {
+        if (*c == '%' && c[1] != '\0' && operands[c[1] & 0x7F] != 0x00) {
+            used += snprintf(&buf[used], len - used, "%s", operands[c[1] & 0x7F]);
+            c++;
+        } else {
+            buf[used++] = *c;
+        }
+    }
+    buf[used < len ? used : len - 1] = '\0';
+}
+
+static int byCount(const void *a, const void *b) {
+    const struct HotLine *x = a, *y = b;
+    if (x->count != y->count) {
+        return x->count < y->count ? 1 : -1;
+    }
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+// the non-zero counts, heaviest first
+static int sortCounts(const unsigned long long *counts, int n, struct HotLine *lines) {
+    int used = 0;
+    for (int i = 0; i < n; i++) {
+        if (counts[i] > 0) {
+            lines[used].key = i;
+            lines[used++].count = counts[i];
+        }
+    }
+    qsort(lines, used, sizeof(struct HotLine), byCount);
+    return used;
+}
+
+static void pcName(struct Memory *memory, unsigned int isa, unsigned int pc, char *buf, size_t len) {
+    unsigned short opcode = mergeBytes(memory, pc);
+    formatOp(buf, len, opcode, decodeOp(isa, opcode), mergeBytes(memory, pc + 2), 0x00);
+}
+
+// the instructions executed at each address, the running sum of the flows of every other address,
+// stopped at pc where the machine would run on from
+static void sumFlows(struct Hotspots *hot, unsigned short pc, unsigned long long *counts) {
+    long long run[2] = {0, 0};
+    for (unsigned int addr = 0; addr < HOT_ADDRESSES; addr++) {
+        run[addr & 1] += hot->flow[addr] - (addr == pc);
+        // a PC change hotJump() didn't see can leave a chain short
+        counts[addr] = run[addr & 1] > 0 ? run[addr & 1] : 0;
+    }
+}
+
+// the family and instruction counts, from the instruction at each address decoded with isa
+static void sumOpcodes(const unsigned long long *counts, struct Memory *memory, unsigned int isa,
+                       unsigned long long *family, unsigned long long *op) {
+    memset(family, 0, HOT_FAMILIES * sizeof(unsigned long long));
+    memset(op, 0, OPS * sizeof(unsigned long long));
+    for (unsigned int pc = 0; pc < HOT_ADDRESSES; pc++) {
+        if (counts[pc] > 0) {
+            unsigned short opcode = mergeBytes(memory, pc);
+            family[opcode >> 12] += counts[pc];
+            op[decodeOp(isa, opcode)] += counts[pc];
+        }
+    }
+}
+
+/**
+ * @brief hotWriteReport(hot, out, memory, isa, pc) is used to print the opcode
+ * families, the instructions and the hottest addresses, each sorted by count
+ * @param hot the counters
+ * @param out file to write to
+ * @param memory chip8's memory, to show what runs at each address
+ * @param isa ISA_* of the profile, to decode it
+ * @param pc chip8->registers.PC, where the counted run stopped
+ * @return 0 on success, -1 on errors
+ */
+int hotWriteReport(struct Hotspots *hot, FILE *out, struct Memory *memory, unsigned int isa, unsigned short pc) {
+    struct HotLine *lines = malloc(HOT_ADDRESSES * sizeof(struct HotLine));
+    unsigned long long *counts = malloc(HOT_ADDRESSES * sizeof(unsigned long long));
+    if (lines == 0x00 || counts == 0x00) {
+        free(lines);
+        free(counts);
+        return -1;
+    }
+    sumFlows(hot, pc, counts);
+    unsigned long long family[HOT_FAMILIES], op[OPS], sum = 0;
+    sumOpcodes(counts, memory, isa, family, op);
+    for (int i = 0; i < HOT_FAMILIES; i++) {
+        sum += family[i];
+    }
+    sum = sum ? sum : 1;
+    char name[64];
+    int used = sortCounts(family, HOT_FAMILIES, lines);
+    fprintf(out, "%-20s %14s %7s\n", "family", "instructions", "%");
+    for (int i = 0; i < used; i++) {
+        fprintf(out, "%-20s %14llu %6.2f%%\n", family_names[lines[i].key], lines[i].count,
+                100.0 * lines[i].count / sum);
+    }
+    used = sortCounts(op, OPS, lines);
+    fprintf(out, "\n%-20s %14s %7s\n", "instruction", "instructions", "%");
+    for (int i = 0; i < used; i++) {
+        opName(lines[i].key, name, sizeof(name));
+        fprintf(out, "%-20s %14llu %6.2f%%\n", name, lines[i].count, 100.0 * lines[i].count / sum);
+    }
+    used = sortCounts(counts, HOT_ADDRESSES, lines);
+    fprintf(out, "\n%-8s %14s %7s  %s\n", "address", "instructions", "%", "instruction");
+    for (int i = 0; i < used && i < HOT_REPORT_ADDRESSES; i++) {
+        pcName(memory, isa, lines[i].key, name, sizeof(name));
+        fprintf(out, "  0x%03X  %14llu %6.2f%%  %s\n", lines[i].key, lines[i].count, 100.0 * lines[i].count / sum,
+                name);
+    }
+    if (used > HOT_REPORT_ADDRESSES) {
+        fprintf(out, "%d more addresses ran\n", used - HOT_REPORT_ADDRESSES);
+    }
+    free(lines);
+    free(counts);
+    return ferror(out) ? -1 : 0;
+}
+
+/**
+ * @brief hotWriteCsv(hot, out, memory, isa, pc) is used to export every counter as
+ * "table,key,name,count" rows, the families, the instructions keyed by their
+ * family, then every address that ran, each table sorted by count
+ * @param hot the counters
+ * @param out file to write to
+ * @param memory chip8's memory, to name the instruction at each address
+ * @param isa ISA_* of the profile, to decode it
+ * @param pc chip8->registers.PC, where the counted run stopped
+ * @return 0 on success, -1 on errors
+ */
+int hotWriteCsv(struct Hotspots *hot, FILE *out, struct Memory *memory, unsigned int isa, unsigned short pc) {
+    struct HotLine *lines = malloc(HOT_ADDRESSES * sizeof(struct HotLine));
+    unsigned long long *counts = malloc(HOT_ADDRESSES * sizeof(unsigned long long));
+    if (lines == 0x00 || counts == 0x00) {
+        free(lines);
+        free(counts);
+        return -1;
+    }
+    sumFlows(hot, pc, counts);
+    unsigned long long family[HOT_FAMILIES], op[OPS];
+    sumOpcodes(counts, memory, isa, family, op);
+    char name[64];
+    fprintf(out, "table,key,name,count\n");
+    int used = sortCounts(family, HOT_FAMILIES, lines);
+    for (int i = 0; i < used; i++) {
+        fprintf(out, "family,%X,%s,%llu\n", lines[i].key, family_names[lines[i].key], lines[i].count);
+    }
+    used = sortCounts(op, OPS, lines);
+    for (int i = 0; i < used; i++) {
+        opName(lines[i].key, name, sizeof(name));
+        fprintf(out, "op,%X,\"%s\",%llu\n", opTable[lines[i].key].match >> 12, name, lines[i].count);
+    }
+    used = sortCounts(counts, HOT_ADDRESSES, lines);
+    for (int i = 0; i < used; i++) {
+        pcName(memory, isa, lines[i].key, name, sizeof(name));
+        fprintf(out, "pc,0x%03X,\"%s\",%llu\n", lines[i].key, name, lines[i].count);
+    }
+    free(lines);
+    free(counts);
+    return ferror(out) ? -1 : 0;
+}
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include "chip8.h"
+#include <stdbool.h>
+
+/*
+    Ahead-of-time translations of fixed ROMs. chip8-aot turns a ROM into a
+    C file that runs the basic blocks of its control-flow graph (see
+    inc/cfg.h) as straight-line C in one switch on PC; the Makefile
+    translates the ROMs in AOT_ROMS into src/aot/ and links them into
+    every binary, and chLoad() picks the one whose hash and profile match
+    the loaded ROM.
+
+    A translation runs from case to case, each instruction has one, and
+    blocks with a known successor go straight to it. It counts down the
+    frame's cycles per instruction and hands the interpreter whatever it
+    can't run: addresses with no case (BNNN targets, code the walk never
+    reached, the middle of an instruction) and the instructions it doesn't
+    inline, which call execOpcode() and leave when that moves PC elsewhere.
+    Blocks holding bytes the ROM is known to store to are left out.
+    Translated bytes are compared with the ROM at the start of every frame,
+    and a store that reaches them hands the rest of the frame to the
+    interpreter, so self-modified code always runs through the interpreter
+    and every frame executes exactly what the interpreter would.
+
+    Builds with -DCHIP8_PROFILE, -DCHIP8_CHECKED or -DCHIP8_TRACE always
+    interpret, since they hook every instruction. -DCHIP8_HOTSPOTS only
+    needs the jumps (see inc/hotspots.h), which the translations count
+    themselves with AOT_JUMP.
+*/
+
+struct AotRun {
+    unsigned short start; // address of the first translated byte
+    unsigned short len;   // translated bytes from there on
+};
+
+struct AotRom {
+    unsigned long long hash;    // FNV-1a of the ROM it was translated from
+    unsigned char profile;      // enum Profile it was translated for
+    unsigned int isa;           // profileIsa(profile)
+    const unsigned char *image; // the ROM, loaded at ROM_START
+    unsigned int size;          // bytes in image
+    const unsigned char *code;  // one bit per byte of image that was translated
+    const struct AotRun *runs;  // the same bytes as address ranges
+    int run_count;
+    // runs until PC has no case or left reaches 0, returns the cycles left
+    int (*run)(struct Chip8 *chip8, int left, bool *stale);
+};
+
+const struct AotRom *aotFind(unsigned long long hash, enum Profile profile);
+const struct AotRom *aotTranslation(int index);
+bool aotCurrent(const struct AotRom *aot, struct Memory *memory);
+void aotFrame(struct Chip8 *chip8);
+
+/*
+    The generated run() functions are written with these, in the scope of
+    their locals chip8, r (its registers), V (r->V), left and a label out.
+*/
+// counts the instruction at addr, or leaves run() with PC at it once the frame has no cycles left
+#define AOT_CYCLE(addr)   \
+    if (left == 0) {      \
+        r->PC = (addr);   \
+        goto out;         \
+    }                     \
+    left--
+// control leaves the instruction before next for target, only counted for the hotspots
+#ifdef CHIP8_HOTSPOTS
+#define AOT_JUMP(next, target)                          \
+    do {                                                \
+        if (chip8->hotspots != 0x00) {                  \
+            hotJump(chip8->hotspots, (next), (target)); \
+        }                                               \
+    } while (0)
+// a block ending in a jump back to its start counts its turns in a local instead, since a
+// one-instruction spin would wait on its counters in memory, and adds them when run() leaves
+#define AOT_LOOP(addr) unsigned int turns_##addr = 0
+#define AOT_TURN(addr) turns_##addr++
+#define AOT_LOOP_END(addr, next)                                     \
+    do {                                                             \
+        if (chip8->hotspots != 0x00) {                               \
+            hotJumps(chip8->hotspots, (next), (addr), turns_##addr); \
+        }                                                            \
+    } while (0)
+#else
+#define AOT_JUMP(next, target) \
+    do {                       \
+    } while (0)
+#define AOT_LOOP(addr)
+#define AOT_TURN(addr)
+#define AOT_LOOP_END(addr, next)
+#endif
+// the first instruction of a block, run() starts there when PC is addr
+#define AOT_BLOCK(addr) \
+    case addr:          \
+        AOT_CYCLE(addr);
+// the same for a block other blocks go to directly
+#define AOT_TARGET(addr) \
+    case addr:           \
+    block_##addr:        \
+        AOT_CYCLE(addr);
+// any other instruction, the one before runs on into it
+#define AOT_OP(addr)   \
+    goto op_##addr;    \
+    case addr:         \
+    op_##addr:         \
+        AOT_CYCLE(addr);
+
+// the store of len bytes at addr reaches translated code, used by the generated stores
+static inline bool aotTouches(const struct AotRom *aot, struct Memory *memory, unsigned int addr, unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        unsigned int offset = ((addr + i) & (memory->size - 1)) - ROM_START;
+        if (offset < aot->size && (aot->code[offset / 8] >> (offset % 8) & 1)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef ASM_H
+#define ASM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+    Two-pass assembler for CHIPPER sources, the syntax of roms/SOURCES.
+    Pass one sizes every statement and places the labels, pass two
+    evaluates the operands and writes the image; both run the same code,
+    so they can't disagree about where anything is. Instructions are
+    encoded from opTable (see inc/decode.h), whose formats are CHIPPER
+    syntax, so the assembler knows exactly what chip8-dis prints and the
+    interpreters run. Paul Robson's mnemonics (mov, skeq, jsr, sprite...)
+    are accepted as aliases, and symbols are case-insensitive like CHIPPER's.
+*/
+
+#define ASM_PENDING 16
+#define ASM_NESTING 16
+
+enum SymbolKind {
+    SYM_LABEL, // address of a statement
+    SYM_EQU,   // NAME = value or NAME EQU value
+};
+
+struct AsmSymbol {
+    char *name;
+    long value;
+    unsigned char kind; // enum SymbolKind
+    bool defined;       // false once UNDEF'd, or until pass one reaches it
+    int line;
+};
+
+struct Assembler {
+    unsigned char *image; // bytes from ROM_START on
+    unsigned int size;    // bytes written, the ROM is image[0..size)
+    unsigned int capacity;
+    struct AsmSymbol *symbols;
+    int count;
+    int symbol_capacity;
+    int *table;                // open addressing table of symbol indices, -1 if empty
+    int slots;                 // a power of two
+    struct AsmSymbol *defines; // DEFINE names, only seen by IFDEF and apart from the labels
+    int define_count;
+    int define_capacity;
+    int errors;
+    FILE *log; // where errors are printed
+    // state of the pass in progress
+    const char *file;
+    int line;
+    int pass;
+    unsigned int pc;
+    bool align;
+    bool ended;
+    bool unresolved;          // the last expression used a symbol pass one hasn't seen yet
+    int pending[ASM_PENDING]; // labels waiting for the next statement that emits
+    int pending_count;
+    int depth;              // IFDEF nesting
+    bool skip[ASM_NESTING]; // the level is in the branch not taken
+};
+
+void asmInit(struct Assembler *as, FILE *log);
+void asmDefine(struct Assembler *as, const char *name);
+int asmAssemble(struct Assembler *as, const char *source, size_t len, const char *file);
+int asmWriteSymbols(struct Assembler *as, FILE *out);
+void asmFree(struct Assembler *as);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef CFG_H
+#define CFG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+    Static control-flow analysis of a ROM image. Code is found by recursive
+    descent from the entry point with the decode table of one set of
+    extensions (see inc/decode.h), then cut into basic blocks at every
+    jump, call, skip and return and at every address something branches
+    to. Subroutines are the entry point and each CALL target, each owns
+    the blocks it reaches without calling. BNNN sites are listed since
+    their targets depend on V0, only V0 = 0 is followed. The value of I is
+    tracked within a block, so FX33, FX55 and 5XY2 that follow an ANNN
+    give the bytes they store to; the ones that land on code are the
+    self-modifying code.
+*/
+
+// what the analysis learned about a byte of the image, or-ed together
+#define CFG_CODE 0x01    // first byte of a reachable instruction
+#define CFG_OPERAND 0x02 // rest of a reachable instruction
+#define CFG_LEADER 0x04  // first instruction of a basic block
+#define CFG_JUMP 0x08    // 1NNN or BNNN goes to it
+#define CFG_CALL 0x10    // 2NNN calls it
+#define CFG_DATA 0x20    // ANNN, F000 NNNN or 01NN NNNN points at it
+#define CFG_WRITTEN 0x40 // FX33, FX55 or 5XY2 stores to it
+
+enum CfgIssue {
+    ISSUE_UNKNOWN,     // not an instruction on any machine, runs as a no-op
+    ISSUE_UNSUPPORTED, // an instruction of another machine, runs as a no-op
+    ISSUE_SYS,         // 0NNN machine code call, runs as a no-op
+    ISSUE_OVERLAP,     // a branch lands inside another instruction
+    ISSUE_OUTSIDE,     // a branch or fall through leaves the image
+    ISSUE_SELF_MODIFY, // a store writes to reachable code
+    ISSUES,
+};
+
+struct CfgBlock {
+    unsigned int start;       // address of the first instruction
+    unsigned int end;         // address after the last one
+    unsigned int last;        // address of the last instruction
+    unsigned int succ[2];     // successors in the same subroutine
+    unsigned int callee;      // what the CALL ending the block enters
+    unsigned char succ_count; // 0 after RET, EXIT and JP outside the image
+    unsigned char flow;       // enum Flow of the last instruction
+    int sub;                  // first subroutine that reaches it, index in subs
+};
+
+struct CfgWrite {
+    unsigned int site;  // address of the storing instruction
+    unsigned int start; // first byte stored to
+    unsigned int len;   // bytes stored, 0 if I isn't known at the site
+};
+
+struct CfgNote {
+    unsigned int addr;
+    unsigned short opcode;
+    unsigned char issue; // enum CfgIssue
+};
+
+struct Cfg {
+    const unsigned char *data;
+    unsigned int start;      // address of data[0]
+    unsigned int end;        // address after the image
+    unsigned int isa;        // ISA_* the image was decoded with
+    bool reach_only;         // filled by cfgReach(), only flags is set
+    unsigned char *flags;    // CFG_*, per byte of the image
+    struct CfgBlock *blocks; // by address
+    int block_count;
+    int block_capacity;
+    unsigned int *subs; // entry points, subs[0] is the start of the image
+    int sub_count;
+    int sub_capacity;
+    unsigned int *indirect; // BNNN sites
+    int indirect_count;
+    int indirect_capacity;
+    struct CfgWrite *writes;
+    int write_count;
+    int write_capacity;
+    struct CfgNote *notes; // by address
+    int note_count;
+    int note_capacity;
+};
+
+void cfgBuild(struct Cfg *cfg, const unsigned char *data, size_t size, unsigned int isa);
+void cfgReach(struct Cfg *cfg, const unsigned char *data, size_t size, unsigned int isa, unsigned char *flags,
+              unsigned int *work);
+int cfgFindBlock(struct Cfg *cfg, unsigned int addr);
+int cfgCountIssues(struct Cfg *cfg, enum CfgIssue issue);
+const char *cfgIssueName(enum CfgIssue issue);
+void cfgWriteDot(struct Cfg *cfg, FILE *out);
+void cfgWriteJson(struct Cfg *cfg, FILE *out);
+void cfgFree(struct Cfg *cfg);
+
+#endif
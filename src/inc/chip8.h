@@ -2,22 +2,63 @@
 #define CHIP8_H
 
 #include "memory.h"
+#include "decode.h"
 #include "registers.h"
 #include "stack.h"
 #include "keyboard.h"
 #include "screen.h"
+#include "mega.h"
+#include "rom.h"
+#include "platform.h"
+#include "profiler.h"
+#include "hotspots.h"
+#include "stats.h"
 #include <stddef.h>
 
+// where chInit() puts the SUPER-CHIP 8x10 digits
+#define BIG_FONT_START 0x50
+
+// instructions executed between two 60 Hz timer ticks
+#define CYCLES_PER_FRAME 10
+
+struct AotRom;
+
 struct Chip8 {
     struct Memory memory;
+    struct Mega *mega; // MegaChip framebuffer, 0x00 on every other profile
+#ifdef CHIP8_PROFILE
+    struct Profiler *profiler; // call-graph profiler fed by the stack, 0x00 when off
+#endif
+#ifdef CHIP8_HOTSPOTS
+    struct Hotspots *hotspots; // opcode and PC counters fed by every engine, 0x00 when off
+#endif
     struct Stack stack;
     struct Registers registers;
     struct Keyboard keyboard;
     struct Screen screen;
+    unsigned int rng;            // xorshift32 state used by CXNN
+    unsigned long long cycles;   // instructions executed since chLoad()
+    unsigned long frames;        // timer ticks since chLoad()
+    unsigned long long rom_hash; // FNV-1a hash of the loaded ROM
+    unsigned char profile;       // enum Profile, selects the interpreter
+    const struct AotRom *aot;    // translated code for the ROM and profile, 0x00 to interpret (see inc/aot.h)
+    unsigned char pattern[16];   // XO-CHIP audio pattern buffer, F002
+    unsigned char pitch;         // XO-CHIP playback pitch, FX3A
+    struct Stats stats;          // runtime counters, see inc/stats.h
 };
 
 void chInit(struct Chip8* chip8);
-void chLoad(struct Chip8* chip8, const char* buf);
+void chFree(struct Chip8 *chip8);
+enum RomError chLoad(struct Chip8* chip8, const char* buf);
+enum RomError chLoadData(struct Chip8 *chip8, const unsigned char *data, size_t size);
+enum RomError chLoadDataAs(struct Chip8 *chip8, const unsigned char *data, size_t size, enum Profile profile);
+void chSetProfile(struct Chip8 *chip8, enum Profile profile);
+void chSeed(struct Chip8 *chip8, unsigned int seed);
+unsigned char chRandom(struct Chip8 *chip8);
 void execOpcode(struct Chip8* chip8, unsigned short opcode);
+void chStep(struct Chip8 *chip8);
+void chTick(struct Chip8 *chip8);
+void chFrame(struct Chip8 *chip8);
+unsigned long long chScreenHash(struct Chip8 *chip8);
 
-#endif
\ No newline at end of file
+#endif
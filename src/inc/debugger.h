@@ -0,0 +1,75 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include "chip8.h"
+#include <stdbool.h>
+
+/*
+    Breakpoints, watchpoints and single stepping. While a debugger has
+    nothing to do, dbgActive() is false and the front end keeps calling
+    chFrame(), so the interpreter runs exactly the code it runs without
+    one. Otherwise it calls dbgFrame(), which steps the frame one
+    instruction at a time with chStep() and checks before each of them:
+        breakpoints   one bit per address of the first 4 KB, where
+                      CHIP-8 and SUPER-CHIP code lives
+        watchpoints   a list of address ranges, only searched when a
+                      FX33, FX55 or 5XY2 stores to a page marked in a
+                      bit mask of the pages they cover
+    When the machine stops, stop() is called with the registers and memory
+    as they are before the instruction at PC; it returns once it has set
+    what to do next, see dbgStep(), dbgContinue() and dbgDetach(). Frames
+    still end with chTick(), so timers, replays and input logs see the
+    same cycles as without a debugger.
+*/
+#define DBG_ADDRESSES MEMORY_SIZE
+#define DBG_WATCHES 16
+
+enum DbgStop {
+    STOP_NONE,
+    STOP_INTERRUPT, // dbgInterrupt(), such as a key the front end binds to it
+    STOP_STEP,      // the instructions dbgStep() asked for have run
+    STOP_BREAK,     // PC reached a breakpoint
+    STOP_WATCH,     // the last instruction stored to a watched byte, see hit
+};
+
+struct DbgWatch {
+    unsigned int start; // first watched address
+    unsigned int len;   // watched bytes from there on
+};
+
+struct Debugger {
+    unsigned int breakpoints[DBG_ADDRESSES / 32];                 // one bit per address
+    unsigned int watch_pages[MEGA_MEMORY_SIZE / PAGE_SIZE / 32]; // one bit per page a watch covers
+    struct DbgWatch watches[DBG_WATCHES];
+    int watch_count;
+    int break_count;
+    int cycle;           // instructions of the current frame already run
+    unsigned long steps; // instructions to run before stopping, 0 to run freely
+    bool stopped;        // call stop() before the next instruction
+    bool resumed;        // PC is where the machine stopped, don't stop at its breakpoint again
+    bool quit;           // stop() asked to leave the emulator
+    enum DbgStop reason; // why the machine last stopped
+    unsigned int hit;    // the watched address written, for STOP_WATCH
+    // called when the machine stops, returns when it should run again
+    void (*stop)(struct Debugger *dbg, struct Chip8 *chip8);
+    void *data; // for stop()
+};
+
+void dbgInit(struct Debugger *dbg, void (*stop)(struct Debugger *dbg, struct Chip8 *chip8), void *data);
+int dbgBreak(struct Debugger *dbg, unsigned int addr, bool on);
+bool dbgIsBreak(struct Debugger *dbg, unsigned int addr);
+int dbgWatch(struct Debugger *dbg, unsigned int start, unsigned int len);
+int dbgUnwatch(struct Debugger *dbg, unsigned int start);
+void dbgInterrupt(struct Debugger *dbg);
+void dbgStep(struct Debugger *dbg, unsigned long count);
+void dbgContinue(struct Debugger *dbg);
+void dbgDetach(struct Debugger *dbg);
+void dbgFrame(struct Debugger *dbg, struct Chip8 *chip8);
+void dbgConsole(struct Debugger *dbg, struct Chip8 *chip8);
+
+// the front end calls dbgFrame() in place of chFrame() while this is true
+static inline bool dbgActive(struct Debugger *dbg) {
+    return dbg->stopped || dbg->steps > 0 || dbg->break_count > 0 || dbg->watch_count > 0 || dbg->cycle > 0;
+}
+
+#endif
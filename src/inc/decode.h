@@ -0,0 +1,121 @@
+#ifndef DECODE_H
+#define DECODE_H
+
+#include <stddef.h>
+
+/*
+    Instruction decoder shared by the interpreters, the disassembler and the
+    platform detection. opTable lists every instruction once, with the mask
+    and value that identify it, the extensions it needs and how it changes
+    control flow. decodeInit() expands it into one 64K-entry table per set of
+    extensions, so decoding is a single load and every tool sees exactly the
+    instruction set execOpcode() runs.
+*/
+
+// instruction set extensions, or-ed together to select a decode table
+#define ISA_SCHIP 0x1
+#define ISA_XOCHIP 0x2
+#define ISA_MEGACHIP 0x4
+#define ISA_SETS 8
+
+enum Op {
+    OP_UNKNOWN,   // not an instruction with these extensions, executes as a no-op
+    OP_SYS,       // 0NNN
+    OP_CLS,       // 00E0
+    OP_RET,       // 00EE
+    OP_SCD,       // 00CN
+    OP_SCU,       // 00DN
+    OP_SCR,       // 00FB
+    OP_SCL,       // 00FC
+    OP_EXIT,      // 00FD
+    OP_LOW,       // 00FE
+    OP_HIGH,      // 00FF
+    OP_MEGAOFF,   // 0010
+    OP_MEGAON,    // 0011
+    OP_SCRU,      // 00BN
+    OP_LDHI,      // 01NN NNNN
+    OP_LDPAL,     // 02NN
+    OP_SPRW,      // 03NN
+    OP_SPRH,      // 04NN
+    OP_ALPHA,     // 05NN
+    OP_DIGISND,   // 060N
+    OP_STOPSND,   // 0700
+    OP_BMODE,     // 080N
+    OP_CCOL,      // 09NN
+    OP_JP,        // 1NNN
+    OP_CALL,      // 2NNN
+    OP_SE_BYTE,   // 3XNN
+    OP_SNE_BYTE,  // 4XNN
+    OP_SE_REG,    // 5XY0
+    OP_SAVE,      // 5XY2
+    OP_LOAD,      // 5XY3
+    OP_LD_BYTE,   // 6XNN
+    OP_ADD_BYTE,  // 7XNN
+    OP_LD_REG,    // 8XY0
+    OP_OR,        // 8XY1
+    OP_AND,       // 8XY2
+    OP_XOR,       // 8XY3
+    OP_ADD_REG,   // 8XY4
+    OP_SUB,       // 8XY5
+    OP_SHR,       // 8XY6
+    OP_SUBN,      // 8XY7
+    OP_SHL,       // 8XYE
+    OP_SNE_REG,   // 9XY0
+    OP_LD_I,      // ANNN
+    OP_JP_V0,     // BNNN
+    OP_RND,       // CXNN
+    OP_DRW,       // DXYN
+    OP_SKP,       // EX9E
+    OP_SKNP,      // EXA1
+    OP_LD_LONG,   // F000 NNNN
+    OP_PLANE,     // FN01
+    OP_AUDIO,     // F002
+    OP_LD_VX_DT,  // FX07
+    OP_LD_VX_K,   // FX0A
+    OP_LD_DT,     // FX15
+    OP_LD_ST,     // FX18
+    OP_ADD_I,     // FX1E
+    OP_LD_F,      // FX29
+    OP_LD_HF,     // FX30
+    OP_LD_BCD,    // FX33
+    OP_PITCH,     // FX3A
+    OP_LD_MEM,    // FX55
+    OP_LD_VX_MEM, // FX65
+    OP_LD_R,      // FX75
+    OP_LD_VX_R,   // FX85
+    OPS,
+};
+
+// how an instruction leaves, for code walkers
+enum Flow {
+    FLOW_NEXT,     // falls through to the next instruction
+    FLOW_JUMP,     // goes to NNN
+    FLOW_CALL,     // calls NNN and comes back
+    FLOW_SKIP,     // may skip the next instruction
+    FLOW_RETURN,   // returns to the caller
+    FLOW_INDIRECT, // goes to an address computed at run time
+    FLOW_STOP,     // never leaves
+};
+
+struct OpInfo {
+    unsigned short mask;  // bits that identify the instruction
+    unsigned short match; // their value
+    unsigned char isa;    // ISA_* extensions it needs, 0 for CHIP-8
+    unsigned char flow;   // enum Flow
+    unsigned char size;   // bytes including the operand word, 2 or 4
+    const char *format;   // CHIPPER syntax, see formatOp()
+};
+
+// indexed by enum Op
+extern const struct OpInfo opTable[OPS];
+extern unsigned char decodeTables[ISA_SETS][65536];
+
+void decodeInit(void);
+int formatOp(char *buf, size_t len, unsigned short opcode, enum Op op, unsigned int operand, const char *label);
+
+// the instruction opcode is with the extensions in isa, decodeInit() must have run
+static inline enum Op decodeOp(unsigned int isa, unsigned short opcode) {
+    return decodeTables[isa & (ISA_SETS - 1)][opcode];
+}
+
+#endif
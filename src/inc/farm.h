@@ -0,0 +1,81 @@
+#ifndef FARM_H
+#define FARM_H
+
+#include "chip8.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+    Many machines in one process. Instances are dealt round-robin to the
+    worker threads and each worker owns its instances outright: it runs
+    every one of them at 60 Hz and catches up on frames it fell behind on,
+    up to FARM_MAX_BEHIND, dropping the rest.
+
+    What a worker measures lives in its own struct Worker, on cache lines
+    no other worker's counters share, and only that worker writes there.
+    The counters are _Atomic so farmWriteMetrics() may read them while the
+    worker runs, but the worker only does relaxed loads and stores of its
+    own values (see bump() in farm.c), plain moves on every target, never
+    a lock or a read-modify-write. farmWriteMetrics() sums the workers
+    into Prometheus text: instructions and frames, MIPS since the previous
+    call, per-ROM frame time histograms, instances that are running, idle
+    or stalled, and each worker's queue of frames due.
+*/
+#define FARM_MAX_ROMS 256
+#define FARM_MAX_WORKERS 64
+// frames an instance may owe before the older ones are dropped
+#define FARM_MAX_BEHIND 60
+// an instance without a finished frame for this long is stalled
+#define FARM_STALL_NS 1000000000LL
+// frame time histogram buckets, the last one is +Inf
+#define FARM_BUCKETS 13
+// what each worker's counters are aligned to, so two workers never write to the same line
+#define FARM_CACHE_LINE 64
+
+typedef _Atomic unsigned long long counter_t;
+
+struct Instance {
+    struct Chip8 chip8;
+    int rom;                      // index in farm->names
+    unsigned long long skipped;   // frames dropped, the schedule moved on without them
+    _Atomic long long last_frame; // CLOCK_MONOTONIC nanoseconds when its last frame ended
+    _Atomic bool idle;            // waiting for a key, or parked on 00FD or a jump to itself
+};
+
+struct Worker {
+    struct Farm *farm;
+    int id; // runs instances id, id + workers, ...
+    pthread_t thread;
+    // the counters start a cache line and, with the alignment, the next worker starts another
+    _Alignas(FARM_CACHE_LINE) counter_t instructions; // retired by its instances
+    counter_t frames;                                 // run by its instances
+    counter_t dropped;                                // skipped, see FARM_MAX_BEHIND
+    counter_t queue;    // frames overdue, due before the current tick and not run, when its last pass started
+    counter_t *buckets; // FARM_BUCKETS per ROM, not cumulative, on lines of their own
+    counter_t *sum_ns;  // per ROM, the same
+};
+
+struct Farm {
+    char names[FARM_MAX_ROMS][64]; // metric label of each ROM
+    int rom_count;
+    struct Instance *instances;
+    int instance_count;
+    struct Worker workers[FARM_MAX_WORKERS];
+    int worker_count;
+    long long start; // CLOCK_MONOTONIC nanoseconds, frame 0 of every instance
+    atomic_bool stop;
+    // only farmWriteMetrics() uses these
+    long long scraped;
+    unsigned long long scraped_instructions;
+};
+
+long long farmNow(void);
+int farmInit(struct Farm *farm, char **paths, int rom_count, int instances, int workers);
+int farmStart(struct Farm *farm);
+void farmStop(struct Farm *farm);
+void farmFree(struct Farm *farm);
+int farmWriteMetrics(struct Farm *farm, FILE *out);
+
+#endif
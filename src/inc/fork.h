@@ -0,0 +1,47 @@
+#ifndef FORK_H
+#define FORK_H
+
+#include "chip8.h"
+#include <stddef.h>
+
+/*
+    Copy-on-write forks of a machine for lookahead search.
+    A branch shares its memory pages with the branch it was forked from and
+    only owns a private copy of the pages its own run wrote to. Everything
+    after the memory in struct Chip8 (stack, registers, keyboard, screen,
+    RNG and counters) is small and copied whole, and so is the MegaChip
+    framebuffer of a MegaChip machine.
+
+    Branches are run on a ForkCursor: forkEnter() loads a branch into the
+    cursor's machine, copying only the pages that differ from what the
+    cursor already holds, and forkLeave() stores the run back, giving the
+    branch fresh pages for everything the run dirtied.
+*/
+#define FORK_MACHINE_SIZE (sizeof(struct Chip8) - offsetof(struct Chip8, stack))
+
+struct Page {
+    int refs;
+    unsigned char data[PAGE_SIZE];
+};
+
+struct Branch {
+    unsigned char machine[FORK_MACHINE_SIZE]; // struct Chip8 from the stack onwards
+    struct Mega *mega;                        // private copy, 0x00 if the machine has none
+    unsigned int count;                       // number of pages, set by the profile's memory size
+    struct Page *pages[];
+};
+
+struct ForkCursor {
+    struct Chip8 chip8;   // the machine branches run on
+    unsigned int count;   // number of entries in loaded
+    struct Page **loaded; // page mirrored in chip8's memory, 0x00 if none
+};
+
+struct Branch *forkRoot(struct Chip8 *chip8);
+struct Branch *forkBranch(struct Branch *parent);
+void forkEnter(struct ForkCursor *cursor, struct Branch *branch);
+void forkLeave(struct ForkCursor *cursor, struct Branch *branch);
+void forkRelease(struct Branch *branch);
+void forkCursorFree(struct ForkCursor *cursor);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef GDBSTUB_H
+#define GDBSTUB_H
+
+#include "debugger.h"
+#include <stdbool.h>
+
+/*
+    A GDB remote serial protocol server, a front end of the debugger (see
+    inc/debugger.h) for GDB, LLDB or anything else that speaks RSP. It
+    listens on a localhost TCP port or a Unix domain socket and serves one
+    client at a time. gdbStop() is the debugger's stop function: while the
+    machine is stopped it answers packets until the client continues,
+    steps, detaches or kills. While the machine runs, the front end calls
+    gdbPoll() once per frame, which only looks for a new client or a ^C;
+    without breakpoints or watchpoints the frames run through chFrame() as
+    usual, so a connected client that is not stepping costs one
+    non-blocking recv() per frame.
+
+    Registers, in the order g and G use and with the sizes of the target
+    description, little endian:
+        0-15 V0-VF 8 bits, 16 I 32 bits, 17 PC 16 bits,
+        18 SP 8 bits, 19 DT 8 bits, 20 ST 8 bits
+    Memory is the machine's memory, addresses wrap at its size. Z0 and Z1
+    set breakpoints, Z2 watchpoints.
+*/
+// largest packet either side sends, without the framing
+#define GDB_PACKET_SIZE 4096
+#define GDB_REGISTERS 21
+
+struct GdbStub {
+    int listener;  // listening socket, -1 if closed
+    int client;    // the connected client, -1 while there is none
+    bool running;  // the client continued or stepped and waits for a stop reply
+    bool no_ack;   // the client asked for QStartNoAckMode
+    char packet[GDB_PACKET_SIZE + 1];
+    unsigned char in[256]; // bytes received and not yet read
+    int in_len;
+    int in_pos;
+};
+
+int gdbOpen(struct GdbStub *stub, const char *address);
+void gdbPoll(struct GdbStub *stub, struct Debugger *dbg);
+void gdbStop(struct Debugger *dbg, struct Chip8 *chip8);
+void gdbClose(struct GdbStub *stub);
+
+#endif
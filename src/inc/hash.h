@@ -0,0 +1,11 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+
+#define HASH_INIT 0xcbf29ce484222325ULL
+unsigned long long hashUpdate(unsigned long long hash, const void *data, size_t len);
+unsigned long long hashBytes(const void *data, size_t len);
+unsigned long long hashCopy(void *dst, const void *src, size_t len);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef HOTSPOTS_H
+#define HOTSPOTS_H
+
+#include "decode.h"
+#include "memory.h"
+#include <stdio.h>
+
+/*
+    Opcode histogram and hot-PC counters, only built with -DCHIP8_HOTSPOTS.
+    Execution isn't counted instruction by instruction but by its jumps:
+    every time control doesn't run on from an instruction at pc to pc + 2
+    (a jump, call, return, taken skip, FX0A wait or 4-byte instruction),
+    one flow is taken from pc + 2 and given to where it went. An address
+    then runs as often as the one two bytes before it, plus its flow, so
+    the count at every address is a running sum up to the PC the machine
+    stopped at, worked out when the counters are written. Straight-line
+    code costs nothing: the interpreters count in JUMP() (inc/interp.h)
+    and translated ROMs (inc/aot.h) at their own jumps, so they stay
+    translated. The opcode family (the top nibble) and instruction counts
+    are summed up by decoding what is in memory at each address then, so
+    for code the ROM modified they show the last version. All three are
+    written sorted by count, as a report and as CSV.
+
+    PC changes from outside the machine have to be counted with hotJump()
+    too; chip8 does it for quick loads and rewind, the debugger's are not.
+    Running off 0xFFFE into 0 isn't counted.
+*/
+// every value of the 16-bit PC, CHIP-8 and SUPER-CHIP only run from the first 4 KB
+#define HOT_ADDRESSES 65536
+#define HOT_FAMILIES 16
+
+struct Hotspots {
+    long long flow[HOT_ADDRESSES]; // jumps to each address less jumps away from the instruction before it
+};
+
+void hotInit(struct Hotspots *hot, unsigned short pc);
+int hotWriteReport(struct Hotspots *hot, FILE *out, struct Memory *memory, unsigned int isa, unsigned short pc);
+int hotWriteCsv(struct Hotspots *hot, FILE *out, struct Memory *memory, unsigned int isa, unsigned short pc);
+
+// control went to target instead of next, the address after the instruction that ran,
+// called by the interpreters and translations while chip8->hotspots is set
+static inline void hotJump(struct Hotspots *hot, unsigned short next, unsigned short target) {
+    hot->flow[next]--;
+    hot->flow[target]++;
+}
+
+// the same jump count times
+static inline void hotJumps(struct Hotspots *hot, unsigned short next, unsigned short target, long long count) {
+    hot->flow[next] -= count;
+    hot->flow[target] += count;
+}
+
+#endif
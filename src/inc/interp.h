@@ -0,0 +1,624 @@
+/*
+    Interpreter template, deliberately without an include guard.
+    chip8.c includes this file once per quirk profile after defining:
+        INTERP_EXEC      name of the generated execute function
+        INTERP_FRAME     name of the generated frame function
+        QUIRK_SHIFT_VY   8XY6/8XYE shift VY into VX instead of shifting VX
+        QUIRK_INC_I      FX55/FX65 leave I pointing past the last register
+        QUIRK_JUMP_VX    BXNN jumps to XNN + VX instead of NNN + V0
+        QUIRK_CLIP       sprites are clipped at the screen edges instead of wrapped
+        HAS_SCHIP        SUPER-CHIP instructions: 00CN, 00FB-00FF, DXY0, FX30, FX75, FX85
+        HAS_XOCHIP       XO-CHIP instructions: 00DN, 5XY2, 5XY3, F000 NNNN, FN01, F002, FX3A,
+                         plane-aware drawing and skips over the 4-byte F000 NNNN
+        HAS_MEGACHIP     MegaChip instructions: 0010, 0011, 00BN, 01NN NNNN, 02NN-05NN,
+                         060N, 0700, 080N, 09NN, and the 256x192 screen once 0010 is run
+    The extensions pick the decode table (see inc/decode.h), so an opcode the
+    profile lacks decodes as OP_UNKNOWN and runs as a no-op.
+    The quirks are compile-time constants, so each profile gets its own
+    straight-line code and pays nothing per instruction for the others.
+*/
+
+#define INTERP_ISA (HAS_SCHIP * ISA_SCHIP | HAS_XOCHIP * ISA_XOCHIP | HAS_MEGACHIP * ISA_MEGACHIP)
+
+// moves PC, already past the instruction, to target, and counts it for the hotspots (see inc/hotspots.h)
+#ifdef CHIP8_HOTSPOTS
+#define JUMP(target)                                           \
+    do {                                                       \
+        unsigned short to = (target);                          \
+        if (chip8->hotspots != 0x00) {                         \
+            hotJump(chip8->hotspots, chip8->registers.PC, to); \
+        }                                                      \
+        chip8->registers.PC = to;                              \
+    } while (0)
+#else
+#define JUMP(target) (chip8->registers.PC = (target))
+#endif
+
+#if HAS_XOCHIP
+#define SKIP() JUMP(chip8->registers.PC + (mergeBytes(&chip8->memory, chip8->registers.PC) == 0xF000 ? 4 : 2))
+#else
+#define SKIP() JUMP(chip8->registers.PC + 2)
+#endif
+
+static inline void INTERP_EXEC(struct Chip8 *chip8, unsigned short opcode) {
+
+    // https://en.wikipedia.org/wiki/CHIP-8
+    // https://tobiasvl.github.io/blog/write-a-chip-8-emulator/
+
+    // x and y = instructions like 5XY0
+    // X: The second nibble.
+    // Used to look up one of the 16 registers (VX)
+    // from V0 through VF.
+    unsigned char X = (opcode & 0x0F00) >> 8;
+    // Y: The third nibble.
+    // Also used to look up one of the 16 registers (VY)
+    // from V0 through VF.
+    unsigned char Y = (opcode & 0x00F0) >> 4;
+    // N: The fourth nibble. A 4-bit number.
+    unsigned char N = opcode & 0x000F;
+    // NN: The second byte (third and fourth nibbles).
+    // An 8-bit immediate number.
+    unsigned char NN = opcode & 0x00FF;
+    // NNN: The second, third and fourth nibbles.
+    // A 12-bit immediate memory address.
+    unsigned short NNN = opcode & 0x0FFF;
+
+    // one load from the decode table shared with chip8-dis, see inc/decode.h;
+    // instructions the profile doesn't have decode as OP_UNKNOWN and do nothing
+    switch (decodeOp(INTERP_ISA, opcode)) {
+    // 00E0: Clears the screen
+    // (MegaChip mode: shows the finished picture, then clears)
+    case OP_CLS: {
+        trace("0x%X: 00E0\n", opcode);
+        chip8->stats.clears++;
+#if HAS_MEGACHIP
+        if (chip8->mega->enabled) {
+            megaPresent(chip8->mega);
+            break;
+        }
+#endif
+        clearScreen(&chip8->screen);
+    } break;
+    // 00EE: Return from subroutine
+    case OP_RET: {
+        trace("0x%X: 00EE\n", opcode);
+        JUMP(stackPop(chip8));
+    } break;
+#if HAS_SCHIP
+    // 00CN: Scrolls the screen N rows down
+    case OP_SCD: {
+        trace("0x%X: 00CN\n", opcode);
+#if HAS_MEGACHIP
+        if (chip8->mega->enabled) {
+            megaScroll(chip8->mega, 0, N);
+            break;
+        }
+#endif
+        scrollDown(&chip8->screen, N);
+    } break;
+    // 00FB: Scrolls the screen 4 pixels right
+    case OP_SCR: {
+        trace("0x%X: 00FB\n", opcode);
+#if HAS_MEGACHIP
+        if (chip8->mega->enabled) {
+            megaScroll(chip8->mega, 4, 0);
+            break;
+        }
+#endif
+        scrollRight(&chip8->screen);
+    } break;
+    // 00FC: Scrolls the screen 4 pixels left
+    case OP_SCL: {
+        trace("0x%X: 00FC\n", opcode);
+#if HAS_MEGACHIP
+        if (chip8->mega->enabled) {
+            megaScroll(chip8->mega, -4, 0);
+            break;
+        }
+#endif
+        scrollLeft(&chip8->screen);
+    } break;
+    // 00FD: Exits the interpreter, the program stays on this instruction
+    case OP_EXIT: {
+        trace("0x%X: 00FD\n", opcode);
+        JUMP(chip8->registers.PC - 2);
+    } break;
+    // 00FE: Switches to 64x32 low resolution
+    case OP_LOW: {
+        trace("0x%X: 00FE\n", opcode);
+        setHires(&chip8->screen, false);
+    } break;
+    // 00FF: Switches to 128x64 high resolution
+    case OP_HIGH: {
+        trace("0x%X: 00FF\n", opcode);
+        setHires(&chip8->screen, true);
+    } break;
+#endif
+#if HAS_XOCHIP
+    // 00DN: Scrolls the screen N rows up
+    case OP_SCU: {
+        trace("0x%X: 00DN\n", opcode);
+        scrollUp(&chip8->screen, N);
+    } break;
+#endif
+#if HAS_MEGACHIP
+    // 0010: Switches MegaChip mode off
+    case OP_MEGAOFF: {
+        trace("0x%X: 0010\n", opcode);
+        megaSetMode(chip8->mega, false);
+    } break;
+    // 0011: Switches MegaChip mode on, 256x192 with 256 colours
+    case OP_MEGAON: {
+        trace("0x%X: 0011\n", opcode);
+        megaSetMode(chip8->mega, true);
+    } break;
+    // 00BN: Scrolls the screen N rows up, MegaChip mode only
+    case OP_SCRU: {
+        if (chip8->mega->enabled) {
+            trace("0x%X: 00BN\n", opcode);
+            megaScroll(chip8->mega, 0, -N);
+        }
+    } break;
+    // 01NN NNNN: Sets I to the 24-bit address NN NNNN, the low 16 bits are the next two bytes
+    case OP_LDHI: {
+        trace("0x%X: 01NN\n", opcode);
+        chip8->registers.I = NN << 16 | mergeBytes(&chip8->memory, chip8->registers.PC);
+        JUMP(chip8->registers.PC + 2);
+    } break;
+    // 02NN: Loads NN ARGB colours from memory at I into palette entries 1 to NN
+    case OP_LDPAL: {
+        trace("0x%X: 02NN\n", opcode);
+        megaLoadPalette(chip8->mega, &chip8->memory, chip8->registers.I, NN);
+    } break;
+    // 03NN: Sets the sprite width to NN (0 is 256)
+    case OP_SPRW: {
+        trace("0x%X: 03NN\n", opcode);
+        chip8->mega->sprite_width = NN;
+    } break;
+    // 04NN: Sets the sprite height to NN (0 is 256)
+    case OP_SPRH: {
+        trace("0x%X: 04NN\n", opcode);
+        chip8->mega->sprite_height = NN;
+    } break;
+    // 05NN: Sets the screen alpha to NN
+    case OP_ALPHA: {
+        trace("0x%X: 05NN\n", opcode);
+        chip8->mega->alpha = NN;
+    } break;
+    // 060N, 0700: Plays and stops the sample at I, there is no audio output to send it to
+    case OP_DIGISND:
+    case OP_STOPSND: {
+        trace("0x%X: 0%X00\n", opcode, X);
+    } break;
+    // 080N: Selects sprite blend mode N
+    case OP_BMODE: {
+        trace("0x%X: 080N\n", opcode);
+        chip8->mega->blend = N;
+    } break;
+    // 09NN: Drawing over palette index NN sets VF
+    case OP_CCOL: {
+        trace("0x%X: 09NN\n", opcode);
+        chip8->mega->collision = NN;
+    } break;
+#endif
+    // 1NNN: Jumps to address NNN
+    case OP_JP: {
+        trace("0x%X: 1NNN\n", opcode);
+        JUMP(NNN);
+    } break;
+    // 2NNN: Calls subroutine at NNN
+    case OP_CALL: {
+        trace("0x%X: 2NNN\n", opcode);
+        stackPush(chip8, chip8->registers.PC);
+        JUMP(NNN);
+
+    } break;
+
+    // 3XNN: Skips the next instruction if Vx equals NN
+    case OP_SE_BYTE: {
+        trace("0x%X: 3XNN\n", opcode);
+        if (chip8->registers.V[X] == NN) {
+            SKIP();
+        }
+    } break;
+    // 4XNN: Skips the next instruction if Vx !equal NN
+    case OP_SNE_BYTE: {
+        trace("0x%X: 4XNN\n", opcode);
+        if (chip8->registers.V[X] != NN) {
+            SKIP();
+        }
+    } break;
+
+    // 5XY0: Skips the next instruction if Vx equals Vy
+    case OP_SE_REG: {
+        trace("0x%X: 5XY0\n", opcode);
+        if (chip8->registers.V[X] == chip8->registers.V[Y]) {
+            SKIP();
+        }
+    } break;
+#if HAS_XOCHIP
+    // 5XY2: Stores VX to VY (in either order) in memory, starting at address I.
+    // 5XY3: Fills VX to VY (in either order) from memory, starting at address I.
+    // I is left unmodified.
+    case OP_SAVE:
+    case OP_LOAD: {
+        trace("0x%X: 5XY%X\n", opcode, N);
+        int step = X <= Y ? 1 : -1;
+        for (int i = 0; i <= abs(Y - X); i++) {
+            if (N == 2) {
+                setMemory(&chip8->memory, chip8->registers.I + i, chip8->registers.V[X + i * step]);
+            } else {
+                chip8->registers.V[X + i * step] = getMemory(&chip8->memory, chip8->registers.I + i);
+            }
+        }
+    } break;
+#endif
+
+    // 6XNN: Sets Vx to NN
+    case OP_LD_BYTE: {
+        trace("0x%X: 6XNN\n", opcode);
+        chip8->registers.V[X] = NN;
+    } break;
+
+    // 7XNN: Adds NN to Vx
+    case OP_ADD_BYTE: {
+        trace("0x%X: 7XNN\n", opcode);
+        chip8->registers.V[X] += NN;
+    } break;
+
+    // 8XY0: Sets Vx to the value of Vy
+    case OP_LD_REG: {
+        trace("0x%X: 8XY0\n", opcode);
+        chip8->registers.V[X] = chip8->registers.V[Y];
+    } break;
+
+    // 8XY1: Sets VX to VX or VY. (bitwise OR operation)
+    case OP_OR: {
+        trace("0x%X: 8XY1\n", opcode);
+        chip8->registers.V[X] = chip8->registers.V[X] | chip8->registers.V[Y];
+    } break;
+
+    // 8XY2: Sets VX to VX and VY. (bitwise AND operation)
+    case OP_AND: {
+        trace("0x%X: 8XY2\n", opcode);
+        chip8->registers.V[X] = chip8->registers.V[X] & chip8->registers.V[Y];
+    } break;
+
+    // 8XY3: Sets VX to VX xor VY (bitwise OR operation)
+    case OP_XOR: {
+        trace("0x%X: 8XY3\n", opcode);
+        chip8->registers.V[X] = chip8->registers.V[X] ^ chip8->registers.V[Y];
+    } break;
+
+    // 8XY4: Adds VY to VX. VF is set to 1 when there's a carry,
+    // and to 0 when there is not.
+    case OP_ADD_REG: {
+        trace("0x%X: 8XY4\n", opcode);
+        unsigned short tmp = 0;
+        tmp = chip8->registers.V[X] + chip8->registers.V[Y];
+        chip8->registers.V[0x0F] = false;
+        if (tmp > 0xFF) {
+            chip8->registers.V[0x0F] = true;
+        }
+        chip8->registers.V[X] = tmp;
+    } break;
+
+    // 8XY5: VY is subtracted from VX. VF is set to 0 when there's a borrow,
+    // and 1 when there is not.
+    case OP_SUB: {
+        trace("0x%X: 8XY5\n", opcode);
+        chip8->registers.V[0x0F] = false;
+        if (chip8->registers.V[X] > chip8->registers.V[Y]) {
+            chip8->registers.V[0x0F] = true;
+        }
+        chip8->registers.V[X] = chip8->registers.V[X] - chip8->registers.V[Y];
+    } break;
+
+    // 8XY6: Stores the least significant bit of VX in VF
+    // and then shifts VX to the right by 1
+    // (QUIRK_SHIFT_VY: VY is shifted and the result stored in VX)
+    case OP_SHR: {
+        trace("0x%X: 8XY6\n", opcode);
+#if QUIRK_SHIFT_VY
+        unsigned char value = chip8->registers.V[Y];
+#else
+        unsigned char value = chip8->registers.V[X];
+#endif
+        chip8->registers.V[0x0F] = value & 0x01;
+        chip8->registers.V[X] = value >> 1;
+    } break;
+
+    // 8XY7: Sets VX to VY minus VX. VF is set to 0 when there's a borrow,
+    // and 1 when there is not.
+    case OP_SUBN: {
+        trace("0x%X: 8XY7\n", opcode);
+        chip8->registers.V[0x0F] = chip8->registers.V[Y] > chip8->registers.V[X];
+        chip8->registers.V[X] = chip8->registers.V[Y] - chip8->registers.V[X];
+    } break;
+
+    // 8XYE: Stores the most significant bit of VX in VF
+    // and then shifts VX to the left by 1
+    // (QUIRK_SHIFT_VY: VY is shifted and the result stored in VX)
+    case OP_SHL: {
+        trace("0x%X: 8XYE\n", opcode);
+#if QUIRK_SHIFT_VY
+        unsigned char value = chip8->registers.V[Y];
+#else
+        unsigned char value = chip8->registers.V[X];
+#endif
+        chip8->registers.V[0x0F] = value >> 7;
+        chip8->registers.V[X] = value << 1;
+    } break;
+
+    // 9XY0: Skips the next instruction if VX does not equal VY.
+    // (Usually the next instruction is a jump to skip a code block);
+    case OP_SNE_REG: {
+        trace("0x%X: 9XY0\n", opcode);
+        if (chip8->registers.V[X] != chip8->registers.V[Y]) {
+            SKIP();
+        }
+    } break;
+
+    // ANNN: Sets I to the address NNN.
+    case OP_LD_I: {
+        trace("0x%X: ANNN\n", opcode);
+        chip8->registers.I = NNN;
+    } break;
+
+    // BNNN: Jumps to the address NNN plus V0.
+    // (QUIRK_JUMP_VX: BXNN jumps to XNN plus VX)
+    case OP_JP_V0: {
+        trace("0x%X: BNNN\n", opcode);
+#if QUIRK_JUMP_VX
+        JUMP(NNN + chip8->registers.V[X]);
+#else
+        JUMP(NNN + chip8->registers.V[0x00]);
+#endif
+    } break;
+    // CXNN: Sets VX to the result of a bitwise and operation
+    // on a random number (Typically: 0 to 255) and NN.
+    // 0xFF == 255
+    case OP_RND: {
+        trace("0x%X: CXNN\n", opcode);
+        chip8->registers.V[X] = chRandom(chip8) & NN;
+    } break;
+
+    // DXYN - DRW Vx, Vy, nibble. Draws sprite to the screen
+    // bool drawSprite(struct Screen *screen, int x, int y, const char *sprite, int num)
+    case OP_DRW: {
+        trace("0x%X: DXYN\n", opcode);
+        // the sprite is copied out so one at the end of memory wraps like every other access;
+        // 64 bytes is the most any DXYN reads outside MegaChip mode, two planes of 16x16
+        unsigned char data[64];
+        const char *sprite = (const char *)data;
+#if HAS_MEGACHIP
+        // sprite_width x sprite_height palette indices in MegaChip mode
+        if (chip8->mega->enabled) {
+            chip8->registers.V[0x0F] = statsDraw(&chip8->stats, megaBlit(chip8->mega, chip8->registers.V[X],
+                                                                         chip8->registers.V[Y], &chip8->memory,
+                                                                         chip8->registers.I));
+            break;
+        }
+#endif
+#if HAS_XOCHIP
+        // every selected plane, 16x16 when N is 0
+        int planes = (chip8->screen.planes & 1) + (chip8->screen.planes >> 1 & 1);
+        memRead(&chip8->memory, chip8->registers.I, data, planes * (N ? N : 32));
+        chip8->registers.V[0x0F] = statsDraw(
+            &chip8->stats, drawSpritePlanes(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite, N));
+        break;
+#endif
+#if HAS_SCHIP
+        // DXY0: Draws a 16x16 sprite
+        if (N == 0) {
+            memRead(&chip8->memory, chip8->registers.I, data, 32);
+#if QUIRK_CLIP
+            chip8->registers.V[0x0F] = statsDraw(
+                &chip8->stats,
+                drawLargeSpriteClipped(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite));
+#else
+            chip8->registers.V[0x0F] = statsDraw(
+                &chip8->stats, drawLargeSprite(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite));
+#endif
+            break;
+        }
+#endif
+        memRead(&chip8->memory, chip8->registers.I, data, N);
+#if QUIRK_CLIP
+        chip8->registers.V[0x0F] = statsDraw(
+            &chip8->stats, drawSpriteClipped(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite, N));
+#else
+        chip8->registers.V[0x0F] = statsDraw(
+            &chip8->stats, drawSprite(&chip8->screen, chip8->registers.V[X], chip8->registers.V[Y], sprite, N));
+#endif
+    } break;
+
+    // EX9E: Skips the next instruction if the key stored in VX is pressed (usually the next instruction is a jump
+    // to skip a code block).
+    case OP_SKP: {
+        trace("0x%X: EX9E\n", opcode);
+        if (keyIsDown(&chip8->keyboard, chip8->registers.V[X])) {
+            SKIP();
+        }
+    } break;
+
+    // EXA1: Skips the next instruction if the key stored in VX is not pressed (usually the next instruction is a
+    // jump to skip a code block).
+    case OP_SKNP: {
+        trace("0x%X: EXA1\n", opcode);
+        if (!keyIsDown(&chip8->keyboard, chip8->registers.V[X])) {
+            SKIP();
+        }
+    } break;
+
+#if HAS_XOCHIP
+    // F000 NNNN: Sets I to the 16-bit address in the next two bytes.
+    case OP_LD_LONG: {
+        trace("0x%X: F000\n", opcode);
+        chip8->registers.I = mergeBytes(&chip8->memory, chip8->registers.PC);
+        JUMP(chip8->registers.PC + 2);
+    } break;
+    // FN01: Selects the planes in N for drawing, clearing and scrolling.
+    case OP_PLANE: {
+        trace("0x%X: FN01\n", opcode);
+        chip8->screen.planes = X & 0x03;
+    } break;
+    // F002: Loads the 16-byte audio pattern from memory at I.
+    case OP_AUDIO: {
+        trace("0x%X: F002\n", opcode);
+        for (int i = 0; i < 16; i++) {
+            chip8->pattern[i] = getMemory(&chip8->memory, chip8->registers.I + i);
+        }
+    } break;
+    // FX3A: Sets the audio pitch to VX.
+    case OP_PITCH: {
+        trace("0x%X: FX3A\n", opcode);
+        chip8->pitch = chip8->registers.V[X];
+    } break;
+#endif
+    // FX07: Sets VX to the value of the delay timer.
+    case OP_LD_VX_DT: {
+        trace("0x%X: EX07\n", opcode);
+        chip8->registers.V[X] = chip8->registers.delay_timer;
+    } break;
+    // FX0A: A key press is awaited, and then stored in VX
+    // (blocking operation, all instruction halted until next key event).
+    // the instruction is repeated until the front-end reports a key press,
+    // so timers keep running and no SDL call is needed here
+    case OP_LD_VX_K: {
+        trace("0x%X: FX0A\n", opcode);
+        if (!chip8->keyboard.waiting) {
+            chip8->stats.key_waits++;
+            chip8->keyboard.waiting = true;
+            chip8->keyboard.pressed = -1;
+        }
+        if (chip8->keyboard.pressed == -1) {
+            JUMP(chip8->registers.PC - 2);
+        } else {
+            chip8->registers.V[X] = chip8->keyboard.pressed;
+            chip8->keyboard.waiting = false;
+        }
+    } break;
+    // FX15: Sets the delay timer to VX.
+    case OP_LD_DT: {
+        trace("0x%X: FX15\n", opcode);
+        chip8->registers.delay_timer = chip8->registers.V[X];
+    } break;
+
+    // FX18: Sets the sound timer to VX.
+    case OP_LD_ST: {
+        trace("0x%X: FX18\n", opcode);
+        chip8->registers.sound_timer = chip8->registers.V[X];
+    } break;
+    // FX1E: Adds VX to I. VF is not affected
+    case OP_ADD_I: {
+        trace("0x%X: FX1E\n", opcode);
+        chip8->registers.I += chip8->registers.V[X];
+    } break;
+
+    // FX29: Sets I to the location of the sprite for the character in VX.
+    // Characters 0-F (in hexadecimal) are represented by a 4x5 font.
+    case OP_LD_F: {
+        trace("0x%X: FX29\n", opcode);
+        chip8->registers.I = chip8->registers.V[X] * 5;
+    } break;
+#if HAS_SCHIP
+
+    // FX30: Sets I to the location of the 8x10 sprite for the digit in VX.
+    case OP_LD_HF: {
+        trace("0x%X: FX30\n", opcode);
+        chip8->registers.I = BIG_FONT_START + (chip8->registers.V[X] & 0x0F) * 10;
+    } break;
+
+    // FX75: Stores V0 to VX (including VX) in the RPL user flags.
+    case OP_LD_R: {
+        trace("0x%X: FX75\n", opcode);
+        memcpy(chip8->registers.flags, chip8->registers.V, X + 1);
+    } break;
+
+    // FX85: Fills V0 to VX (including VX) from the RPL user flags.
+    case OP_LD_VX_R: {
+        trace("0x%X: FX85\n", opcode);
+        memcpy(chip8->registers.V, chip8->registers.flags, X + 1);
+    } break;
+#endif
+
+    // FX33: Stores the binary-coded decimal representation of VX,
+    // with the hundreds digit in memory at location in I,
+    // the tens digit at location I + 1,
+    // and the ones digit at location I + 2.
+    case OP_LD_BCD: {
+        trace("0x%X: FX33\n", opcode);
+        unsigned char hundreds = chip8->registers.V[X] / 100;
+        unsigned char tens = chip8->registers.V[X] / 10 % 10;
+        unsigned char units = chip8->registers.V[X] % 10;
+        setMemory(&chip8->memory, chip8->registers.I, hundreds);
+        setMemory(&chip8->memory, chip8->registers.I + 1, tens);
+        setMemory(&chip8->memory, chip8->registers.I + 2, units);
+    } break;
+
+    // FX55: Stores from V0 to VX (including VX) in memory, starting at address I.
+    // The offset from I is increased by 1 for each value written,
+    // but I itself is left unmodified (QUIRK_INC_I: I ends up at I + X + 1).
+    case OP_LD_MEM: {
+        trace("0x%X: FX55\n", opcode);
+        for (int i = 0; i <= X; i++) {
+            setMemory(&chip8->memory, chip8->registers.I + i, chip8->registers.V[i]);
+        }
+#if QUIRK_INC_I
+        chip8->registers.I += X + 1;
+#endif
+    } break;
+
+    // FX65: Fills from V0 to VX (including VX) with values from memory, starting at address I.
+    // The offset from I is increased by 1 for each value read,
+    // but I itself is left unmodified (QUIRK_INC_I: I ends up at I + X + 1).
+    case OP_LD_VX_MEM: {
+        trace("0x%X: FX65\n", opcode);
+        for (int i = 0; i <= X; i++) {
+            chip8->registers.V[i] = getMemory(&chip8->memory, chip8->registers.I + i);
+        }
+#if QUIRK_INC_I
+        chip8->registers.I += X + 1;
+#endif
+    } break;
+
+    // 0NNN: Calls the machine code routine at NNN, which no interpreter here has
+    default:
+        chip8->stats.unknown++;
+        break;
+    }
+}
+
+/**
+ * @brief INTERP_FRAME(chip8) runs one 60 Hz frame with INTERP_EXEC inlined
+ * into the fetch loop
+ */
+static void INTERP_FRAME(struct Chip8 *chip8) {
+    for (int i = 0; i < CYCLES_PER_FRAME; i++) {
+        unsigned short pc = chip8->registers.PC;
+        unsigned short opcode = mergeBytes(&chip8->memory, pc);
+        chip8->registers.PC += 2;
+        INTERP_EXEC(chip8, opcode);
+#ifdef CHIP8_CHECKED
+        if (chip8->memory.faulted) {
+            reportFault(chip8, pc, opcode);
+        }
+#endif
+        chip8->cycles++;
+    }
+    chTick(chip8);
+}
+
+#undef INTERP_EXEC
+#undef INTERP_FRAME
+#undef QUIRK_SHIFT_VY
+#undef QUIRK_INC_I
+#undef QUIRK_JUMP_VX
+#undef QUIRK_CLIP
+#undef HAS_SCHIP
+#undef HAS_XOCHIP
+#undef HAS_MEGACHIP
+#undef INTERP_ISA
+#undef SKIP
+#undef JUMP
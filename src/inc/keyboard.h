@@ -6,6 +6,8 @@
 struct Keyboard {
     bool keyboard[TOTAL_KEYS];
     const char *keyboard_map;
+    bool waiting; // FX0A is waiting for a key press
+    char pressed; // key pressed while waiting, -1 if none yet
 };
 
 void setMap(struct Keyboard *keyboard, const char *map);
@@ -14,4 +16,4 @@ void keyDown(struct Keyboard *keyboard, int key);
 void keyUp(struct Keyboard *keyboard, int key);
 bool keyIsDown(struct Keyboard *keyboard, int key);
 
-#endif
\ No newline at end of file
+#endif
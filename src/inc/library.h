@@ -0,0 +1,43 @@
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include "platform.h"
+#include <stdbool.h>
+
+/*
+    Persistent index of a ROM directory tree. The index file is plain text,
+    a "chip8-index 1" header followed by one tab separated line per ROM:
+        hash  size  mtime  platform  profile  path
+    A rescan only reads files whose size or mtime changed, and keeps the
+    profile of unchanged files so it can be edited by hand.
+*/
+#define LIBRARY_VERSION 1
+
+struct LibraryEntry {
+    char *path;
+    unsigned long long size;
+    long long mtime; // nanoseconds since the epoch
+    unsigned long long hash;
+    unsigned char platform; // enum Platform
+    unsigned char profile;  // enum Profile
+    bool seen;              // found by the current scan
+};
+
+struct Library {
+    struct LibraryEntry *entries;
+    int count;
+    int capacity;
+    int *by_hash; // open addressing tables of entry indices, -1 if empty
+    int *by_path;
+    int slots;    // size of both tables, a power of two
+    int hashed;   // files read by the last scan
+};
+
+void libraryInit(struct Library *library);
+int libraryLoad(struct Library *library, const char *path);
+int libraryScan(struct Library *library, const char *dir);
+int librarySave(struct Library *library, const char *path);
+struct LibraryEntry *libraryFind(struct Library *library, unsigned long long hash);
+void libraryFree(struct Library *library);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef LISTEN_H
+#define LISTEN_H
+
+/*
+    The local sockets the debugger stub and the metrics endpoint serve on.
+    An address that is a port number listens on 127.0.0.1 only, anything
+    else is the path of a Unix domain socket, replaced if it exists.
+*/
+int listenOn(const char *address, int backlog);
+
+#endif
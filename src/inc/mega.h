@@ -0,0 +1,39 @@
+#ifndef MEGA_H
+#define MEGA_H
+
+#include "memory.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// MegaChip framebuffer, one palette index per pixel
+#define MEGA_WIDTH 256
+#define MEGA_HEIGHT 192
+#define MEGA_COLOURS 256
+
+/*
+    MegaChip draws into pixels and only shows the picture when the program
+    clears the screen with 00E0, which copies pixels to front first, so the
+    front-end never sees a half-drawn frame. Sprites are sprite_width x
+    sprite_height bytes of palette indices, index 0 is transparent and
+    every other index replaces what is under it.
+*/
+struct Mega {
+    unsigned char pixels[MEGA_HEIGHT][MEGA_WIDTH]; // being drawn
+    unsigned char front[MEGA_HEIGHT][MEGA_WIDTH];  // last picture presented by 00E0
+    uint32_t palette[MEGA_COLOURS];                // ARGB, loaded by 02NN
+    unsigned char sprite_width;                    // 03NN, 0 means 256
+    unsigned char sprite_height;                   // 04NN, 0 means 256
+    unsigned char collision;                       // 09NN, drawing over this index sets VF
+    unsigned char blend;                           // 080N blend mode
+    unsigned char alpha;                           // 05NN screen alpha
+    bool enabled;                                  // 0011 on, 0010 off
+};
+
+void megaSetMode(struct Mega *mega, bool enabled);
+void megaPresent(struct Mega *mega);
+void megaLoadPalette(struct Mega *mega, struct Memory *memory, unsigned int index, int num);
+bool megaBlit(struct Mega *mega, int x, int y, struct Memory *memory, unsigned int index);
+void megaScroll(struct Mega *mega, int dx, int dy);
+unsigned long long megaHash(struct Mega *mega, unsigned long long hash);
+
+#endif
@@ -1,11 +1,91 @@
 #ifndef MEMORY_H
 #define MEMORY_H
 
+#include <stdbool.h>
+
+// CHIP-8 and SUPER-CHIP address 4 KB, XO-CHIP 64 KB, MegaChip 32 MB
 #define MEMORY_SIZE 4096
+#define XO_MEMORY_SIZE 65536
+#define MEGA_MEMORY_SIZE (32 << 20)
+// memory is tracked in pages for copy-on-write forks
+#define PAGE_SIZE 256
+/*
+    Every address the program computes is wrapped with & (size - 1), so a
+    store at I = 0xFFF + 2 lands at 0x001 instead of past the end of the
+    buffer and the accessors have no branch. Build with -DCHIP8_CHECKED to
+    also count the accesses that needed wrapping; the interpreter then
+    reports PC, opcode and address for each of them.
+*/
 struct Memory {
-    unsigned char memory[MEMORY_SIZE];
+    unsigned char *memory; // size bytes, allocated by memResize()
+    unsigned int size;     // a power of two, set per profile
+    unsigned int *dirty;   // one bit per page written by setMemory()
+#ifdef CHIP8_CHECKED
+    unsigned long violations; // out of range memory and stack accesses so far
+    bool faulted;             // set by memFault(), cleared by the interpreter
+    unsigned int fault;       // first out of range address of the current instruction
+#endif
 };
-unsigned char getMemory(struct Memory *memory, int index);
-unsigned short mergeBytes(struct Memory *memory, int index);
+void memResize(struct Memory *memory, unsigned int size);
+void memFree(struct Memory *memory);
+int memPages(struct Memory *memory);
+bool pageIsDirty(struct Memory *memory, int page);
+void clearDirty(struct Memory *memory);
+
+#ifdef CHIP8_CHECKED
+// violations past this many are only counted
+#define CHECKED_REPORTS 32
+void memFault(struct Memory *memory, unsigned int index);
+#define memCheck(memory, index) ((index) >= (memory)->size ? memFault(memory, index) : (void)0)
+#else
+#define memCheck(memory, index) ((void)0)
+#endif
+
+static inline unsigned char getMemory(struct Memory *memory, unsigned int index) {
+    memCheck(memory, index);
+    return memory->memory[index & (memory->size - 1)];
+}
+
+/**
+ * @brief setMemory(memory, index, value) is used for every store the program makes,
+ * it also marks the page as dirty so forks know what to copy
+ * @param memory chip8's memory
+ * @param index the address to write, wrapped to the memory size
+ * @param value the byte to store
+ * @return void
+ */
+static inline void setMemory(struct Memory *memory, unsigned int index, unsigned char value) {
+    memCheck(memory, index);
+    index &= memory->size - 1;
+    memory->memory[index] = value;
+    memory->dirty[index / PAGE_SIZE / 32] |= 1u << (index / PAGE_SIZE % 32);
+}
+
+/**
+ * @brief memRead(memory, index, buf, len) is used to copy bytes the program points
+ * at, like sprites, wrapping around the end of memory like getMemory()
+ * @return void
+ */
+static inline void memRead(struct Memory *memory, unsigned int index, unsigned char *buf, unsigned int len) {
+    for (unsigned int i = 0; i < len; i++) {
+        buf[i] = getMemory(memory, index + i);
+    }
+}
+
+/**
+ * @brief mergeBytes(chip8, index) is used to merge and build the opcode
+ * from two indices in the memory
+ * @param chip8 chip8's memory
+ * @param index the index from which to merge the bytes
+ * @return merged opcode
+ */
+static inline unsigned short mergeBytes(struct Memory *memory, unsigned int index) {
+    // the issue here is that the memory stores only one byte in a single index,
+    // we need to merge two indices together in order to get the full opcode
+    // opcode DXYN is stored as memory[i] = DX and memory[i+1] = YN
+    unsigned char byte1 = getMemory(memory, index);
+    unsigned char byte2 = getMemory(memory, index + 1);
+    return byte1 << 8 | byte2;
+}
 
-#endif
\ No newline at end of file
+#endif
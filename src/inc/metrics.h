@@ -0,0 +1,29 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdio.h>
+
+/*
+    A minimal HTTP/1.0 server for a metrics scraper such as Prometheus, on a
+    localhost port or a Unix domain socket (see inc/listen.h). Every GET of
+    /metrics or / is answered with whatever the write function produces,
+    anything else with 404, one request per connection. metricsServe()
+    waits for the next request at most timeout_ms, so the thread that owns
+    the server can do something else in between; it never touches the
+    threads that produce the numbers.
+*/
+#define METRICS_REQUEST_SIZE 4096
+// how long a connected client has to send its request
+#define METRICS_CLIENT_TIMEOUT_MS 1000
+
+struct MetricsServer {
+    int listener; // -1 if closed
+};
+
+typedef int (*MetricsWriter)(void *data, FILE *out);
+
+int metricsOpen(struct MetricsServer *server, const char *address);
+int metricsServe(struct MetricsServer *server, int timeout_ms, MetricsWriter write, void *data);
+void metricsClose(struct MetricsServer *server);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stddef.h>
+
+// machine a ROM was written for
+enum Platform {
+    PLATFORM_CHIP8,
+    PLATFORM_SCHIP,
+    PLATFORM_XOCHIP,
+    PLATFORM_MEGACHIP,
+    PLATFORMS,
+};
+
+// set of interpreter quirks a ROM expects
+enum Profile {
+    PROFILE_CHIP8,  // this emulator's historic behaviour
+    PROFILE_VIP,    // original COSMAC VIP interpreter
+    PROFILE_SCHIP,  // SUPER-CHIP 1.1
+    PROFILE_XOCHIP,   // Octo / XO-CHIP
+    PROFILE_MEGACHIP, // MegaChip on top of SUPER-CHIP
+    PROFILES,
+};
+
+// what one walk over the reachable code of a ROM found, see scanPlatform()
+struct PlatformScan {
+    enum Platform platform; // most capable machine whose instructions were found
+    int missing[PROFILES];  // reachable instructions each profile runs as no-ops
+};
+
+void scanPlatform(struct PlatformScan *scan, const unsigned char *rom, size_t size);
+enum Platform detectPlatform(const unsigned char *rom, size_t size);
+enum Profile defaultProfile(enum Platform platform);
+unsigned int profileMemory(enum Profile profile);
+unsigned int profileIsa(enum Profile profile);
+const char *platformName(enum Platform platform);
+const char *profileName(enum Profile profile);
+int platformFromName(const char *name);
+int profileFromName(const char *name);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+
+/*
+    Call-graph profiler, only built with -DCHIP8_PROFILE.
+    stackPush() and stackPop() report every 2NNN and 00EE, the profiler
+    mirrors them on a shadow stack stamped with the cycle count at entry
+    and charges the cycles spent in each call to a node of the call tree.
+    A node is one call path, so the tree holds exactly what folded stacks
+    need, and per-subroutine totals are summed up from it when reporting.
+    Node 0 is the code outside any subroutine.
+*/
+#define PROF_DEPTH 64
+
+struct ProfNode {
+    unsigned short addr;      // subroutine entry point
+    int parent;               // caller's node
+    int child;                // first callee, -1 if none
+    int sibling;              // next callee of the same caller, -1 if none
+    unsigned long long self;  // cycles spent in the subroutine itself
+    unsigned long long calls; // times this path was entered
+};
+
+struct ProfFrame {
+    int node;
+    unsigned long long entry;    // cycle count at the call
+    unsigned long long children; // cycles spent in finished callees
+};
+
+struct Profiler {
+    struct ProfNode *nodes;
+    int count;
+    int capacity;
+    struct ProfFrame frames[PROF_DEPTH];
+    int depth;
+    int untracked;              // calls past PROF_DEPTH still waiting for their return
+    unsigned long long dropped; // calls past PROF_DEPTH
+};
+
+void profInit(struct Profiler *prof, unsigned long long now);
+void profEnter(struct Profiler *prof, unsigned short addr, unsigned long long now);
+void profLeave(struct Profiler *prof, unsigned long long now);
+int profWriteFolded(struct Profiler *prof, FILE *out, unsigned long long now);
+int profWriteReport(struct Profiler *prof, FILE *out, unsigned long long now);
+void profFree(struct Profiler *prof);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef QUIRKS_H
+#define QUIRKS_H
+
+/*
+    The quirks of every profile, the one place they are set. chip8.c builds
+    each profile's interpreter with them (QUIRK_* in inc/interp.h) and
+    chip8-aot writes translations with them through QUIRKS(), so the two
+    can't drift apart. They are 0 or 1, for #if.
+        _SHIFT_VY   8XY6/8XYE shift VY into VX instead of shifting VX
+        _INC_I      FX55/FX65 leave I pointing past the last register
+        _JUMP_VX    BXNN jumps to XNN + VX instead of NNN + V0
+        _CLIP       sprites are clipped at the screen edges instead of wrapped
+*/
+#define PROFILE_CHIP8_SHIFT_VY 0
+#define PROFILE_CHIP8_INC_I 0
+#define PROFILE_CHIP8_JUMP_VX 0
+#define PROFILE_CHIP8_CLIP 0
+
+#define PROFILE_VIP_SHIFT_VY 1
+#define PROFILE_VIP_INC_I 1
+#define PROFILE_VIP_JUMP_VX 0
+#define PROFILE_VIP_CLIP 1
+
+#define PROFILE_SCHIP_SHIFT_VY 0
+#define PROFILE_SCHIP_INC_I 0
+#define PROFILE_SCHIP_JUMP_VX 1
+#define PROFILE_SCHIP_CLIP 1
+
+#define PROFILE_XOCHIP_SHIFT_VY 1
+#define PROFILE_XOCHIP_INC_I 1
+#define PROFILE_XOCHIP_JUMP_VX 0
+#define PROFILE_XOCHIP_CLIP 0
+
+#define PROFILE_MEGACHIP_SHIFT_VY 0
+#define PROFILE_MEGACHIP_INC_I 0
+#define PROFILE_MEGACHIP_JUMP_VX 1
+#define PROFILE_MEGACHIP_CLIP 1
+
+// an initializer of a table indexed by enum Profile: QUIRKS(PROFILE_VIP) gives [PROFILE_VIP] = {1, 1, 0, 1}
+#define QUIRKS(profile) [profile] = {profile##_SHIFT_VY, profile##_INC_I, profile##_JUMP_VX, profile##_CLIP}
+
+#endif
@@ -4,11 +4,12 @@
 #define DATA_REGISTERS 16
 struct Registers {
     unsigned char V[DATA_REGISTERS];
-    unsigned short I;
+    unsigned int I; // 24 bits are used by MegaChip 01NN NNNN
     unsigned char delay_timer;
     unsigned char sound_timer;
     unsigned short PC;
     unsigned char SP;
+    unsigned char flags[DATA_REGISTERS]; // SUPER-CHIP RPL user flags, FX75/FX85
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "chip8.h"
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+    Input log layout (all integers little-endian):
+        "C8IR", version, cycles per frame, quirk profile, 1 reserved byte,
+        u32 RNG seed, u64 ROM hash
+    followed by records, each a tag byte and a LEB128 cycle delta
+    from the previous record:
+        0x00-0x1F   key event, bit 4 = down, low nibble = key
+        0xFF        end of log, followed by a u64 hash of the final screen
+    the emulated frame of a record is its cycle / cycles per frame
+*/
+#define REPLAY_VERSION 3
+#define REPLAY_KEY_DOWN 0x10
+#define REPLAY_END 0xFF
+
+struct Recorder {
+    FILE *file;
+    unsigned long long cycle; // cycle of the last record written
+};
+
+struct Replay {
+    unsigned char *data;
+    size_t size;
+    size_t pos;
+    unsigned int seed;
+    unsigned char profile;
+    unsigned long long rom_hash;
+    unsigned long long next;        // cycle of the pending record
+    unsigned char tag;              // tag of the pending record
+    unsigned long long screen_hash; // expected final screen, valid once tag == REPLAY_END
+};
+
+int recOpen(struct Recorder *rec, const char *path, struct Chip8 *chip8);
+void recKey(struct Recorder *rec, struct Chip8 *chip8, int key, bool down);
+void recClose(struct Recorder *rec, struct Chip8 *chip8);
+
+int replayOpen(struct Replay *replay, const char *path);
+int replayRun(struct Replay *replay, struct Chip8 *chip8);
+void replayClose(struct Replay *replay);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include "chip8.h"
+#include "state.h"
+#include <stddef.h>
+
+// enough entries to cover two minutes at 60 frames per second
+#define REWIND_FRAMES (60 * 60 * 2)
+// default byte budget for the delta ring
+#define REWIND_CAPACITY (4 * 1024 * 1024)
+// an encoded delta never grows past this: one token per 127 literal bytes
+#define REWIND_MAX_DELTA(state_size) ((state_size) + (state_size) / 127 * 2 + 16)
+
+/*
+    Every pushed frame is stored as the XOR of its save state against the
+    previous one, run-length encoded as (zero run, literal count, literals)
+    tokens with LEB128 lengths. Stepping back XORs the newest delta into
+    the newest snapshot, which yields the frame before it.
+*/
+struct Rewind {
+    unsigned char *data; // ring of encoded deltas
+    size_t capacity;
+    size_t head; // bytes ever written
+    size_t tail; // bytes ever evicted or popped
+    unsigned int sizes[REWIND_FRAMES];
+    int first;   // oldest entry in sizes[]
+    int count;   // number of entries
+    size_t size; // save state size of the machine being recorded
+    unsigned char *state;   // newest snapshot
+    unsigned char *scratch; // one encoded delta followed by one raw snapshot
+};
+
+int rewindInit(struct Rewind *rewind, size_t capacity, struct Chip8 *chip8);
+void rewindPush(struct Rewind *rewind, struct Chip8 *chip8);
+int rewindStep(struct Rewind *rewind, struct Chip8 *chip8);
+void rewindFree(struct Rewind *rewind);
+
+#endif
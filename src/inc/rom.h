@@ -0,0 +1,29 @@
+#ifndef ROM_H
+#define ROM_H
+
+#include "memory.h"
+#include <stddef.h>
+
+// programs are loaded at 0x200 and may fill memory up to the end of
+// the largest address space of any profile
+#define ROM_START 0x200
+#define ROM_MAX_SIZE (MEGA_MEMORY_SIZE - ROM_START)
+
+enum RomError {
+    ROM_OK = 0,
+    ROM_ERR_OPEN,      // file missing or unreadable
+    ROM_ERR_EMPTY,     // zero-length file
+    ROM_ERR_TOO_LARGE, // doesn't fit between ROM_START and the end of memory
+    ROM_ERR_MAP,       // mmap failed
+};
+
+struct Rom {
+    const unsigned char *data; // read-only mapping of the file
+    size_t size;
+};
+
+enum RomError romOpen(struct Rom *rom, const char *path);
+void romClose(struct Rom *rom);
+const char *romError(enum RomError error);
+
+#endif
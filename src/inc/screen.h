@@ -2,14 +2,44 @@
 #define SCREEN_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #define WIDTH 64
 #define HEIGHT 32
+// SUPER-CHIP high resolution mode
+#define HIRES_WIDTH 128
+#define HIRES_HEIGHT 64
+#define ROW_WORDS (HIRES_WIDTH / 64)
+// XO-CHIP has two bitplanes, giving four colours
+#define PLANES 2
+
+/*
+    Pixels are packed one bit each, every row is two 64-bit words with the
+    leftmost pixel in the top bit of word 0. Low resolution mode only uses
+    word 0 of the first 32 rows, so drawing a sprite row is one rotate, one
+    AND for the collision and one XOR. Each bitplane has its own rows;
+    only XO-CHIP ever selects anything but plane 0.
+*/
 struct Screen {
-    bool pixels[HEIGHT][WIDTH];
+    uint64_t rows[PLANES][HIRES_HEIGHT][ROW_WORDS];
+    unsigned char planes; // planes selected by FN01, bit 0 = plane 0
+    bool hires;
 };
 
 void clearScreen(struct Screen *screen);
+void setHires(struct Screen *screen, bool hires);
+int screenWidth(struct Screen *screen);
+int screenHeight(struct Screen *screen);
 bool screenIsSet(struct Screen *screen, int x, int y);
+int screenPixel(struct Screen *screen, int x, int y);
 bool drawSprite(struct Screen *screen, int x, int y, const char *sprite, int num);
-#endif
\ No newline at end of file
+bool drawSpriteClipped(struct Screen *screen, int x, int y, const char *sprite, int num);
+bool drawLargeSprite(struct Screen *screen, int x, int y, const char *sprite);
+bool drawLargeSpriteClipped(struct Screen *screen, int x, int y, const char *sprite);
+bool drawSpritePlanes(struct Screen *screen, int x, int y, const char *sprite, int num);
+void scrollDown(struct Screen *screen, int n);
+void scrollUp(struct Screen *screen, int n);
+void scrollRight(struct Screen *screen);
+void scrollLeft(struct Screen *screen);
+unsigned long long screenHash(struct Screen *screen);
+#endif
@@ -0,0 +1,32 @@
+#ifndef STATE_H
+#define STATE_H
+
+#include "chip8.h"
+#include <stddef.h>
+
+/*
+    Save state layout (all integers little-endian):
+        "C8ST", u16 version, quirk profile, 1 reserved byte,
+        u32 memory size, u64 ROM hash,
+        memory, stack (u16 each), V0-VF, I, DT, ST, PC, SP, RPL flags,
+        keys, FX0A wait flag and key, hires flag, plane mask,
+        screen rows of every plane (u64 each), audio pattern, pitch,
+        u32 RNG state, u64 cycles, u64 frames
+    and on the MegaChip profile only:
+        pixels, front, palette (u32 each), sprite width and height,
+        collision index, blend mode, alpha, mode flag
+    bump STATE_VERSION whenever the layout changes
+*/
+#define STATE_VERSION 5
+#define STATE_SIZE(memory_size)                                                                                        \
+    (20 + (memory_size) + STACK_SIZE * 2 + DATA_REGISTERS * 2 + 9 + TOTAL_KEYS + 2 + 2 +                               \
+     PLANES * HIRES_HEIGHT * ROW_WORDS * 8 + 16 + 1 + 4 + 8 + 8)
+#define MEGA_STATE_SIZE (2 * MEGA_HEIGHT * MEGA_WIDTH + MEGA_COLOURS * 4 + 6)
+
+size_t stateSize(struct Chip8 *chip8);
+size_t stateSave(struct Chip8 *chip8, unsigned char *buf);
+int stateLoad(struct Chip8 *chip8, const unsigned char *buf, size_t size);
+int stateWrite(struct Chip8 *chip8, const char *path);
+int stateRead(struct Chip8 *chip8, const char *path);
+
+#endif
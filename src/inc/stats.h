@@ -0,0 +1,53 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+
+/*
+    Runtime statistics of one machine, always on. The interpreters, the
+    stack, chTick() and translated ROMs bump the counters in chip8->stats
+    with plain increments: a machine only runs on one thread at a time, so
+    nothing is atomic and counting is an add next to work the instruction
+    does anyway. statsRead() takes a snapshot, adding the instruction and
+    frame counts chip8->cycles and chip8->frames already keep, and
+    statsWrite() prints it as one JSON object per line. A StatsDump writes
+    a snapshot every so many frames to stderr or a file.
+*/
+// frames between two dumps, 10 seconds at 60 Hz
+#define STATS_INTERVAL 600
+
+struct Chip8;
+
+struct Stats {
+    unsigned long long instructions; // retired, chip8->cycles, filled in by statsRead()
+    unsigned long long frames;       // chip8->frames, filled in by statsRead()
+    unsigned long long draws;        // DXYN
+    unsigned long long collisions;   // DXYN that set VF
+    unsigned long long clears;       // 00E0
+    unsigned long long timer_ticks;  // ticks that found DT or ST running
+    unsigned long long key_waits;    // FX0A that started waiting for a key
+    unsigned long long unknown;      // 0NNN and opcodes the profile lacks, run as no-ops
+    unsigned int stack_high;         // deepest SP reached, past STACK_SIZE when the stack wrapped
+};
+
+struct StatsDump {
+    FILE *out;           // stderr or the file statsOpen() opened
+    unsigned long every; // frames between two snapshots
+    unsigned long next;  // chip8->frames of the next snapshot, 0 until the first statsPoll()
+};
+
+void statsRead(struct Chip8 *chip8, struct Stats *stats);
+int statsWrite(struct Chip8 *chip8, FILE *out);
+int statsOpen(struct StatsDump *dump, const char *path, unsigned long every);
+void statsPoll(struct StatsDump *dump, struct Chip8 *chip8);
+void statsClose(struct StatsDump *dump, struct Chip8 *chip8);
+
+// DXYN's result goes through here, so every engine counts draws the same way
+static inline bool statsDraw(struct Stats *stats, bool hit) {
+    stats->draws++;
+    stats->collisions += hit;
+    return hit;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#include "inc/library.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// keeps a ROM index up to date and prints it, or looks one ROM up by hash
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 4) {
+        printf("[Error] usage: ./chip8-index <rom dir> <index file> [hash]\n");
+        return -1;
+    }
+    struct Library library;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    libraryInit(&library);
+    if (libraryLoad(&library, argv[2]) == -1) {
+        printf("[Error] %s is not a compatible index, rebuilding it\n", argv[2]);
+    }
+    // a failed scan or save leaves the index file as it was
+    int hashed = libraryScan(&library, argv[1]);
+    if (hashed == -1) {
+        printf("[Error] %s is left unchanged\n", argv[2]);
+        libraryFree(&library);
+        return -1;
+    }
+    if (librarySave(&library, argv[2]) == -1) {
+        printf("[Error] could not write %s\n", argv[2]);
+        libraryFree(&library);
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+
+    if (argc == 4) {
+        struct LibraryEntry *entry = libraryFind(&library, strtoull(argv[3], 0x00, 16));
+        if (entry == 0x00) {
+            printf("[Error] no ROM with hash %s\n", argv[3]);
+            libraryFree(&library);
+            return -1;
+        }
+        printf("%s\t%s\t%s\n", entry->path, platformName(entry->platform), profileName(entry->profile));
+    } else {
+        for (int i = 0; i < library.count; i++) {
+            struct LibraryEntry *entry = &library.entries[i];
+            printf("%016llx %5llu %-7s %-7s %s\n", entry->hash, entry->size, platformName(entry->platform),
+                   profileName(entry->profile), entry->path);
+        }
+        printf("%d ROMs, %d read, %.2f ms\n", library.count, hashed, ms);
+    }
+    libraryFree(&library);
+    return 0;
+}
@@ -18,12 +18,22 @@ int mapKey(struct Keyboard *keyboard, char key) {
 
 void keyDown(struct Keyboard *keyboard, int key) {
     keyboard->keyboard[key] = true;
+    if (keyboard->waiting) {
+        keyboard->pressed = key;
+    }
 }
 
 void keyUp(struct Keyboard *keyboard, int key) {
     keyboard->keyboard[key] = false;
 }
 
+/**
+ * @brief keyIsDown(keyboard, key) is used by EX9E and EXA1, which test the key in VX;
+ * like the COSMAC VIP only its low nibble selects the key, so VX > 0xF stays in range
+ * @param keyboard chip8's keyboard
+ * @param key the value of VX
+ * @return true if the key is held
+ */
 bool keyIsDown(struct Keyboard *keyboard, int key) {
-    return keyboard->keyboard[key];
+    return keyboard->keyboard[key & (TOTAL_KEYS - 1)];
 }
\ No newline at end of file
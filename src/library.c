@@ -0,0 +1,257 @@
+#include "inc/library.h"
+#include "inc/hash.h"
+#include "inc/rom.h"
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/stat.h>
+
+static unsigned long long pathHash(const char *path) {
+    return hashBytes(path, strlen(path));
+}
+
+static void tableInsert(int *table, int slots, unsigned long long key, int index) {
+    int slot = key & (slots - 1);
+    while (table[slot] != -1) {
+        slot = (slot + 1) & (slots - 1);
+    }
+    table[slot] = index;
+}
+
+// rebuilds both lookup tables, sized to stay at most half full
+static void rebuildTables(struct Library *library) {
+    int slots = 64;
+    while (slots < library->count * 2) {
+        slots *= 2;
+    }
+    if (slots != library->slots) {
+        free(library->by_hash);
+        free(library->by_path);
+        library->by_hash = malloc(slots * sizeof(int));
+        library->by_path = malloc(slots * sizeof(int));
+        library->slots = slots;
+    }
+    memset(library->by_hash, -1, slots * sizeof(int));
+    memset(library->by_path, -1, slots * sizeof(int));
+    for (int i = 0; i < library->count; i++) {
+        tableInsert(library->by_hash, slots, library->entries[i].hash, i);
+        tableInsert(library->by_path, slots, pathHash(library->entries[i].path), i);
+    }
+}
+
+static struct LibraryEntry *findPath(struct Library *library, const char *path) {
+    int slot = pathHash(path) & (library->slots - 1);
+    while (library->by_path[slot] != -1) {
+        struct LibraryEntry *entry = &library->entries[library->by_path[slot]];
+        if (strcmp(entry->path, path) == 0) {
+            return entry;
+        }
+        slot = (slot + 1) & (library->slots - 1);
+    }
+    return 0x00;
+}
+
+static struct LibraryEntry *addEntry(struct Library *library, const char *path) {
+    if (library->count == library->capacity) {
+        library->capacity = library->capacity ? library->capacity * 2 : 64;
+        library->entries = realloc(library->entries, library->capacity * sizeof(struct LibraryEntry));
+    }
+    struct LibraryEntry *entry = &library->entries[library->count++];
+    memset(entry, 0, sizeof(struct LibraryEntry));
+    entry->path = strdup(path);
+    if (library->count * 2 > library->slots) {
+        rebuildTables(library);
+    } else {
+        tableInsert(library->by_path, library->slots, pathHash(path), library->count - 1);
+    }
+    return entry;
+}
+
+void libraryInit(struct Library *library) {
+    memset(library, 0, sizeof(struct Library));
+    rebuildTables(library);
+}
+
+/**
+ * @brief libraryLoad(library, path) is used to read a saved index
+ * @param library an initialized library
+ * @param path index file, a missing file leaves the library empty
+ * @return 0 on success, -1 if the file is not an index of this version
+ */
+int libraryLoad(struct Library *library, const char *path) {
+    char line[4200], platform[16], profile[16];
+    int version, offset;
+    FILE *ptr = fopen(path, "r");
+    if (ptr == 0x00) {
+        return 0;
+    }
+    if (fgets(line, sizeof(line), ptr) == 0x00 || sscanf(line, "chip8-index %d", &version) != 1 ||
+        version != LIBRARY_VERSION) {
+        fclose(ptr);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), ptr) != 0x00) {
+        struct LibraryEntry tmp;
+        line[strcspn(line, "\n")] = 0;
+        if (sscanf(line, "%llx\t%llu\t%lld\t%15[^\t]\t%15[^\t]\t%n", &tmp.hash, &tmp.size, &tmp.mtime, platform,
+                   profile, &offset) != 5 ||
+            platformFromName(platform) == -1 || profileFromName(profile) == -1) {
+            continue;
+        }
+        struct LibraryEntry *entry = addEntry(library, line + offset);
+        entry->hash = tmp.hash;
+        entry->size = tmp.size;
+        entry->mtime = tmp.mtime;
+        entry->platform = platformFromName(platform);
+        entry->profile = profileFromName(profile);
+    }
+    fclose(ptr);
+    rebuildTables(library);
+    return 0;
+}
+
+static void scanFile(struct Library *library, const char *path, struct stat *st) {
+    long long mtime = st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+    struct LibraryEntry *entry = findPath(library, path);
+    if (entry != 0x00 && entry->size == (unsigned long long)st->st_size && entry->mtime == mtime) {
+        entry->seen = true;
+        return;
+    }
+    struct Rom rom;
+    if (romOpen(&rom, path) != ROM_OK) {
+        return;
+    }
+    if (entry == 0x00) {
+        entry = addEntry(library, path);
+    }
+    entry->size = rom.size;
+    entry->mtime = mtime;
+    entry->hash = hashBytes(rom.data, rom.size);
+    entry->platform = detectPlatform(rom.data, rom.size);
+    entry->profile = defaultProfile(entry->platform);
+    entry->seen = true;
+    library->hashed++;
+    romClose(&rom);
+}
+
+// gives -1 if dir or a directory below it could not be read
+static int scanDir(struct Library *library, const char *dir) {
+    char path[4096];
+    struct dirent *ent;
+    struct stat st;
+    int result = 0;
+    DIR *d = opendir(dir);
+    if (d == 0x00) {
+        printf("[Error] could not read %s\n", dir);
+        return -1;
+    }
+    while ((ent = readdir(d)) != 0x00) {
+        // skips ".", ".." and hidden files, and names the index format can't hold
+        if (ent->d_name[0] == '.' || strpbrk(ent->d_name, "\t\n") != 0x00) {
+            continue;
+        }
+        if (snprintf(path, sizeof(path), "%s/%s", dir, ent->d_name) >= (int)sizeof(path) || lstat(path, &st) == -1) {
+            continue;
+        }
+        // links to ROMs are indexed, links to directories aren't followed since they can loop
+        bool link = S_ISLNK(st.st_mode);
+        if (link && stat(path, &st) == -1) {
+            continue;
+        }
+        size_t len = strlen(ent->d_name);
+        if (S_ISDIR(st.st_mode) && !link) {
+            result |= scanDir(library, path);
+        } else if (S_ISREG(st.st_mode) && len > 4 && strcasecmp(ent->d_name + len - 4, ".ch8") == 0) {
+            scanFile(library, path, &st);
+        }
+    }
+    closedir(d);
+    return result;
+}
+
+/**
+ * @brief libraryScan(library, dir) is used to bring the index up to date with a
+ * directory tree, only new files and files whose size or mtime changed are read,
+ * entries for deleted files are dropped
+ * @param library the library, usually loaded with libraryLoad() first
+ * @param dir root of the ROM tree
+ * @return number of files that had to be read, or -1 if a directory could not be
+ * read, nothing is dropped then since its files would look deleted
+ */
+int libraryScan(struct Library *library, const char *dir) {
+    int kept = 0;
+    library->hashed = 0;
+    for (int i = 0; i < library->count; i++) {
+        library->entries[i].seen = false;
+    }
+    if (scanDir(library, dir) == -1) {
+        return -1;
+    }
+    for (int i = 0; i < library->count; i++) {
+        if (library->entries[i].seen) {
+            library->entries[kept++] = library->entries[i];
+        } else {
+            free(library->entries[i].path);
+        }
+    }
+    library->count = kept;
+    rebuildTables(library);
+    return library->hashed;
+}
+
+/**
+ * @brief librarySave(library, path) is used to write the index,
+ * through a temporary file so a crash never leaves a torn index
+ * @param library the library
+ * @param path index file
+ * @return 0 on success, -1 on I/O errors
+ */
+int librarySave(struct Library *library, const char *path) {
+    char tmp[4096];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *ptr = fopen(tmp, "w");
+    if (ptr == 0x00) {
+        return -1;
+    }
+    fprintf(ptr, "chip8-index %d\n", LIBRARY_VERSION);
+    for (int i = 0; i < library->count; i++) {
+        struct LibraryEntry *entry = &library->entries[i];
+        fprintf(ptr, "%016llx\t%llu\t%lld\t%s\t%s\t%s\n", entry->hash, entry->size, entry->mtime,
+                platformName(entry->platform), profileName(entry->profile), entry->path);
+    }
+    if (fclose(ptr) != 0 || rename(tmp, path) != 0) {
+        remove(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief libraryFind(library, hash) is used to look a ROM up by content hash
+ * @param library the library
+ * @param hash FNV-1a hash of the ROM, as in chip8->rom_hash
+ * @return the entry, 0x00 if no indexed file has that hash
+ */
+struct LibraryEntry *libraryFind(struct Library *library, unsigned long long hash) {
+    int slot = hash & (library->slots - 1);
+    while (library->by_hash[slot] != -1) {
+        struct LibraryEntry *entry = &library->entries[library->by_hash[slot]];
+        if (entry->hash == hash) {
+            return entry;
+        }
+        slot = (slot + 1) & (library->slots - 1);
+    }
+    return 0x00;
+}
+
+void libraryFree(struct Library *library) {
+    for (int i = 0; i < library->count; i++) {
+        free(library->entries[i].path);
+    }
+    free(library->entries);
+    free(library->by_hash);
+    free(library->by_path);
+    memset(library, 0, sizeof(struct Library));
+}
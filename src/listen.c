@@ -0,0 +1,72 @@
+#include "inc/listen.h"
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * @brief listenOn(address, backlog) is used to open a non-blocking listening socket
+ * @param address a port number for 127.0.0.1, anything else is the path of a Unix domain socket
+ * @param backlog connections the kernel queues before accept()
+ * @return the socket, or -1 after printing why it could not be opened
+ */
+int listenOn(const char *address, int backlog) {
+    int fd;
+    char *end;
+    unsigned long port = strtoul(address, &end, 10);
+    if (*end == '\0' && port > 0 && port < 65536) {
+        struct sockaddr_in in = {0};
+        in.sin_family = AF_INET;
+        in.sin_port = htons(port);
+        in.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd == -1) {
+            printf("[Error] could not listen on 127.0.0.1:%lu\n", port);
+            return -1;
+        }
+        int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (bind(fd, (struct sockaddr *)&in, sizeof(in)) == -1) {
+            printf("[Error] could not listen on 127.0.0.1:%lu\n", port);
+            close(fd);
+            return -1;
+        }
+    } else {
+        struct sockaddr_un un = {0};
+        un.sun_family = AF_UNIX;
+        if (strlen(address) >= sizeof(un.sun_path)) {
+            printf("[Error] socket path %s is too long\n", address);
+            return -1;
+        }
+        strcpy(un.sun_path, address);
+        // a socket left behind by an earlier run is replaced, any other file is kept
+        struct stat st;
+        if (lstat(address, &st) == 0) {
+            if (!S_ISSOCK(st.st_mode)) {
+                printf("[Error] %s exists and is not a socket\n", address);
+                return -1;
+            }
+            unlink(address);
+        }
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1 || bind(fd, (struct sockaddr *)&un, sizeof(un)) == -1) {
+            printf("[Error] could not listen on %s\n", address);
+            if (fd != -1) {
+                close(fd);
+            }
+            return -1;
+        }
+    }
+    if (listen(fd, backlog) == -1) {
+        printf("[Error] could not listen on %s\n", address);
+        close(fd);
+        return -1;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
@@ -1,16 +1,37 @@
 #include "inc/SDL2/SDL.h"
 #include "inc/chip8.h"
+#include "inc/debugger.h"
+#include "inc/gdbstub.h"
 #include "inc/keyboard.h"
+#include "inc/replay.h"
+#include "inc/rewind.h"
 #include "inc/screen.h"
+#include "inc/state.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 const char keyboard_map[TOTAL_KEYS] = {SDLK_0, SDLK_1, SDLK_2, SDLK_3, SDLK_4, SDLK_5, SDLK_6, SDLK_7,
                                        SDLK_8, SDLK_9, SDLK_a, SDLK_b, SDLK_c, SDLK_d, SDLK_e, SDLK_f};
 SDL_Window *window;
 SDL_Renderer *renderer;
+SDL_Texture *mega_texture; // created on the first MegaChip frame
 struct Chip8 chip8;
+struct Recorder recorder;
+char state_path[4096]; // quick save slot, <rom file>.state
+struct Rewind rewind_buffer;
+struct Debugger debugger; // F12 stops the machine and reads commands from the console
+struct GdbStub gdb;       // serves the debugger over RSP instead, with --gdb
+struct StatsDump stats;   // runtime counters written every STATS_INTERVAL frames, with --stats
+#ifdef CHIP8_PROFILE
+struct Profiler profiler; // written to <rom file>.folded on exit
+#endif
+#ifdef CHIP8_HOTSPOTS
+struct Hotspots hotspots; // printed and written to <rom file>.hot.csv on exit
+#endif
+bool rewinding; // backspace is held
 
 void initWindow() {
     // https://wiki.libsdl.org/SDL_CreateWindow
@@ -52,17 +73,25 @@ void setRendererColors() {
     SDL_SetRenderDrawColor(renderer, 255, 255, 255, 0);
 }
 
+// XO-CHIP colours: plane 1 alone, plane 2 alone and both planes set
+static const unsigned char palette[4][3] = {{0, 0, 0}, {255, 255, 255}, {170, 170, 170}, {85, 85, 85}};
+
 void drawDisplay(struct Chip8 *chip8) {
     setRendererColors();
-    // iterating thru the display (64*32)
-    for (int x = 0; x < WIDTH; x++) {
-        for (int y = 0; y < HEIGHT; y++) {
-            if (screenIsSet(&chip8->screen, x, y)) {
+    // iterating thru the display (64*32, or 128*64 in SUPER-CHIP high resolution)
+    int width = screenWidth(&chip8->screen);
+    int height = screenHeight(&chip8->screen);
+    int scale = WIDTH * 10 / width;
+    for (int x = 0; x < width; x++) {
+        for (int y = 0; y < height; y++) {
+            int color = screenPixel(&chip8->screen, x, y);
+            if (color != 0) {
+                SDL_SetRenderDrawColor(renderer, palette[color][0], palette[color][1], palette[color][2], 0);
                 SDL_Rect rect;
-                rect.x = x * 10;
-                rect.y = y * 10;
-                rect.w = 10;
-                rect.h = 10;
+                rect.x = x * scale;
+                rect.y = y * scale;
+                rect.w = scale;
+                rect.h = scale;
                 SDL_RenderFillRect(renderer, &rect);
             }
         }
@@ -71,6 +100,57 @@ void drawDisplay(struct Chip8 *chip8) {
     // SDL_RenderPresent(renderer);
 }
 
+// MegaChip pictures are uploaded whole and scaled by SDL, keeping the 4:3 aspect
+void drawMega(struct Mega *mega) {
+    if (mega_texture == 0x00) {
+        mega_texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, MEGA_WIDTH,
+                                         MEGA_HEIGHT);
+    }
+    void *pixels;
+    int pitch;
+    if (SDL_LockTexture(mega_texture, 0x00, &pixels, &pitch) != 0) {
+        return;
+    }
+    for (int y = 0; y < MEGA_HEIGHT; y++) {
+        Uint32 *row = (Uint32 *)((char *)pixels + y * pitch);
+        for (int x = 0; x < MEGA_WIDTH; x++) {
+            row[x] = mega->palette[mega->front[y][x]] | 0xFF000000;
+        }
+    }
+    SDL_UnlockTexture(mega_texture);
+    int h = HEIGHT * 10;
+    int w = h * MEGA_WIDTH / MEGA_HEIGHT;
+    SDL_Rect rect = {(WIDTH * 10 - w) / 2, 0, w, h};
+    SDL_RenderCopy(renderer, mega_texture, 0x00, &rect);
+}
+
+void setKey(struct Chip8 *chip8, int vkey, bool down) {
+    // ignore auto-repeat so the input log only holds real state changes
+    if (keyIsDown(&chip8->keyboard, vkey) == down) {
+        return;
+    }
+    if (down) {
+        keyDown(&chip8->keyboard, vkey);
+    } else {
+        keyUp(&chip8->keyboard, vkey);
+    }
+    if (recorder.file != 0x00) {
+        recKey(&recorder, chip8, vkey, down);
+    }
+}
+
+// a quick load or rewind moved PC away from pc without running it, which the hotspots count as a jump
+void hotMoved(struct Chip8 *chip8, unsigned short pc) {
+#ifdef CHIP8_HOTSPOTS
+    if (chip8->hotspots != 0x00 && chip8->registers.PC != pc) {
+        hotJump(chip8->hotspots, pc, chip8->registers.PC);
+    }
+#else
+    (void)chip8;
+    (void)pc;
+#endif
+}
+
 int handleEvent(struct Chip8 *chip8) {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -80,68 +160,222 @@ int handleEvent(struct Chip8 *chip8) {
             return -1;
             break;
         case SDL_KEYDOWN: {
+            // F5 quick save, F9 quick load, hold backspace to rewind, F12 debugger
+            if (event.key.keysym.sym == SDLK_BACKSPACE) {
+                rewinding = true;
+                break;
+            }
+            if (event.key.keysym.sym == SDLK_F5) {
+                if (stateWrite(chip8, state_path) == 0) {
+                    printf("\n[OK] state saved to %s", state_path);
+                }
+                break;
+            }
+            if (event.key.keysym.sym == SDLK_F9) {
+                // an older state moves chip8->cycles back, which an input log can't express
+                if (recorder.file != 0x00) {
+                    printf("\n[Warning] quick load is off while recording");
+                } else {
+                    unsigned short pc = chip8->registers.PC;
+                    if (stateRead(chip8, state_path) == 0) {
+                        printf("\n[OK] state loaded from %s", state_path);
+                    }
+                    hotMoved(chip8, pc);
+                }
+                break;
+            }
+            if (event.key.keysym.sym == SDLK_F12) {
+                dbgInterrupt(&debugger);
+                break;
+            }
             char key = event.key.keysym.sym;
             int vkey = mapKey(&chip8->keyboard, key);
             if (vkey != -1) {
-                keyDown(&chip8->keyboard, vkey);
+                setKey(chip8, vkey, true);
             }
         } break;
 
         case SDL_KEYUP: {
+            if (event.key.keysym.sym == SDLK_BACKSPACE) {
+                rewinding = false;
+                break;
+            }
             char key = event.key.keysym.sym;
             int vkey = mapKey(&chip8->keyboard, key);
             if (vkey != -1) {
-                keyUp(&chip8->keyboard, vkey);
+                setKey(chip8, vkey, false);
             }
         } break;
         }
     }
     return 0;
 }
+
 int main(int argc, char **argv) {
 
+    const char *gdb_address = 0x00;
+    const char *stats_path = 0x00;
+    // options come before the ROM, each takes a value
+    while (argc >= 3 && (strcmp(argv[1], "--gdb") == 0 || strcmp(argv[1], "--stats") == 0)) {
+        if (strcmp(argv[1], "--gdb") == 0) {
+            gdb_address = argv[2];
+        } else {
+            stats_path = argv[2];
+        }
+        argc -= 2;
+        argv += 2;
+    }
     if (argc < 2) {
         printf("You must provide a file to load\n");
         return -1;
     }
     switch (argc) {
     case 1:
-        printf("[Error] usage: ./chip8 <rom file>\n");
+        printf("[Error] usage: ./chip8 [--gdb <port or socket path>] [--stats <file or ->] <rom file> "
+               "[input log to record]\n");
         return -1;
         break;
-    case 2: {
+    case 2:
+    case 3: {
         printf("\nloading font into memory....");
         chInit(&chip8);
         printf("\n[OK] font is loaded successfully");
         const char *buf = argv[1];
         printf("\nloading file: %s....\n", buf);
-        chLoad(&chip8, buf);
+        // the walk that picks the profile also counts what it can't run
+        struct PlatformScan scan;
+        struct Rom rom;
+        enum RomError error = romOpen(&rom, buf);
+        if (error == ROM_OK) {
+            scanPlatform(&scan, rom.data, rom.size);
+            error = chLoadDataAs(&chip8, rom.data, rom.size, defaultProfile(scan.platform));
+            romClose(&rom);
+        }
+        if (error != ROM_OK) {
+            printf("[Error] %s: %s\n", buf, romError(error));
+            return -1;
+        }
         printf("\n[OK] file is loaded successfully");
+        if (scan.missing[chip8.profile] > 0) {
+            printf("\n[Warning] %d reachable instructions don't exist on the %s profile", scan.missing[chip8.profile],
+                   profileName(chip8.profile));
+        }
+        chSeed(&chip8, time(0x00));
+        snprintf(state_path, sizeof(state_path), "%s.state", buf);
+        if (argc == 3) {
+            if (recOpen(&recorder, argv[2], &chip8) == -1) {
+                return -1;
+            }
+            printf("\nrecording input to %s", argv[2]);
+        }
         setMap(&chip8.keyboard, keyboard_map);
+        if (gdb_address == 0x00) {
+            dbgInit(&debugger, dbgConsole, 0x00);
+        } else {
+            if (gdbOpen(&gdb, gdb_address) == -1) {
+                return -1;
+            }
+            dbgInit(&debugger, gdbStop, &gdb);
+            printf("\nlistening for a debugger on %s", gdb_address);
+        }
+        if (stats_path != 0x00) {
+            if (statsOpen(&stats, stats_path, STATS_INTERVAL) == -1) {
+                return -1;
+            }
+            printf("\nwriting statistics to %s", strcmp(stats_path, "-") == 0 ? "stderr" : stats_path);
+        }
+#ifdef CHIP8_PROFILE
+        profInit(&profiler, chip8.cycles);
+        chip8.profiler = &profiler;
+#endif
+#ifdef CHIP8_HOTSPOTS
+        hotInit(&hotspots, chip8.registers.PC);
+        chip8.hotspots = &hotspots;
+#endif
+        if (rewindInit(&rewind_buffer, REWIND_CAPACITY, &chip8) == -1) {
+            // a MegaChip state alone is larger than the whole buffer
+            printf("\n[Warning] rewind is not available for this ROM");
+        }
         printf("\nstarting the emulator....");
         SDL_Init(SDL_INIT_EVERYTHING);
         initWindow();
         initRenderer();
         while (1) {
+            // keys only change between frames, so a replay sees them at the same cycle
             int e = handleEvent(&chip8);
-            setRendererColors();
-            drawDisplay(&chip8);
-            // update the screen
-            SDL_RenderPresent(renderer);
-            unsigned short opcode = mergeBytes(&chip8.memory, chip8.registers.PC);
-            chip8.registers.PC += 2;
-            execOpcode(&chip8, opcode);
-            if (chip8.registers.delay_timer > 0) {
-                sleep(10);
-                chip8.registers.delay_timer -= 1;
-            }
-            if (chip8.registers.sound_timer > 0) {
-                chip8.registers.sound_timer = 0;
-            }
             if (e == -1) {
                 break;
             }
+            // rewinding would desync an input log, so it is off while recording
+            bool can_rewind = rewind_buffer.data != 0x00;
+            if (rewinding && can_rewind && recorder.file == 0x00) {
+                unsigned short pc = chip8.registers.PC;
+                rewindStep(&rewind_buffer, &chip8);
+                hotMoved(&chip8, pc);
+            } else {
+                if (gdb_address != 0x00) {
+                    gdbPoll(&gdb, &debugger);
+                }
+                if (!dbgActive(&debugger)) {
+                    chFrame(&chip8);
+                } else {
+                    // the window isn't redrawn while the debugger reads commands
+                    dbgFrame(&debugger, &chip8);
+                    if (debugger.quit) {
+                        break;
+                    }
+                }
+                if (can_rewind) {
+                    rewindPush(&rewind_buffer, &chip8);
+                }
+                if (stats.out != 0x00) {
+                    statsPoll(&stats, &chip8);
+                }
+            }
+            setRendererColors();
+            if (chip8.mega != 0x00 && chip8.mega->enabled) {
+                drawMega(chip8.mega);
+            } else {
+                drawDisplay(&chip8);
+            }
+            // update the screen
+            SDL_RenderPresent(renderer);
+            SDL_Delay(1000 / 60);
+        }
+        if (recorder.file != 0x00) {
+            recClose(&recorder, &chip8);
+        }
+        rewindFree(&rewind_buffer);
+        if (gdb_address != 0x00) {
+            gdbClose(&gdb);
+        }
+        if (stats.out != 0x00) {
+            statsClose(&stats, &chip8);
+        }
+#ifdef CHIP8_PROFILE
+        char folded_path[4096];
+        snprintf(folded_path, sizeof(folded_path), "%s.folded", buf);
+        FILE *folded = fopen(folded_path, "w");
+        if (folded != 0x00) {
+            profWriteFolded(&profiler, folded, chip8.cycles);
+            fclose(folded);
+            printf("\nprofile written to %s", folded_path);
+        }
+        profFree(&profiler);
+#endif
+#ifdef CHIP8_HOTSPOTS
+        printf("\n");
+        hotWriteReport(&hotspots, stdout, &chip8.memory, profileIsa(chip8.profile), chip8.registers.PC);
+        char csv_path[4096];
+        snprintf(csv_path, sizeof(csv_path), "%s.hot.csv", buf);
+        FILE *csv = fopen(csv_path, "w");
+        if (csv != 0x00) {
+            hotWriteCsv(&hotspots, csv, &chip8.memory, profileIsa(chip8.profile), chip8.registers.PC);
+            fclose(csv);
+            printf("hotspots written to %s", csv_path);
         }
+#endif
+        chFree(&chip8);
     } break;
     }
     return 0;
@@ -0,0 +1,145 @@
+#include "inc/mega.h"
+#include "inc/hash.h"
+#include <memory.h>
+
+// 16 pixels handled at once, GCC lowers this to SSE2/NEON byte compares and selects
+typedef unsigned char span_t __attribute__((vector_size(16)));
+
+/**
+ * @brief megaSetMode(mega, enabled) is used by 0011/0010 to switch MegaChip mode
+ * on and off, both pictures are cleared like a SUPER-CHIP resolution change
+ * @param mega the MegaChip framebuffer
+ * @param enabled true for 256x192 with 256 colours
+ * @return void
+ */
+void megaSetMode(struct Mega *mega, bool enabled) {
+    mega->enabled = enabled;
+    memset(mega->pixels, 0, sizeof(mega->pixels));
+    memset(mega->front, 0, sizeof(mega->front));
+}
+
+/**
+ * @brief megaPresent(mega) is used by 00E0 in MegaChip mode to show the
+ * finished picture and start the next one from a clear screen
+ * @param mega the MegaChip framebuffer
+ * @return void
+ */
+void megaPresent(struct Mega *mega) {
+    memcpy(mega->front, mega->pixels, sizeof(mega->front));
+    memset(mega->pixels, 0, sizeof(mega->pixels));
+}
+
+/**
+ * @brief megaLoadPalette(mega, memory, index, num) is used by 02NN to load num
+ * ARGB colours into palette entries 1 to num, entry 0 stays transparent
+ * @param mega the MegaChip framebuffer
+ * @param memory chip8's memory
+ * @param index address of the colours, 4 bytes each, alpha first
+ * @param num number of colours
+ * @return void
+ */
+void megaLoadPalette(struct Mega *mega, struct Memory *memory, unsigned int index, int num) {
+    unsigned char colours[MEGA_COLOURS * 4];
+    num = num < MEGA_COLOURS - 1 ? num : MEGA_COLOURS - 1;
+    memRead(memory, index, colours, num * 4);
+    for (int i = 0; i < num; i++) {
+        const unsigned char *c = &colours[i * 4];
+        mega->palette[i + 1] = (uint32_t)c[0] << 24 | c[1] << 16 | c[2] << 8 | c[3];
+    }
+}
+
+// copies the opaque pixels of src over dst, returns true if one lands on the collision index
+static inline bool blendSpan(unsigned char *dst, const unsigned char *src, int len, unsigned char collision) {
+    span_t hit = {0};
+    int i = 0;
+    for (; i + 16 <= len; i += 16) {
+        span_t s, d;
+        memcpy(&s, &src[i], 16);
+        memcpy(&d, &dst[i], 16);
+        span_t opaque = (span_t)(s != 0);
+        hit |= opaque & (span_t)(d == collision);
+        d = (s & opaque) | (d & ~opaque);
+        memcpy(&dst[i], &d, 16);
+    }
+    uint64_t lanes[2];
+    memcpy(lanes, &hit, 16);
+    unsigned char tail = 0;
+    for (; i < len; i++) {
+        unsigned char opaque = -(src[i] != 0);
+        tail |= opaque & -(dst[i] == collision);
+        dst[i] = (src[i] & opaque) | (dst[i] & ~opaque);
+    }
+    return (lanes[0] | lanes[1] | tail) != 0;
+}
+
+/**
+ * @brief megaBlit(mega, x, y, memory, index) is used by DXYN in MegaChip mode to draw a
+ * sprite_width x sprite_height sprite, clipped at the right and bottom edges;
+ * each row is blended as one span, so wide sprites cost a few vector ops per row
+ * @param mega the MegaChip framebuffer
+ * @param x column, 0-255
+ * @param y row
+ * @param memory chip8's memory
+ * @param index address of sprite_width * sprite_height palette indices
+ * @return true if any pixel was drawn over the collision index
+ */
+bool megaBlit(struct Mega *mega, int x, int y, struct Memory *memory, unsigned int index) {
+    int width = mega->sprite_width ? mega->sprite_width : 256;
+    int height = mega->sprite_height ? mega->sprite_height : 256;
+    int span = width < MEGA_WIDTH - x ? width : MEGA_WIDTH - x;
+    bool pixelCollison = false;
+    unsigned char wrapped[MEGA_WIDTH];
+    for (int row = 0; row < height && y + row < MEGA_HEIGHT; row++) {
+        unsigned int start = index + row * width;
+        const unsigned char *src = wrapped;
+        if (start + span <= memory->size) {
+            src = &memory->memory[start];
+        } else {
+            // only a row running off the end of memory pays for the wrap
+            memRead(memory, start, wrapped, span);
+        }
+        pixelCollison |= blendSpan(&mega->pixels[y + row][x], src, span, mega->collision);
+    }
+    return pixelCollison;
+}
+
+/**
+ * @brief megaScroll(mega, dx, dy) is used by 00BN, 00CN, 00FB and 00FC in MegaChip
+ * mode to move the picture being drawn, uncovered pixels become transparent
+ * @param mega the MegaChip framebuffer
+ * @param dx pixels to the right, negative for left
+ * @param dy rows down, negative for up
+ * @return void
+ */
+void megaScroll(struct Mega *mega, int dx, int dy) {
+    if (dy > 0) {
+        dy = dy < MEGA_HEIGHT ? dy : MEGA_HEIGHT;
+        memmove(mega->pixels[dy], mega->pixels[0], (MEGA_HEIGHT - dy) * MEGA_WIDTH);
+        memset(mega->pixels[0], 0, dy * MEGA_WIDTH);
+    } else if (dy < 0) {
+        dy = -dy < MEGA_HEIGHT ? -dy : MEGA_HEIGHT;
+        memmove(mega->pixels[0], mega->pixels[dy], (MEGA_HEIGHT - dy) * MEGA_WIDTH);
+        memset(mega->pixels[MEGA_HEIGHT - dy], 0, dy * MEGA_WIDTH);
+    }
+    if (dx == 0) {
+        return;
+    }
+    int n = dx > 0 ? dx : -dx;
+    n = n < MEGA_WIDTH ? n : MEGA_WIDTH;
+    for (int y = 0; y < MEGA_HEIGHT; y++) {
+        unsigned char *row = mega->pixels[y];
+        if (dx > 0) {
+            memmove(&row[n], row, MEGA_WIDTH - n);
+            memset(row, 0, n);
+        } else {
+            memmove(row, &row[n], MEGA_WIDTH - n);
+            memset(&row[MEGA_WIDTH - n], 0, n);
+        }
+    }
+}
+
+// folds the presented picture and its palette into hash
+unsigned long long megaHash(struct Mega *mega, unsigned long long hash) {
+    hash = hashUpdate(hash, mega->front, sizeof(mega->front));
+    return hashUpdate(hash, mega->palette, sizeof(mega->palette));
+}
@@ -1,27 +1,77 @@
 #include "inc/memory.h"
-#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
-void inBounds(int index) {
-    assert(index >= 0 && index < MEMORY_SIZE);
+static size_t dirtyBytes(unsigned int size) {
+    return (size / PAGE_SIZE + 31) / 32 * sizeof(unsigned int);
 }
 
-unsigned char getMemory(struct Memory *memory, int index) {
-    inBounds(index);
-    return memory->memory[index];
+/**
+ * @brief memResize(memory, size) is used to give the machine the address space
+ * of its profile, contents below the new size are kept, new bytes are zero
+ * @param memory chip8's memory, zeroed or previously sized
+ * @param size bytes of address space, a power of two
+ * @return void
+ */
+void memResize(struct Memory *memory, unsigned int size) {
+    if (memory->size == size) {
+        return;
+    }
+    unsigned char *bytes;
+    if (size > memory->size) {
+        // calloc() gets large blocks zeroed by the OS, so growing to MegaChip's 32 MB only touches what is used
+        bytes = calloc(size, 1);
+        if (bytes != 0x00 && memory->memory != 0x00) {
+            memcpy(bytes, memory->memory, memory->size);
+        }
+        free(bytes != 0x00 ? memory->memory : 0x00);
+    } else {
+        bytes = realloc(memory->memory, size);
+    }
+    unsigned int *dirty = realloc(memory->dirty, dirtyBytes(size));
+    if (bytes == 0x00 || dirty == 0x00) {
+        abort();
+    }
+    memory->memory = bytes;
+    memory->dirty = dirty;
+    memory->size = size;
+    // the whole space counts as written so forks resync it
+    memset(memory->dirty, 0xFF, dirtyBytes(size));
+}
+
+void memFree(struct Memory *memory) {
+    free(memory->memory);
+    free(memory->dirty);
+    memset(memory, 0, sizeof(struct Memory));
+}
+
+int memPages(struct Memory *memory) {
+    return memory->size / PAGE_SIZE;
 }
 
+bool pageIsDirty(struct Memory *memory, int page) {
+    return (memory->dirty[page / 32] >> (page % 32)) & 1;
+}
+
+void clearDirty(struct Memory *memory) {
+    memset(memory->dirty, 0, dirtyBytes(memory->size));
+}
+
+#ifdef CHIP8_CHECKED
 /**
- * @brief mergeBytes(chip8, index) is used to merge and build the opcode
- * from two indices in the memory
- * @param chip8 chip8's memory
- * @param index the index from which to merge the bytes
- * @return merged opcode 
+ * @brief memFault(memory, index) is used by the checked accessors to record an
+ * address past the end of memory; the access itself still wraps, the
+ * interpreter reports the instruction that made it
+ * @param memory chip8's memory
+ * @param index the address as the program computed it
+ * @return void
  */
-unsigned short mergeBytes(struct Memory *memory, int index) {
-    // the issue here is that the memory stores only one byte in a single index,
-    // we need to merge two indices together in order to get the full opcode
-    // opcode DXYN is stored as memory[i] = DX and memory[i+1] = YN
-    unsigned char byte1 = getMemory(memory, index); // memory->memory[index];
-    unsigned char byte2 = getMemory(memory, index + 1); // memory->memory[index + 1];
-    return byte1 << 8 | byte2;
-}
\ No newline at end of file
+void memFault(struct Memory *memory, unsigned int index) {
+    memory->violations++;
+    if (!memory->faulted) {
+        memory->faulted = true;
+        memory->fault = index;
+    }
+}
+#endif
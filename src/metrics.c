@@ -0,0 +1,118 @@
+#include "inc/metrics.h"
+#include "inc/listen.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/**
+ * @brief metricsOpen(server, address) is used to start listening for scrapers
+ * @param server the server
+ * @param address a port number for 127.0.0.1, anything else is the path of a Unix domain socket
+ * @return 0, or -1 if the socket could not be opened
+ */
+int metricsOpen(struct MetricsServer *server, const char *address) {
+    server->listener = listenOn(address, 16);
+    return server->listener == -1 ? -1 : 0;
+}
+
+static bool sendAll(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// GET /metrics or GET /, with or without a query
+static bool isMetricsRequest(const char *request) {
+    if (strncmp(request, "GET /", 5) != 0) {
+        return false;
+    }
+    const char *path = request + 4;
+    size_t len = strcspn(path, " ?\r\n");
+    return len == 1 || (len == 8 && strncmp(path, "/metrics", 8) == 0);
+}
+
+/**
+ * @brief metricsServe(server, timeout_ms, write, data) is used to answer the next
+ * scraper, the body is produced by write(data, out) in full before anything is sent
+ * @param server an open server
+ * @param timeout_ms how long to wait for a connection, 0 to only look
+ * @param write produces the metrics, returns -1 on errors
+ * @param data handed to write
+ * @return 1 if a request was answered, 0 if none came in time
+ */
+int metricsServe(struct MetricsServer *server, int timeout_ms, MetricsWriter write, void *data) {
+    struct pollfd ready = {.fd = server->listener, .events = POLLIN};
+    if (poll(&ready, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+    // on Linux the client doesn't inherit O_NONBLOCK, a slow one is cut off instead
+    int client = accept(server->listener, 0x00, 0x00);
+    if (client == -1) {
+        return 0;
+    }
+    struct timeval timeout = {METRICS_CLIENT_TIMEOUT_MS / 1000, METRICS_CLIENT_TIMEOUT_MS % 1000 * 1000};
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[METRICS_REQUEST_SIZE + 1];
+    size_t len = 0;
+    request[0] = '\0';
+    while (len < METRICS_REQUEST_SIZE && strstr(request, "\r\n\r\n") == 0x00) {
+        ssize_t n = recv(client, request + len, METRICS_REQUEST_SIZE - len, 0);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        len += n;
+        request[len] = '\0';
+    }
+
+    char *body = 0x00, header[256];
+    size_t body_len = 0;
+    FILE *out = open_memstream(&body, &body_len);
+    const char *status = "404 Not Found";
+    if (out == 0x00) {
+        abort();
+    }
+    if (!isMetricsRequest(request)) {
+        fprintf(out, "only GET /metrics is served\n");
+    } else if (write(data, out) == -1) {
+        status = "500 Internal Server Error";
+    } else {
+        status = "200 OK";
+    }
+    fclose(out);
+    int header_len = snprintf(header, sizeof(header),
+                              "HTTP/1.0 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                              "Content-Length: %zu\r\nConnection: close\r\n\r\n",
+                              status, body_len);
+    if (sendAll(client, header, header_len)) {
+        sendAll(client, body, body_len);
+    }
+    free(body);
+    close(client);
+    return 1;
+}
+
+void metricsClose(struct MetricsServer *server) {
+    if (server->listener != -1) {
+        close(server->listener);
+    }
+    server->listener = -1;
+}
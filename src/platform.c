@@ -0,0 +1,147 @@
+#include "inc/platform.h"
+#include "inc/cfg.h"
+#include "inc/decode.h"
+#include "inc/memory.h"
+#include "inc/rom.h"
+#include <string.h>
+
+static const char *platform_names[PLATFORMS] = {"chip8", "schip", "xochip", "megachip"};
+static const char *profile_names[PROFILES] = {"chip8", "vip", "schip", "xochip", "megachip"};
+
+// the largest image that is walked, anything bigger only fits XO-CHIP or MegaChip memory
+#define SCAN_MAX (MEMORY_SIZE - ROM_START)
+
+/**
+ * @brief scanPlatform(scan, rom, size) is used to guess the target machine of a
+ * ROM by looking for instructions that only exist on the extended machines,
+ * and to count the ones each profile lacks; only code reachable from the
+ * entry point is considered, so sprite data that happens to look like such
+ * an instruction doesn't count. The walk runs on the stack, nothing is
+ * allocated
+ * @param scan filled with the platform and the missing instructions per profile
+ * @param rom ROM image, loaded at 0x200
+ * @param size size of the image
+ * @return void
+ */
+void scanPlatform(struct PlatformScan *scan, const unsigned char *rom, size_t size) {
+    memset(scan, 0, sizeof(struct PlatformScan));
+    scan->platform = PLATFORM_CHIP8;
+    if (size > XO_MEMORY_SIZE - ROM_START) {
+        scan->platform = PLATFORM_MEGACHIP;
+        return;
+    }
+    if (size > SCAN_MAX) {
+        // only XO-CHIP and MegaChip have room for it
+        scan->platform = PLATFORM_XOCHIP;
+        return;
+    }
+    unsigned char flags[SCAN_MAX + 1];
+    unsigned int work[SCAN_MAX + 1];
+    // decoded with every extension, so their instructions are walked with the right size
+    struct Cfg cfg;
+    cfgReach(&cfg, rom, size, ISA_SCHIP | ISA_XOCHIP | ISA_MEGACHIP, flags, work);
+    for (size_t pc = 0; pc + 1 < size; pc++) {
+        if ((cfg.flags[pc] & CFG_CODE) == 0) {
+            continue;
+        }
+        unsigned short opcode = rom[pc] << 8 | rom[pc + 1];
+        // every profile runs the CHIP-8 instructions
+        for (int profile = 0; profile < PROFILES && decodeOp(0, opcode) == OP_UNKNOWN; profile++) {
+            scan->missing[profile] += decodeOp(profileIsa(profile), opcode) == OP_UNKNOWN;
+        }
+        // 0011 switches MegaChip mode on
+        if (opcode == 0x0011) {
+            scan->platform = PLATFORM_MEGACHIP;
+        }
+        // F000 NNNN, F002, FN01, 5XY2, 5XY3
+        if (scan->platform != PLATFORM_MEGACHIP &&
+            (opcode == 0xF000 || opcode == 0xF002 || (opcode & 0xF0FF) == 0xF001 || (opcode & 0xF00E) == 0x5002)) {
+            scan->platform = PLATFORM_XOCHIP;
+        }
+        // 00Cn, 00FB-00FF, FX30, FX75, FX85
+        if (scan->platform == PLATFORM_CHIP8 &&
+            ((opcode & 0xFFF0) == 0x00C0 || (opcode >= 0x00FB && opcode <= 0x00FF) || (opcode & 0xF0FF) == 0xF030 ||
+             (opcode & 0xF0FF) == 0xF075 || (opcode & 0xF0FF) == 0xF085)) {
+            scan->platform = PLATFORM_SCHIP;
+        }
+    }
+}
+
+/**
+ * @brief detectPlatform(rom, size) is used to guess the target machine of a ROM,
+ * see scanPlatform()
+ * @param rom ROM image, loaded at 0x200
+ * @param size size of the image
+ * @return the most capable platform whose instructions were found
+ */
+enum Platform detectPlatform(const unsigned char *rom, size_t size) {
+    struct PlatformScan scan;
+    scanPlatform(&scan, rom, size);
+    return scan.platform;
+}
+
+enum Profile defaultProfile(enum Platform platform) {
+    switch (platform) {
+    case PLATFORM_SCHIP:
+        return PROFILE_SCHIP;
+    case PLATFORM_XOCHIP:
+        return PROFILE_XOCHIP;
+    case PLATFORM_MEGACHIP:
+        return PROFILE_MEGACHIP;
+    default:
+        return PROFILE_CHIP8;
+    }
+}
+
+// bytes of address space the profile's machine has
+unsigned int profileMemory(enum Profile profile) {
+    switch (profile) {
+    case PROFILE_XOCHIP:
+        return XO_MEMORY_SIZE;
+    case PROFILE_MEGACHIP:
+        return MEGA_MEMORY_SIZE;
+    default:
+        return MEMORY_SIZE;
+    }
+}
+
+// ISA_* extensions of the profile's interpreter, matches the HAS_* flags in chip8.c
+unsigned int profileIsa(enum Profile profile) {
+    switch (profile) {
+    case PROFILE_SCHIP:
+        return ISA_SCHIP;
+    case PROFILE_XOCHIP:
+        return ISA_SCHIP | ISA_XOCHIP;
+    case PROFILE_MEGACHIP:
+        return ISA_SCHIP | ISA_MEGACHIP;
+    default:
+        return 0;
+    }
+}
+
+const char *platformName(enum Platform platform) {
+    return platform < PLATFORMS ? platform_names[platform] : "unknown";
+}
+
+const char *profileName(enum Profile profile) {
+    return profile < PROFILES ? profile_names[profile] : "unknown";
+}
+
+// returns -1 for unknown names
+int platformFromName(const char *name) {
+    for (int i = 0; i < PLATFORMS; i++) {
+        if (strcmp(platform_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int profileFromName(const char *name) {
+    for (int i = 0; i < PROFILES; i++) {
+        if (strcmp(profile_names[i], name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,226 @@
+#include "inc/profiler.h"
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef CHIP8_PROFILE
+
+// 2NNN targets are 12-bit
+#define PROF_ADDRESSES 4096
+
+struct ProfLine {
+    unsigned short addr;
+    unsigned long long calls;
+    unsigned long long inclusive;
+    unsigned long long exclusive;
+};
+
+static int newNode(struct Profiler *prof, unsigned short addr, int parent) {
+    if (prof->count == prof->capacity) {
+        int capacity = prof->capacity ? prof->capacity * 2 : 256;
+        struct ProfNode *nodes = realloc(prof->nodes, capacity * sizeof(struct ProfNode));
+        if (nodes == 0x00) {
+            abort();
+        }
+        prof->nodes = nodes;
+        prof->capacity = capacity;
+    }
+    struct ProfNode *node = &prof->nodes[prof->count];
+    memset(node, 0, sizeof(struct ProfNode));
+    node->addr = addr;
+    node->parent = parent;
+    node->child = -1;
+    node->sibling = -1;
+    if (parent >= 0) {
+        node->sibling = prof->nodes[parent].child;
+        prof->nodes[parent].child = prof->count;
+    }
+    return prof->count++;
+}
+
+/**
+ * @brief profInit(prof, now) is used to start profiling a running machine
+ * @param prof the profiler, set chip8->profiler to it afterwards
+ * @param now chip8->cycles, everything before it is not counted
+ * @return void
+ */
+void profInit(struct Profiler *prof, unsigned long long now) {
+    memset(prof, 0, sizeof(struct Profiler));
+    newNode(prof, 0, -1);
+    prof->frames[0].entry = now;
+    prof->depth = 1;
+}
+
+/**
+ * @brief profEnter(prof, addr, now) is called by stackPush() for every 2NNN
+ * @param prof the profiler
+ * @param addr the subroutine being called
+ * @param now chip8->cycles at the call
+ * @return void
+ */
+void profEnter(struct Profiler *prof, unsigned short addr, unsigned long long now) {
+    if (prof->depth == PROF_DEPTH) {
+        prof->untracked++;
+        prof->dropped++;
+        return;
+    }
+    int parent = prof->frames[prof->depth - 1].node;
+    int node = prof->nodes[parent].child;
+    while (node >= 0 && prof->nodes[node].addr != addr) {
+        node = prof->nodes[node].sibling;
+    }
+    if (node < 0) {
+        node = newNode(prof, addr, parent);
+    }
+    prof->nodes[node].calls++;
+    struct ProfFrame *frame = &prof->frames[prof->depth++];
+    frame->node = node;
+    frame->entry = now;
+    frame->children = 0;
+}
+
+/**
+ * @brief profLeave(prof, now) is called by stackPop() for every 00EE,
+ * a return without a matching call is ignored
+ * @param prof the profiler
+ * @param now chip8->cycles at the return
+ * @return void
+ */
+void profLeave(struct Profiler *prof, unsigned long long now) {
+    if (prof->untracked > 0) {
+        prof->untracked--;
+        return;
+    }
+    if (prof->depth == 1) {
+        return;
+    }
+    struct ProfFrame *frame = &prof->frames[--prof->depth];
+    unsigned long long elapsed = now - frame->entry;
+    prof->nodes[frame->node].self += elapsed - frame->children;
+    prof->frames[prof->depth - 1].children += elapsed;
+}
+
+// self cycles of every node, with the calls still running charged up to now
+static unsigned long long *selfCycles(struct Profiler *prof, unsigned long long now) {
+    unsigned long long *self = malloc(prof->count * sizeof(unsigned long long));
+    if (self == 0x00) {
+        return 0x00;
+    }
+    for (int i = 0; i < prof->count; i++) {
+        self[i] = prof->nodes[i].self;
+    }
+    for (int i = 0; i < prof->depth; i++) {
+        struct ProfFrame *frame = &prof->frames[i];
+        unsigned long long open = i + 1 < prof->depth ? now - prof->frames[i + 1].entry : 0;
+        self[frame->node] += now - frame->entry - frame->children - open;
+    }
+    return self;
+}
+
+static void writePath(struct Profiler *prof, FILE *out, int node) {
+    if (node == 0) {
+        fputs("main", out);
+        return;
+    }
+    writePath(prof, out, prof->nodes[node].parent);
+    fprintf(out, ";0x%03X", prof->nodes[node].addr);
+}
+
+/**
+ * @brief profWriteFolded(prof, out, now) is used to export the profile as folded
+ * stacks, one "main;0x2A4;0x31C cycles" line per call path, which
+ * flamegraph.pl, speedscope and inferno read as is
+ * @param prof the profiler
+ * @param out file to write to
+ * @param now chip8->cycles, calls still running are charged up to it
+ * @return 0 on success, -1 on errors
+ */
+int profWriteFolded(struct Profiler *prof, FILE *out, unsigned long long now) {
+    unsigned long long *self = selfCycles(prof, now);
+    if (self == 0x00) {
+        return -1;
+    }
+    for (int i = 0; i < prof->count; i++) {
+        if (self[i] > 0) {
+            writePath(prof, out, i);
+            fprintf(out, " %llu\n", self[i]);
+        }
+    }
+    free(self);
+    return ferror(out) ? -1 : 0;
+}
+
+static int byExclusive(const void *a, const void *b) {
+    const struct ProfLine *x = a, *y = b;
+    return x->exclusive < y->exclusive ? 1 : x->exclusive > y->exclusive ? -1 : x->addr - y->addr;
+}
+
+/**
+ * @brief profWriteReport(prof, out, now) is used to print inclusive and exclusive
+ * cycles per subroutine, heaviest first; a recursive subroutine's inclusive
+ * time counts each cycle once
+ * @param prof the profiler
+ * @param out file to write to
+ * @param now chip8->cycles, calls still running are charged up to it
+ * @return 0 on success, -1 on errors
+ */
+int profWriteReport(struct Profiler *prof, FILE *out, unsigned long long now) {
+    unsigned long long *self = selfCycles(prof, now);
+    unsigned long long *inclusive = malloc(prof->count * sizeof(unsigned long long));
+    struct ProfLine *lines = calloc(PROF_ADDRESSES, sizeof(struct ProfLine));
+    if (self == 0x00 || inclusive == 0x00 || lines == 0x00) {
+        free(self);
+        free(inclusive);
+        free(lines);
+        return -1;
+    }
+    // callees always come after their caller, so a backwards pass sums up the tree
+    memcpy(inclusive, self, prof->count * sizeof(unsigned long long));
+    for (int i = prof->count - 1; i > 0; i--) {
+        inclusive[prof->nodes[i].parent] += inclusive[i];
+    }
+    for (int i = 1; i < prof->count; i++) {
+        struct ProfNode *node = &prof->nodes[i];
+        struct ProfLine *line = &lines[node->addr % PROF_ADDRESSES];
+        line->addr = node->addr;
+        line->calls += node->calls;
+        line->exclusive += self[i];
+        // only the outermost call of a recursion adds inclusive time
+        int up = node->parent;
+        while (up > 0 && prof->nodes[up].addr != node->addr) {
+            up = prof->nodes[up].parent;
+        }
+        if (up == 0) {
+            line->inclusive += inclusive[i];
+        }
+    }
+    int used = 0;
+    for (int i = 0; i < PROF_ADDRESSES; i++) {
+        if (lines[i].calls > 0) {
+            lines[used++] = lines[i];
+        }
+    }
+    qsort(lines, used, sizeof(struct ProfLine), byExclusive);
+    unsigned long long total = inclusive[0] ? inclusive[0] : 1;
+    fprintf(out, "%8s %12s %14s %14s %7s\n", "address", "calls", "inclusive", "exclusive", "excl%");
+    fprintf(out, "%8s %12s %14llu %14llu %6.2f%%\n", "main", "-", inclusive[0], self[0], 100.0 * self[0] / total);
+    for (int i = 0; i < used; i++) {
+        fprintf(out, "   0x%03X %12llu %14llu %14llu %6.2f%%\n", lines[i].addr, lines[i].calls, lines[i].inclusive,
+                lines[i].exclusive, 100.0 * lines[i].exclusive / total);
+    }
+    if (prof->dropped > 0) {
+        fprintf(out, "%llu calls nested deeper than %d were not tracked\n", prof->dropped, PROF_DEPTH);
+    }
+    free(self);
+    free(inclusive);
+    free(lines);
+    return ferror(out) ? -1 : 0;
+}
+
+void profFree(struct Profiler *prof) {
+    free(prof->nodes);
+    prof->nodes = 0x00;
+    prof->count = 0;
+    prof->capacity = 0;
+}
+
+#endif
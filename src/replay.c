@@ -0,0 +1,182 @@
+#include "inc/replay.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define HEADER_SIZE 20
+
+static void putLE(unsigned char *out, unsigned long long val, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = val >> (8 * i);
+    }
+}
+
+static unsigned long long getLE(const unsigned char *in, int bytes) {
+    unsigned long long val = 0;
+    for (int i = 0; i < bytes; i++) {
+        val |= (unsigned long long)in[i] << (8 * i);
+    }
+    return val;
+}
+
+static void putRecord(struct Recorder *rec, unsigned char tag, unsigned long long cycle) {
+    // LEB128: 7 bits per byte, high bit set while more bytes follow
+    unsigned char out[11];
+    int n = 0;
+    unsigned long long delta = cycle - rec->cycle;
+    out[n++] = tag;
+    do {
+        out[n] = delta & 0x7F;
+        delta >>= 7;
+        if (delta) {
+            out[n] |= 0x80;
+        }
+        n++;
+    } while (delta);
+    fwrite(out, 1, n, rec->file);
+    rec->cycle = cycle;
+}
+
+/**
+ * @brief recOpen(rec, path, chip8) is used to start logging key changes,
+ * call it right after chLoad() and chSeed()
+ * @param rec the recorder
+ * @param path log file to create
+ * @param chip8 chip8's state, supplies the seed and ROM hash for the header
+ * @return 0 on success, -1 if the file can't be created
+ */
+int recOpen(struct Recorder *rec, const char *path, struct Chip8 *chip8) {
+    unsigned char header[HEADER_SIZE] = {'C', '8', 'I', 'R', REPLAY_VERSION, CYCLES_PER_FRAME};
+    if ((rec->file = fopen(path, "wb")) == 0x00) {
+        printf("Error creating input log %s\n", path);
+        return -1;
+    }
+    header[6] = chip8->profile;
+    putLE(header + 8, chip8->rng, 4);
+    putLE(header + 12, chip8->rom_hash, 8);
+    fwrite(header, 1, HEADER_SIZE, rec->file);
+    rec->cycle = chip8->cycles;
+    return 0;
+}
+
+void recKey(struct Recorder *rec, struct Chip8 *chip8, int key, bool down) {
+    putRecord(rec, key | (down ? REPLAY_KEY_DOWN : 0), chip8->cycles);
+}
+
+/**
+ * @brief recClose(rec, chip8) is used to terminate the log with the final
+ * screen hash, which replayRun() checks against
+ * @param rec the recorder
+ * @param chip8 chip8's state
+ * @return void
+ */
+void recClose(struct Recorder *rec, struct Chip8 *chip8) {
+    unsigned char hash[8];
+    putRecord(rec, REPLAY_END, chip8->cycles);
+    putLE(hash, chScreenHash(chip8), 8);
+    fwrite(hash, 1, sizeof(hash), rec->file);
+    fclose(rec->file);
+    rec->file = 0x00;
+}
+
+// reads the next record into replay->tag/next, -1 on a truncated log
+static int replayNext(struct Replay *replay) {
+    unsigned long long delta = 0;
+    int shift = 0;
+    unsigned char byte;
+    if (replay->pos >= replay->size) {
+        return -1;
+    }
+    replay->tag = replay->data[replay->pos++];
+    do {
+        if (replay->pos >= replay->size || shift > 63) {
+            return -1;
+        }
+        byte = replay->data[replay->pos++];
+        delta |= (unsigned long long)(byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    replay->next += delta;
+    if (replay->tag == REPLAY_END) {
+        if (replay->pos + 8 > replay->size) {
+            return -1;
+        }
+        replay->screen_hash = getLE(replay->data + replay->pos, 8);
+    }
+    return 0;
+}
+
+/**
+ * @brief replayOpen(replay, path) is used to read an input log into memory
+ * @param replay the replay
+ * @param path log file written by recOpen()
+ * @return 0 on success, -1 if the file is missing or malformed
+ */
+int replayOpen(struct Replay *replay, const char *path) {
+    FILE *ptr;
+    memset(replay, 0, sizeof(struct Replay));
+    if ((ptr = fopen(path, "rb")) == 0x00) {
+        printf("Error opening input log %s\n", path);
+        return -1;
+    }
+    fseek(ptr, 0, SEEK_END);
+    replay->size = ftell(ptr);
+    fseek(ptr, 0, SEEK_SET);
+    replay->data = malloc(replay->size ? replay->size : 1);
+    if (fread(replay->data, 1, replay->size, ptr) != replay->size || replay->size < HEADER_SIZE ||
+        memcmp(replay->data, "C8IR", 4) != 0 || replay->data[4] != REPLAY_VERSION ||
+        replay->data[5] != CYCLES_PER_FRAME) {
+        printf("Error: %s is not a compatible input log\n", path);
+        fclose(ptr);
+        replayClose(replay);
+        return -1;
+    }
+    fclose(ptr);
+    replay->profile = replay->data[6];
+    replay->seed = getLE(replay->data + 8, 4);
+    replay->rom_hash = getLE(replay->data + 12, 8);
+    replay->pos = HEADER_SIZE;
+    return replayNext(replay);
+}
+
+/**
+ * @brief replayRun(replay, chip8) is used to drive the keyboard from the log
+ * and run the emulator as fast as possible until the end record
+ * @param replay an opened replay
+ * @param chip8 chip8's state, freshly loaded with the logged ROM
+ * @return 0 if the final screen matches the recording, 1 if it differs,
+ * -1 if the log is truncated
+ */
+int replayRun(struct Replay *replay, struct Chip8 *chip8) {
+    chSeed(chip8, replay->seed);
+    chSetProfile(chip8, replay->profile);
+    replay->next += chip8->cycles;
+    for (;;) {
+        // frames without input run on the profile's specialized loop
+        if (replay->next >= chip8->cycles + CYCLES_PER_FRAME) {
+            chFrame(chip8);
+            continue;
+        }
+        for (int i = 0; i < CYCLES_PER_FRAME; i++) {
+            while (replay->next == chip8->cycles) {
+                if (replay->tag == REPLAY_END) {
+                    return chScreenHash(chip8) == replay->screen_hash ? 0 : 1;
+                }
+                if (replay->tag & REPLAY_KEY_DOWN) {
+                    keyDown(&chip8->keyboard, replay->tag & 0x0F);
+                } else {
+                    keyUp(&chip8->keyboard, replay->tag & 0x0F);
+                }
+                if (replayNext(replay) == -1) {
+                    return -1;
+                }
+            }
+            chStep(chip8);
+        }
+        chTick(chip8);
+    }
+}
+
+void replayClose(struct Replay *replay) {
+    free(replay->data);
+    replay->data = 0x00;
+}
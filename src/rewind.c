@@ -0,0 +1,159 @@
+#include "inc/rewind.h"
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char *putVarint(unsigned char *out, size_t val) {
+    do {
+        *out = val & 0x7F;
+        val >>= 7;
+        if (val) {
+            *out |= 0x80;
+        }
+        out++;
+    } while (val);
+    return out;
+}
+
+static const unsigned char *getVarint(const unsigned char *in, size_t *val) {
+    int shift = 0;
+    *val = 0;
+    do {
+        *val |= (size_t)(*in & 0x7F) << shift;
+        shift += 7;
+    } while (*in++ & 0x80);
+    return in;
+}
+
+// run-length encodes prev XOR cur into out, returns the encoded size
+static size_t encodeDelta(const unsigned char *prev, const unsigned char *cur, size_t size, unsigned char *out) {
+    unsigned char *start = out;
+    size_t i = 0;
+    while (i < size) {
+        size_t zeros = i;
+        while (i < size && prev[i] == cur[i]) {
+            i++;
+        }
+        zeros = i - zeros;
+        size_t literals = i;
+        // a single equal byte is cheaper to keep inside the literal run
+        while (i < size && i - literals < 127 &&
+               (prev[i] != cur[i] || (i + 1 < size && prev[i + 1] != cur[i + 1]))) {
+            i++;
+        }
+        literals = i - literals;
+        out = putVarint(out, zeros);
+        out = putVarint(out, literals);
+        for (size_t j = i - literals; j < i; j++) {
+            *out++ = prev[j] ^ cur[j];
+        }
+    }
+    return out - start;
+}
+
+// XORs an encoded delta into state
+static void applyDelta(unsigned char *state, size_t size, const unsigned char *in) {
+    size_t i = 0;
+    while (i < size) {
+        size_t zeros, literals;
+        in = getVarint(in, &zeros);
+        in = getVarint(in, &literals);
+        i += zeros;
+        for (size_t j = 0; j < literals; j++) {
+            state[i++] ^= *in++;
+        }
+    }
+}
+
+// copies between the ring and a flat buffer, splitting at the wrap point
+static void ringCopy(struct Rewind *rewind, size_t pos, unsigned char *buf, size_t len, int to_ring) {
+    size_t offset = pos % rewind->capacity;
+    size_t first = len < rewind->capacity - offset ? len : rewind->capacity - offset;
+    if (to_ring) {
+        memcpy(rewind->data + offset, buf, first);
+        memcpy(rewind->data, buf + first, len - first);
+    } else {
+        memcpy(buf, rewind->data + offset, first);
+        memcpy(buf + first, rewind->data, len - first);
+    }
+}
+
+/**
+ * @brief rewindInit(rewind, capacity, chip8) is used to allocate the delta ring,
+ * the current machine becomes the oldest reachable frame
+ * @param rewind the rewind buffer, large, so keep it off the stack
+ * @param capacity byte budget for the encoded deltas, REWIND_CAPACITY is a good default
+ * @param chip8 chip8's state
+ * @return 0 on success, -1 if the ring can't be allocated
+ */
+int rewindInit(struct Rewind *rewind, size_t capacity, struct Chip8 *chip8) {
+    memset(rewind, 0, sizeof(struct Rewind));
+    rewind->size = stateSize(chip8);
+    rewind->state = malloc(rewind->size);
+    rewind->scratch = malloc(REWIND_MAX_DELTA(rewind->size) + rewind->size);
+    if (capacity < REWIND_MAX_DELTA(rewind->size) || rewind->state == 0x00 || rewind->scratch == 0x00 ||
+        (rewind->data = malloc(capacity)) == 0x00) {
+        rewindFree(rewind);
+        return -1;
+    }
+    rewind->capacity = capacity;
+    stateSave(chip8, rewind->state);
+    return 0;
+}
+
+/**
+ * @brief rewindPush(rewind, chip8) is used to record one frame, call it once
+ * per emulated frame; the oldest frames are dropped when the ring is full
+ * @param rewind the rewind buffer
+ * @param chip8 chip8's state
+ * @return void
+ */
+void rewindPush(struct Rewind *rewind, struct Chip8 *chip8) {
+    if (stateSize(chip8) != rewind->size) {
+        // the machine changed profile, older frames can't be restored into it
+        size_t capacity = rewind->capacity;
+        rewindFree(rewind);
+        rewindInit(rewind, capacity, chip8);
+        return;
+    }
+    unsigned char *cur = rewind->scratch + REWIND_MAX_DELTA(rewind->size);
+    stateSave(chip8, cur);
+    size_t size = encodeDelta(rewind->state, cur, rewind->size, rewind->scratch);
+    while (rewind->count > 0 &&
+           (rewind->count == REWIND_FRAMES || rewind->head - rewind->tail + size > rewind->capacity)) {
+        rewind->tail += rewind->sizes[rewind->first];
+        rewind->first = (rewind->first + 1) % REWIND_FRAMES;
+        rewind->count--;
+    }
+    ringCopy(rewind, rewind->head, rewind->scratch, size, 1);
+    rewind->head += size;
+    rewind->sizes[(rewind->first + rewind->count) % REWIND_FRAMES] = size;
+    rewind->count++;
+    memcpy(rewind->state, cur, rewind->size);
+}
+
+/**
+ * @brief rewindStep(rewind, chip8) is used to go back one frame
+ * @param rewind the rewind buffer
+ * @param chip8 chip8's state, set to the previous frame
+ * @return 0 on success, -1 once the oldest recorded frame is reached
+ */
+int rewindStep(struct Rewind *rewind, struct Chip8 *chip8) {
+    if (rewind->count == 0) {
+        return -1;
+    }
+    rewind->count--;
+    size_t size = rewind->sizes[(rewind->first + rewind->count) % REWIND_FRAMES];
+    rewind->head -= size;
+    ringCopy(rewind, rewind->head, rewind->scratch, size, 0);
+    applyDelta(rewind->state, rewind->size, rewind->scratch);
+    return stateLoad(chip8, rewind->state, rewind->size);
+}
+
+void rewindFree(struct Rewind *rewind) {
+    free(rewind->data);
+    free(rewind->state);
+    free(rewind->scratch);
+    rewind->data = 0x00;
+    rewind->state = 0x00;
+    rewind->scratch = 0x00;
+}
@@ -0,0 +1,61 @@
+#include "inc/rom.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief romOpen(rom, path) is used to map a ROM file read-only
+ * and check that it fits in memory, nothing is read yet
+ * @param rom filled in on success
+ * @param path ROM file
+ * @return ROM_OK, or the reason the file can't be loaded
+ */
+enum RomError romOpen(struct Rom *rom, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return ROM_ERR_OPEN;
+    }
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        return ROM_ERR_OPEN;
+    }
+    if (st.st_size == 0) {
+        close(fd);
+        return ROM_ERR_EMPTY;
+    }
+    if (st.st_size > ROM_MAX_SIZE) {
+        close(fd);
+        return ROM_ERR_TOO_LARGE;
+    }
+    void *map = mmap(0x00, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return ROM_ERR_MAP;
+    }
+    rom->data = map;
+    rom->size = st.st_size;
+    return ROM_OK;
+}
+
+void romClose(struct Rom *rom) {
+    munmap((void *)rom->data, rom->size);
+    rom->data = 0x00;
+}
+
+const char *romError(enum RomError error) {
+    switch (error) {
+    case ROM_OK:
+        return "ok";
+    case ROM_ERR_OPEN:
+        return "could not open file";
+    case ROM_ERR_EMPTY:
+        return "file is empty";
+    case ROM_ERR_TOO_LARGE:
+        return "file does not fit in memory";
+    case ROM_ERR_MAP:
+        return "could not map file";
+    }
+    return "unknown error";
+}
@@ -1,18 +1,60 @@
 #include "inc/screen.h"
-#include <assert.h>
+#include "inc/hash.h"
 #include <memory.h>
+#include <stdio.h>
 
-void checkBounds(int x, int y) {
-    assert(x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT);
+// clears the selected planes
+void clearScreen(struct Screen *screen) {
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (screen->planes & (1 << plane)) {
+            memset(screen->rows[plane], 0, sizeof(screen->rows[plane]));
+        }
+    }
 }
 
-void clearScreen(struct Screen *screen) {
-    memset(screen->pixels, 0, sizeof(screen->pixels));
+/**
+ * @brief setHires(screen, hires) is used by 00FE/00FF to switch resolution,
+ * the screen is cleared since the old picture has no meaning in the new mode
+ * @param screen the display
+ * @param hires true for 128x64, false for 64x32
+ * @return void
+ */
+void setHires(struct Screen *screen, bool hires) {
+    screen->hires = hires;
+    memset(screen->rows, 0, sizeof(screen->rows));
+}
+
+int screenWidth(struct Screen *screen) {
+    return screen->hires ? HIRES_WIDTH : WIDTH;
+}
+
+int screenHeight(struct Screen *screen) {
+    return screen->hires ? HIRES_HEIGHT : HEIGHT;
 }
 
 bool screenIsSet(struct Screen *screen, int x, int y) {
-    checkBounds(x, y);
-    return screen->pixels[y][x];
+    return screenPixel(screen, x, y) != 0;
+}
+
+/**
+ * @brief screenPixel(screen, x, y) is used to read the colour of a pixel,
+ * coordinates past an edge wrap around to the other side
+ * @return 0-3, bit n set if the pixel is lit on plane n
+ */
+int screenPixel(struct Screen *screen, int x, int y) {
+#ifdef CHIP8_CHECKED
+    if (x < 0 || x >= screenWidth(screen) || y < 0 || y >= screenHeight(screen)) {
+        printf("[checked] pixel %d,%d is off the screen\n", x, y);
+    }
+#endif
+    // both dimensions are powers of two, so this wraps like memory addresses do
+    x &= screenWidth(screen) - 1;
+    y &= screenHeight(screen) - 1;
+    int colour = 0;
+    for (int plane = 0; plane < PLANES; plane++) {
+        colour |= ((screen->rows[plane][y][x / 64] >> (63 - x % 64)) & 1) << plane;
+    }
+    return colour;
 }
 
 /*	hardest part of all!
@@ -40,21 +82,178 @@ bool screenIsSet(struct Screen *screen, int x, int y) {
     the instruction then will be read as D124 which means
     draw 4 bytes of sprites at x coordinate 10 and y coordinate 20
 */
-bool drawSprite(struct Screen *screen, int x, int y, const char *sprite, int num) {
+// XORs a left-aligned sprite row of up to 16 pixels into row y at column x
+static inline bool blitRow(struct Screen *screen, int plane, int x, int y, uint64_t bits, bool clip) {
+    uint64_t *row = screen->rows[plane][y];
+    uint64_t hit;
+    if (!screen->hires) {
+        // a rotate wraps around the 64 pixel row for free
+        uint64_t span = clip ? bits >> x : (bits >> x) | (x ? bits << (64 - x) : 0);
+        hit = row[0] & span;
+        row[0] ^= span;
+        return hit != 0;
+    }
+    uint64_t left, right;
+    if (x < 64) {
+        left = bits >> x;
+        right = x ? bits << (64 - x) : 0;
+    } else {
+        // whatever falls off the right edge wraps into word 0
+        right = bits >> (x - 64);
+        left = clip || x == 64 ? 0 : bits << (128 - x);
+    }
+    hit = (row[0] & left) | (row[1] & right);
+    row[0] ^= left;
+    row[1] ^= right;
+    return hit != 0;
+}
+
+static inline bool blit(struct Screen *screen, int plane, int x, int y, const unsigned char *sprite, int num, int wide,
+                        bool clip) {
     bool pixelCollison = false;
-    int byte = 8;
-    // num == N in main.c execOpcJode()
+    int width = screenWidth(screen);
+    int height = screenHeight(screen);
+    x %= width;
+    y %= height;
     for (int y_cord = 0; y_cord < num; y_cord++) {
-        char c = sprite[y_cord];
-        for (int x_cord = 0; x_cord < byte; x_cord++) {
-            if ((c & (0x80 >> x_cord)) == 0) {
-                continue;
+        if (clip && y + y_cord >= height) {
+            break;
+        }
+        uint64_t bits = wide ? (uint64_t)(sprite[2 * y_cord] << 8 | sprite[2 * y_cord + 1]) << 48
+                             : (uint64_t)sprite[y_cord] << 56;
+        pixelCollison |= blitRow(screen, plane, x, (y + y_cord) % height, bits, clip);
+    }
+    return pixelCollison;
+}
+
+bool drawSprite(struct Screen *screen, int x, int y, const char *sprite, int num) {
+    // num == N in execOpcode()
+    return blit(screen, 0, x, y, (const unsigned char *)sprite, num, false, false);
+}
+
+/**
+ * @brief drawSpriteClipped(screen, x, y, sprite, num) is drawSprite() for machines
+ * that clip sprites at the edges: the start position still wraps around
+ * the screen, but pixels that would land past an edge are dropped
+ * @return true if any pixel was erased
+ */
+bool drawSpriteClipped(struct Screen *screen, int x, int y, const char *sprite, int num) {
+    return blit(screen, 0, x, y, (const unsigned char *)sprite, num, false, true);
+}
+
+/**
+ * @brief drawLargeSprite(screen, x, y, sprite) is used by SUPER-CHIP DXY0
+ * to draw a 16x16 sprite stored as 16 rows of two bytes
+ * @return true if any pixel was erased
+ */
+bool drawLargeSprite(struct Screen *screen, int x, int y, const char *sprite) {
+    return blit(screen, 0, x, y, (const unsigned char *)sprite, 16, true, false);
+}
+
+bool drawLargeSpriteClipped(struct Screen *screen, int x, int y, const char *sprite) {
+    return blit(screen, 0, x, y, (const unsigned char *)sprite, 16, true, true);
+}
+
+/**
+ * @brief drawSpritePlanes(screen, x, y, sprite, num) is used by XO-CHIP DXYN to draw
+ * into every selected plane, the data for each plane follows the previous one;
+ * num == 0 draws 16x16 sprites
+ * @return true if any pixel was erased
+ */
+bool drawSpritePlanes(struct Screen *screen, int x, int y, const char *sprite, int num) {
+    bool pixelCollison = false;
+    const unsigned char *data = (const unsigned char *)sprite;
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (!(screen->planes & (1 << plane))) {
+            continue;
+        }
+        if (num == 0) {
+            pixelCollison |= blit(screen, plane, x, y, data, 16, true, false);
+            data += 32;
+        } else {
+            pixelCollison |= blit(screen, plane, x, y, data, num, false, false);
+            data += num;
+        }
+    }
+    return pixelCollison;
+}
+
+/**
+ * @brief scrollDown(screen, n) is used by 00CN to move the picture down n rows,
+ * rows are moved whole so it costs one memmove
+ * @param screen the display
+ * @param n number of rows
+ * @return void
+ */
+void scrollDown(struct Screen *screen, int n) {
+    int height = screenHeight(screen);
+    if (n > height) {
+        n = height;
+    }
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (screen->planes & (1 << plane)) {
+            uint64_t(*rows)[ROW_WORDS] = screen->rows[plane];
+            memmove(rows[n], rows[0], (height - n) * sizeof(rows[0]));
+            memset(rows[0], 0, n * sizeof(rows[0]));
+        }
+    }
+}
+
+// 00DN: moves the picture up n rows
+void scrollUp(struct Screen *screen, int n) {
+    int height = screenHeight(screen);
+    if (n > height) {
+        n = height;
+    }
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (screen->planes & (1 << plane)) {
+            uint64_t(*rows)[ROW_WORDS] = screen->rows[plane];
+            memmove(rows[0], rows[n], (height - n) * sizeof(rows[0]));
+            memset(rows[height - n], 0, n * sizeof(rows[0]));
+        }
+    }
+}
+
+// 00FB: moves the picture 4 pixels right
+void scrollRight(struct Screen *screen) {
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (!(screen->planes & (1 << plane))) {
+            continue;
+        }
+        for (int y = 0; y < screenHeight(screen); y++) {
+            uint64_t *row = screen->rows[plane][y];
+            if (screen->hires) {
+                row[1] = row[1] >> 4 | row[0] << 60;
             }
-            if (screen->pixels[(y_cord + y) % HEIGHT][(x_cord + x) % WIDTH]) {
-                pixelCollison = true;
+            row[0] >>= 4;
+        }
+    }
+}
+
+// 00FC: moves the picture 4 pixels left
+void scrollLeft(struct Screen *screen) {
+    for (int plane = 0; plane < PLANES; plane++) {
+        if (!(screen->planes & (1 << plane))) {
+            continue;
+        }
+        for (int y = 0; y < screenHeight(screen); y++) {
+            uint64_t *row = screen->rows[plane][y];
+            if (screen->hires) {
+                row[0] = row[0] << 4 | row[1] >> 60;
+                row[1] <<= 4;
+            } else {
+                row[0] <<= 4;
             }
-            screen->pixels[(y_cord + y) % HEIGHT][(x_cord + x) % WIDTH] ^= true;
         }
     }
-    return pixelCollison;
+}
+
+/**
+ * @brief screenHash(screen) is used to fingerprint the framebuffer,
+ * two runs that end on the same picture give the same hash
+ * @param screen the display
+ * @return 64-bit hash of every plane and the resolution
+ */
+unsigned long long screenHash(struct Screen *screen) {
+    return hashUpdate(hashBytes(screen->rows, sizeof(screen->rows)), &screen->hires, 1);
 }
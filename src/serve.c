@@ -0,0 +1,114 @@
+#include "inc/farm.h"
+#include "inc/metrics.h"
+#include <dirent.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+/*
+    Runs a farm of instances over the ROMs of a directory and serves its
+    metrics in Prometheus text format, until the given number of seconds
+    has passed or SIGINT/SIGTERM. Scrape it with
+        curl http://127.0.0.1:<port>/metrics
+        curl --unix-socket <path> http://localhost/metrics
+*/
+#define MAX_PATH 4096
+// how often the main thread looks at the clock and the signals while no scraper comes
+#define POLL_MS 100
+
+static volatile sig_atomic_t quit;
+
+static void onSignal(int sig) {
+    (void)sig;
+    quit = 1;
+}
+
+static int byName(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static int writeMetrics(void *data, FILE *out) {
+    return farmWriteMetrics(data, out);
+}
+
+// runs the farm and answers scrapers until it is time to stop, then prints a summary
+static int serve(struct Farm *farm, const char *address, double seconds) {
+    struct MetricsServer server;
+    if (metricsOpen(&server, address) == -1) {
+        return -1;
+    }
+    if (farmStart(farm) == -1) {
+        metricsClose(&server);
+        return -1;
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    printf("%d instances of %d ROMs on %d workers, metrics on %s\n", farm->instance_count, farm->rom_count,
+           farm->worker_count, address);
+    fflush(stdout);
+    while (!quit && (seconds <= 0 || farmNow() - farm->start < seconds * 1e9)) {
+        metricsServe(&server, POLL_MS, writeMetrics, farm);
+    }
+    farmStop(farm);
+    double elapsed = (farmNow() - farm->start) / 1e9;
+    unsigned long long instructions = 0, frames = 0, dropped = 0;
+    for (int w = 0; w < farm->worker_count; w++) {
+        instructions += farm->workers[w].instructions;
+        frames += farm->workers[w].frames;
+        dropped += farm->workers[w].dropped;
+    }
+    printf("%llu frames, %llu dropped, %.2f MIPS over %.1f s\n", frames, dropped, instructions / elapsed / 1e6,
+           elapsed);
+    metricsClose(&server);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc != 5 && argc != 6) {
+        printf("[Error] usage: ./chip8-farm <rom dir> <instances> <workers> <port or socket path> [seconds]\n");
+        return -1;
+    }
+    int instances = atoi(argv[2]), workers = atoi(argv[3]);
+    double seconds = argc == 6 ? atof(argv[5]) : 0;
+    if (instances < 1 || workers < 1 || workers > FARM_MAX_WORKERS) {
+        printf("[Error] instances must be at least 1 and workers 1 to %d\n", FARM_MAX_WORKERS);
+        return -1;
+    }
+    DIR *d = opendir(argv[1]);
+    if (d == 0x00) {
+        printf("[Error] could not read %s\n", argv[1]);
+        return -1;
+    }
+    char *paths[FARM_MAX_ROMS];
+    int count = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != 0x00 && count < FARM_MAX_ROMS) {
+        size_t len = strlen(ent->d_name);
+        if (ent->d_name[0] != '.' && len > 4 && strcasecmp(ent->d_name + len - 4, ".ch8") == 0) {
+            paths[count] = malloc(MAX_PATH);
+            if (paths[count] == 0x00) {
+                abort();
+            }
+            snprintf(paths[count++], MAX_PATH, "%s/%s", argv[1], ent->d_name);
+        }
+    }
+    closedir(d);
+    if (count == 0) {
+        printf("[Error] no .ch8 files in %s\n", argv[1]);
+        return -1;
+    }
+    qsort(paths, count, sizeof(char *), byName);
+
+    static struct Farm farm;
+    int result = farmInit(&farm, paths, count, instances, workers);
+    if (result == 0) {
+        result = serve(&farm, argv[4], seconds);
+        farmFree(&farm);
+    }
+    for (int i = 0; i < count; i++) {
+        free(paths[i]);
+    }
+    return result;
+}
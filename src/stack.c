@@ -4,26 +4,61 @@
 #include <stdio.h>
 
 bool isFull(struct Chip8 *chip8) {
-    return chip8->registers.SP == STACK_SIZE ? true : false;
+    return chip8->registers.SP >= STACK_SIZE ? true : false;
 }
 
 bool isEmpty(struct Chip8 *chip8) {
     return chip8->registers.SP == 0 ? true : false;
 }
 
+#ifdef CHIP8_CHECKED
+static void stackFault(struct Chip8 *chip8, const char *what) {
+    chip8->memory.violations++;
+    if (chip8->memory.violations <= CHECKED_REPORTS) {
+        // PC already points past the 2NNN or 00EE
+        unsigned short pc = chip8->registers.PC - 2;
+        printf("[checked] PC 0x%03X opcode 0x%04X: %s\n", pc, mergeBytes(&chip8->memory, pc), what);
+    }
+}
+#endif
+
+/*
+    SP counts the entries and slot SP & (STACK_SIZE - 1) holds the newest,
+    so the 16th call uses slot 0; a deeper call or an extra return wraps
+    around the stack instead of writing past it.
+*/
 void stackPush(struct Chip8 *chip8, unsigned short val) {
-    if (isFull(chip8)) {
-        printf("stack overflow!");
+#ifdef CHIP8_CHECKED
+    // only the 17th entry overflows, SP sits at 255 after a return with an empty stack
+    if (chip8->registers.SP == STACK_SIZE) {
+        stackFault(chip8, "stack overflow");
     }
+#endif
     chip8->registers.SP += 1;
-    chip8->stack.stack[chip8->registers.SP] = val;
+    chip8->stack.stack[chip8->registers.SP & (STACK_SIZE - 1)] = val;
+    if (chip8->registers.SP > chip8->stats.stack_high) {
+        chip8->stats.stack_high = chip8->registers.SP;
+    }
+#ifdef CHIP8_PROFILE
+    // val is the return address, the 2NNN that pushed it names the callee
+    if (chip8->profiler != 0x00) {
+        profEnter(chip8->profiler, mergeBytes(&chip8->memory, val - 2) & 0x0FFF, chip8->cycles);
+    }
+#endif
 }
 
 unsigned short stackPop(struct Chip8 *chip8) {
+#ifdef CHIP8_CHECKED
     if (isEmpty(chip8)) {
-		printf("stack is already empty!");
-	}
-    unsigned short result = chip8->stack.stack[chip8->registers.SP];
+        stackFault(chip8, "return with an empty stack");
+    }
+#endif
+    unsigned short result = chip8->stack.stack[chip8->registers.SP & (STACK_SIZE - 1)];
     chip8->registers.SP -= 1;
+#ifdef CHIP8_PROFILE
+    if (chip8->profiler != 0x00) {
+        profLeave(chip8->profiler, chip8->cycles);
+    }
+#endif
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "inc/state.h"
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static unsigned char *putLE(unsigned char *out, unsigned long long val, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out[i] = val >> (8 * i);
+    }
+    return out + bytes;
+}
+
+static unsigned long long getLE(const unsigned char **in, int bytes) {
+    unsigned long long val = 0;
+    for (int i = 0; i < bytes; i++) {
+        val |= (unsigned long long)(*in)[i] << (8 * i);
+    }
+    *in += bytes;
+    return val;
+}
+
+static unsigned char *putBytes(unsigned char *out, const void *data, size_t len) {
+    memcpy(out, data, len);
+    return out + len;
+}
+
+static void getBytes(const unsigned char **in, void *data, size_t len) {
+    memcpy(data, *in, len);
+    *in += len;
+}
+
+size_t stateSize(struct Chip8 *chip8) {
+    return STATE_SIZE(chip8->memory.size) + (chip8->mega != 0x00 ? MEGA_STATE_SIZE : 0);
+}
+
+/**
+ * @brief stateSave(chip8, buf) is used to serialize the whole machine into buf
+ * @param chip8 chip8's state
+ * @param buf at least stateSize(chip8) bytes
+ * @return number of bytes written, always stateSize(chip8)
+ */
+size_t stateSave(struct Chip8 *chip8, unsigned char *buf) {
+    unsigned char *out = buf;
+    out = putBytes(out, "C8ST", 4);
+    out = putLE(out, STATE_VERSION, 2);
+    out = putLE(out, chip8->profile, 1);
+    out = putLE(out, 0, 1);
+    out = putLE(out, chip8->memory.size, 4);
+    out = putLE(out, chip8->rom_hash, 8);
+    out = putBytes(out, chip8->memory.memory, chip8->memory.size);
+    for (int i = 0; i < STACK_SIZE; i++) {
+        out = putLE(out, chip8->stack.stack[i], 2);
+    }
+    out = putBytes(out, chip8->registers.V, DATA_REGISTERS);
+    out = putLE(out, chip8->registers.I, 4);
+    out = putLE(out, chip8->registers.delay_timer, 1);
+    out = putLE(out, chip8->registers.sound_timer, 1);
+    out = putLE(out, chip8->registers.PC, 2);
+    out = putLE(out, chip8->registers.SP, 1);
+    out = putBytes(out, chip8->registers.flags, DATA_REGISTERS);
+    for (int i = 0; i < TOTAL_KEYS; i++) {
+        out = putLE(out, chip8->keyboard.keyboard[i], 1);
+    }
+    out = putLE(out, chip8->keyboard.waiting, 1);
+    out = putLE(out, (unsigned char)chip8->keyboard.pressed, 1);
+    out = putLE(out, chip8->screen.hires, 1);
+    out = putLE(out, chip8->screen.planes, 1);
+    for (int plane = 0; plane < PLANES; plane++) {
+        for (int y = 0; y < HIRES_HEIGHT; y++) {
+            for (int i = 0; i < ROW_WORDS; i++) {
+                out = putLE(out, chip8->screen.rows[plane][y][i], 8);
+            }
+        }
+    }
+    out = putBytes(out, chip8->pattern, sizeof(chip8->pattern));
+    out = putLE(out, chip8->pitch, 1);
+    out = putLE(out, chip8->rng, 4);
+    out = putLE(out, chip8->cycles, 8);
+    out = putLE(out, chip8->frames, 8);
+    if (chip8->mega != 0x00) {
+        struct Mega *mega = chip8->mega;
+        out = putBytes(out, mega->pixels, sizeof(mega->pixels));
+        out = putBytes(out, mega->front, sizeof(mega->front));
+        for (int i = 0; i < MEGA_COLOURS; i++) {
+            out = putLE(out, mega->palette[i], 4);
+        }
+        out = putLE(out, mega->sprite_width, 1);
+        out = putLE(out, mega->sprite_height, 1);
+        out = putLE(out, mega->collision, 1);
+        out = putLE(out, mega->blend, 1);
+        out = putLE(out, mega->alpha, 1);
+        out = putLE(out, mega->enabled, 1);
+    }
+    return out - buf;
+}
+
+/**
+ * @brief stateLoad(chip8, buf, size) is used to restore a machine saved by stateSave(),
+ * the keyboard map is left untouched since it belongs to the front-end
+ * @param chip8 chip8's state
+ * @param buf serialized state
+ * @param size size of buf
+ * @return 0 on success, -1 if buf is not a state of this version
+ */
+int stateLoad(struct Chip8 *chip8, const unsigned char *buf, size_t size) {
+    const unsigned char *in = buf + 4;
+    if (size < 20 || memcmp(buf, "C8ST", 4) != 0 || getLE(&in, 2) != STATE_VERSION) {
+        return -1;
+    }
+    unsigned int profile = getLE(&in, 1);
+    in += 1;
+    unsigned int memory_size = getLE(&in, 4);
+    size_t expected = STATE_SIZE(memory_size) + (profile == PROFILE_MEGACHIP ? MEGA_STATE_SIZE : 0);
+    if (profile >= PROFILES || memory_size != profileMemory(profile) || size != expected) {
+        return -1;
+    }
+    chip8->rom_hash = getLE(&in, 8);
+    chSetProfile(chip8, profile);
+    getBytes(&in, chip8->memory.memory, memory_size);
+    // everything may have changed, forks must resync all of it
+    memset(chip8->memory.dirty, 0xFF, (memory_size / PAGE_SIZE + 31) / 32 * sizeof(unsigned int));
+    for (int i = 0; i < STACK_SIZE; i++) {
+        chip8->stack.stack[i] = getLE(&in, 2);
+    }
+    getBytes(&in, chip8->registers.V, DATA_REGISTERS);
+    chip8->registers.I = getLE(&in, 4);
+    chip8->registers.delay_timer = getLE(&in, 1);
+    chip8->registers.sound_timer = getLE(&in, 1);
+    chip8->registers.PC = getLE(&in, 2);
+    chip8->registers.SP = getLE(&in, 1);
+    getBytes(&in, chip8->registers.flags, DATA_REGISTERS);
+    for (int i = 0; i < TOTAL_KEYS; i++) {
+        chip8->keyboard.keyboard[i] = getLE(&in, 1) != 0;
+    }
+    chip8->keyboard.waiting = getLE(&in, 1) != 0;
+    chip8->keyboard.pressed = (signed char)getLE(&in, 1);
+    chip8->screen.hires = getLE(&in, 1) != 0;
+    chip8->screen.planes = getLE(&in, 1);
+    for (int plane = 0; plane < PLANES; plane++) {
+        for (int y = 0; y < HIRES_HEIGHT; y++) {
+            for (int i = 0; i < ROW_WORDS; i++) {
+                chip8->screen.rows[plane][y][i] = getLE(&in, 8);
+            }
+        }
+    }
+    getBytes(&in, chip8->pattern, sizeof(chip8->pattern));
+    chip8->pitch = getLE(&in, 1);
+    chip8->rng = getLE(&in, 4);
+    chip8->cycles = getLE(&in, 8);
+    chip8->frames = getLE(&in, 8);
+    if (chip8->mega != 0x00) {
+        struct Mega *mega = chip8->mega;
+        getBytes(&in, mega->pixels, sizeof(mega->pixels));
+        getBytes(&in, mega->front, sizeof(mega->front));
+        for (int i = 0; i < MEGA_COLOURS; i++) {
+            mega->palette[i] = getLE(&in, 4);
+        }
+        mega->sprite_width = getLE(&in, 1);
+        mega->sprite_height = getLE(&in, 1);
+        mega->collision = getLE(&in, 1);
+        mega->blend = getLE(&in, 1);
+        mega->alpha = getLE(&in, 1);
+        mega->enabled = getLE(&in, 1) != 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief stateWrite(chip8, path) is used to save the machine to a file
+ * @param chip8 chip8's state
+ * @param path file to create or overwrite
+ * @return 0 on success, -1 on I/O errors
+ */
+int stateWrite(struct Chip8 *chip8, const char *path) {
+    unsigned char *buf = malloc(stateSize(chip8));
+    FILE *ptr;
+    size_t size = stateSave(chip8, buf);
+    if ((ptr = fopen(path, "wb")) == 0x00) {
+        printf("Error creating save state %s\n", path);
+        free(buf);
+        return -1;
+    }
+    size_t written = fwrite(buf, 1, size, ptr);
+    free(buf);
+    if (fclose(ptr) != 0 || written != size) {
+        printf("Error writing save state %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief stateRead(chip8, path) is used to restore the machine from a file,
+ * the file is mapped rather than read so a load is a single copy
+ * @param chip8 chip8's state, untouched on failure
+ * @param path file written by stateWrite()
+ * @return 0 on success, -1 if the file is missing or not a valid state
+ */
+int stateRead(struct Chip8 *chip8, const char *path) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1 || fstat(fd, &st) == -1 || st.st_size < 20) {
+        printf("Error opening save state %s\n", path);
+        if (fd != -1) {
+            close(fd);
+        }
+        return -1;
+    }
+    void *map = mmap(0x00, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Error mapping save state %s\n", path);
+        return -1;
+    }
+    int result = stateLoad(chip8, map, st.st_size);
+    munmap(map, st.st_size);
+    if (result == -1) {
+        printf("Error: %s is not a compatible save state\n", path);
+    }
+    return result;
+}
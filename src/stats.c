@@ -0,0 +1,88 @@
+#include "inc/stats.h"
+#include "inc/chip8.h"
+#include <string.h>
+#include <time.h>
+
+/**
+ * @brief statsRead(chip8, stats) is used to take a snapshot of the counters,
+ * it can be called at any point between two instructions
+ * @param chip8 chip8's state
+ * @param stats filled with the counters and the instruction and frame counts
+ * @return void
+ */
+void statsRead(struct Chip8 *chip8, struct Stats *stats) {
+    *stats = chip8->stats;
+    stats->instructions = chip8->cycles;
+    stats->frames = chip8->frames;
+}
+
+/**
+ * @brief statsWrite(chip8, out) is used to write a snapshot as one line of JSON,
+ * with the wall-clock time, the ROM hash and the profile so lines from several
+ * instances can be told apart
+ * @param chip8 chip8's state
+ * @param out where to write
+ * @return 0, -1 if the line could not be written
+ */
+int statsWrite(struct Chip8 *chip8, FILE *out) {
+    struct Stats s;
+    statsRead(chip8, &s);
+    int n = fprintf(out,
+                    "{\"time\": %lld, \"rom\": \"%016llx\", \"profile\": \"%s\", \"instructions\": %llu, "
+                    "\"frames\": %llu, \"draws\": %llu, \"collisions\": %llu, \"clears\": %llu, "
+                    "\"timer_ticks\": %llu, \"key_waits\": %llu, \"unknown_opcodes\": %llu, \"stack_high\": %u}\n",
+                    (long long)time(0x00), chip8->rom_hash, profileName(chip8->profile), s.instructions, s.frames,
+                    s.draws, s.collisions, s.clears, s.timer_ticks, s.key_waits, s.unknown, s.stack_high);
+    return n < 0 || fflush(out) != 0 ? -1 : 0;
+}
+
+/**
+ * @brief statsOpen(dump, path, every) is used to start periodic snapshots
+ * @param dump the dump to set up
+ * @param path file to append to, "-" for stderr
+ * @param every frames between two snapshots, STATS_INTERVAL is 10 seconds
+ * @return 0, -1 if the file could not be opened
+ */
+int statsOpen(struct StatsDump *dump, const char *path, unsigned long every) {
+    memset(dump, 0, sizeof(struct StatsDump));
+    dump->out = strcmp(path, "-") == 0 ? stderr : fopen(path, "a");
+    if (dump->out == 0x00) {
+        printf("[Error] could not open %s\n", path);
+        return -1;
+    }
+    dump->every = every > 0 ? every : 1;
+    return 0;
+}
+
+/**
+ * @brief statsPoll(dump, chip8) is used once per frame, it writes a snapshot
+ * when the machine has run another dump->every frames
+ * @param dump an open dump
+ * @param chip8 chip8's state
+ * @return void
+ */
+void statsPoll(struct StatsDump *dump, struct Chip8 *chip8) {
+    // the first poll starts the count, the machine may have run before the dump was opened
+    if (dump->next == 0) {
+        dump->next = chip8->frames + dump->every;
+    }
+    if (chip8->frames < dump->next) {
+        return;
+    }
+    statsWrite(chip8, dump->out);
+    dump->next = chip8->frames + dump->every;
+}
+
+/**
+ * @brief statsClose(dump, chip8) is used to write the final snapshot and close the file
+ * @param dump an open dump
+ * @param chip8 chip8's state
+ * @return void
+ */
+void statsClose(struct StatsDump *dump, struct Chip8 *chip8) {
+    statsWrite(chip8, dump->out);
+    if (dump->out != stderr) {
+        fclose(dump->out);
+    }
+    dump->out = 0x00;
+}
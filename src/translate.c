@@ -0,0 +1,575 @@
+#include "inc/cfg.h"
+#include "inc/decode.h"
+#include "inc/hash.h"
+#include "inc/platform.h"
+#include "inc/quirks.h"
+#include "inc/rom.h"
+#include <ctype.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+struct Quirks {
+    bool shift_vy; // 8XY6/8XYE shift VY into VX
+    bool inc_i;    // FX55/FX65 leave I past the last register
+    bool jump_vx;  // BXNN jumps to XNN + VX
+    bool clip;     // sprites are clipped at the screen edges
+};
+
+// indexed by enum Profile, the quirks chip8.c builds each interpreter with
+static const struct Quirks quirks[PROFILES] = {
+    QUIRKS(PROFILE_CHIP8), QUIRKS(PROFILE_VIP), QUIRKS(PROFILE_SCHIP), QUIRKS(PROFILE_XOCHIP), QUIRKS(PROFILE_MEGACHIP),
+};
+
+static const char *profile_enums[PROFILES] = {"PROFILE_CHIP8", "PROFILE_VIP", "PROFILE_SCHIP", "PROFILE_XOCHIP",
+                                              "PROFILE_MEGACHIP"};
+
+struct Translator {
+    struct Cfg cfg;
+    enum Profile profile;
+    char name[64];             // C name of the struct AotRom
+    unsigned char *translated; // per byte of the image, it belongs to a translated block
+    unsigned char *target;     // per byte, a translated block starts there and another one goes to it
+    int blocks;                // translated blocks
+    int inline_ops;            // instructions written as C
+    int fallback_ops;          // instructions left to execOpcode()
+    struct CfgBlock *block;    // the block being written
+    FILE *out;
+};
+
+static unsigned short wordAt(struct Cfg *cfg, unsigned int addr) {
+    unsigned int hi = addr < cfg->end ? cfg->data[addr - cfg->start] : 0;
+    unsigned int lo = addr + 1 < cfg->end ? cfg->data[addr + 1 - cfg->start] : 0;
+    return hi << 8 | lo;
+}
+
+static bool isTranslated(struct Translator *t, unsigned int addr) {
+    return addr >= t->cfg.start && addr < t->cfg.end && t->translated[addr - t->cfg.start];
+}
+
+// blocks holding a byte some store is known to write are left to the interpreter
+static bool canTranslate(struct Cfg *cfg, struct CfgBlock *block) {
+    for (unsigned int addr = block->start; addr < block->end; addr++) {
+        if (cfg->flags[addr - cfg->start] & CFG_WRITTEN) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// a translated block starts at addr, so a known branch there can be a goto
+static bool isBlock(struct Translator *t, unsigned int addr) {
+    return isTranslated(t, addr) && (t->cfg.flags[addr - t->cfg.start] & CFG_LEADER);
+}
+
+// an instruction the translation runs through execOpcode(), the ones that
+// depend on MegaChip mode or have no reason to be inlined
+static bool isFallback(struct Translator *t, enum Op op) {
+    bool mega = t->profile == PROFILE_MEGACHIP;
+    switch (op) {
+    case OP_CLS:
+    case OP_SCD:
+    case OP_SCR:
+    case OP_SCL:
+        return mega;
+    case OP_DRW:
+        return mega || t->profile == PROFILE_XOCHIP;
+    case OP_MEGAOFF:
+    case OP_MEGAON:
+    case OP_SCRU:
+    case OP_LDHI:
+    case OP_LDPAL:
+    case OP_SPRW:
+    case OP_SPRH:
+    case OP_ALPHA:
+    case OP_DIGISND:
+    case OP_STOPSND:
+    case OP_BMODE:
+    case OP_CCOL:
+    case OP_SAVE:
+    case OP_LOAD:
+    case OP_AUDIO:
+    case OP_LD_VX_K:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// a block whose last instruction jumps back to its start
+static bool isLoop(struct Translator *t, struct CfgBlock *block) {
+    unsigned short opcode = wordAt(&t->cfg, block->last);
+    return decodeOp(t->cfg.isa, opcode) == OP_JP && (opcode & 0x0FFF) == block->start && isBlock(t, block->start);
+}
+
+// goes on to addr from the instruction before next, counting it as a jump unless addr is next
+static void emitGoto(struct Translator *t, unsigned int next, unsigned int addr) {
+    if (addr != next && addr == t->block->start && isLoop(t, t->block)) {
+        fprintf(t->out, "        AOT_TURN(0x%03X);\n", addr);
+    } else if (addr != next) {
+        fprintf(t->out, "        AOT_JUMP(0x%03X, 0x%03X);\n", next, addr);
+    }
+    if (isBlock(t, addr)) {
+        fprintf(t->out, "        goto block_0x%03X;\n", addr);
+    } else {
+        fprintf(t->out, "        r->PC = 0x%03X;\n        continue;\n", addr);
+    }
+}
+
+// where a skip at pc lands when it skips, an expression if the next instruction may change
+static void skipTarget(struct Translator *t, unsigned int next, char *buf, size_t len) {
+    if (t->profile != PROFILE_XOCHIP) {
+        snprintf(buf, len, "0x%03X", next + 2);
+    } else if (isTranslated(t, next) && isTranslated(t, next + 1)) {
+        snprintf(buf, len, "0x%03X", next + (wordAt(&t->cfg, next) == 0xF000 ? 4 : 2));
+    } else {
+        snprintf(buf, len, "0x%03X + (mergeBytes(&chip8->memory, 0x%03X) == 0xF000 ? 4 : 2)", next, next);
+    }
+}
+
+// leaves for the interpreter after a store of len bytes at addr reached translated code,
+// unless the analysis knows the site only stores outside of it
+static void emitStoreCheck(struct Translator *t, unsigned int pc, unsigned int next, const char *addr,
+                           const char *len) {
+    for (int i = 0; i < t->cfg.write_count; i++) {
+        struct CfgWrite *write = &t->cfg.writes[i];
+        if (write->site != pc || write->len == 0) {
+            continue;
+        }
+        for (unsigned int a = write->start; a < write->start + write->len; a++) {
+            if (isTranslated(t, a)) {
+                break;
+            }
+            if (a + 1 == write->start + write->len) {
+                return;
+            }
+        }
+    }
+    fprintf(t->out, "        if (aotTouches(&%s, &chip8->memory, %s, %s)) {\n", t->name, addr, len);
+    fprintf(t->out, "            *stale = true;\n            r->PC = 0x%03X;\n            goto out;\n        }\n", next);
+}
+
+static void emitFallback(struct Translator *t, unsigned int pc, unsigned short opcode, enum Op op) {
+    FILE *out = t->out;
+    fprintf(out, "        r->PC = 0x%03X;\n        execOpcode(chip8, 0x%04X);\n", pc + 2, opcode);
+    if (op == OP_LD_VX_K) {
+        // waits by running again until a key is pressed
+        fprintf(out, "        if (r->PC != 0x%03X) {\n            goto out;\n        }\n", pc + 2);
+    }
+    if (op == OP_SAVE) {
+        unsigned int x = opcode >> 8 & 0xF, y = opcode >> 4 & 0xF;
+        char len[8];
+        snprintf(len, sizeof(len), "%u", (x > y ? x - y : y - x) + 1);
+        emitStoreCheck(t, pc, pc + 2, "r->I", len);
+    }
+    t->fallback_ops++;
+}
+
+// the C for one instruction, everything but the last instruction of a block falls through
+static void emitOp(struct Translator *t, unsigned int pc, unsigned short opcode, enum Op op) {
+    FILE *out = t->out;
+    const struct Quirks *q = &quirks[t->profile];
+    unsigned int X = opcode >> 8 & 0xF, Y = opcode >> 4 & 0xF, N = opcode & 0xF, NN = opcode & 0xFF;
+    unsigned int NNN = opcode & 0xFFF;
+    unsigned int next = pc + opTable[op].size;
+    char skip[96];
+    if (isFallback(t, op)) {
+        emitFallback(t, pc, opcode, op);
+        return;
+    }
+    t->inline_ops++;
+    switch (op) {
+    case OP_CLS:
+        fprintf(out, "        chip8->stats.clears++;\n        clearScreen(&chip8->screen);\n");
+        break;
+    case OP_RET:
+        fprintf(out, "        r->PC = stackPop(chip8);\n        AOT_JUMP(0x%03X, r->PC);\n        continue;\n", pc + 2);
+        break;
+    case OP_SCD:
+        fprintf(out, "        scrollDown(&chip8->screen, %u);\n", N);
+        break;
+    case OP_SCU:
+        fprintf(out, "        scrollUp(&chip8->screen, %u);\n", N);
+        break;
+    case OP_SCR:
+        fprintf(out, "        scrollRight(&chip8->screen);\n");
+        break;
+    case OP_SCL:
+        fprintf(out, "        scrollLeft(&chip8->screen);\n");
+        break;
+    case OP_EXIT:
+        // stays on the instruction until the frame runs out of cycles
+        fprintf(out, "        AOT_JUMP(0x%03X, 0x%03X);\n        r->PC = 0x%03X;\n        continue;\n", pc + 2, pc, pc);
+        break;
+    case OP_LOW:
+    case OP_HIGH:
+        fprintf(out, "        setHires(&chip8->screen, %s);\n", op == OP_HIGH ? "true" : "false");
+        break;
+    case OP_JP:
+        emitGoto(t, pc + 2, NNN);
+        break;
+    case OP_CALL:
+        fprintf(out, "        stackPush(chip8, 0x%03X);\n", next);
+        emitGoto(t, pc + 2, NNN);
+        break;
+    case OP_SE_BYTE:
+    case OP_SNE_BYTE:
+    case OP_SE_REG:
+    case OP_SNE_REG:
+    case OP_SKP:
+    case OP_SKNP:
+        if (op == OP_SE_BYTE || op == OP_SNE_BYTE) {
+            fprintf(out, "        if (V[0x%X] %s 0x%02X) {\n", X, op == OP_SE_BYTE ? "==" : "!=", NN);
+        } else if (op == OP_SE_REG || op == OP_SNE_REG) {
+            fprintf(out, "        if (V[0x%X] %s V[0x%X]) {\n", X, op == OP_SE_REG ? "==" : "!=", Y);
+        } else {
+            fprintf(out, "        if (%skeyIsDown(&chip8->keyboard, V[0x%X])) {\n", op == OP_SKP ? "" : "!", X);
+        }
+        skipTarget(t, next, skip, sizeof(skip));
+        fprintf(out, "            AOT_JUMP(0x%03X, %s);\n", next, skip);
+        if (strchr(skip, '+') == 0x00 && isBlock(t, strtoul(skip, 0x00, 16))) {
+            fprintf(out, "            goto block_%s;\n        }\n", skip);
+        } else {
+            fprintf(out, "            r->PC = %s;\n            continue;\n        }\n", skip);
+        }
+        emitGoto(t, next, next);
+        break;
+    case OP_LD_BYTE:
+        fprintf(out, "        V[0x%X] = 0x%02X;\n", X, NN);
+        break;
+    case OP_ADD_BYTE:
+        fprintf(out, "        V[0x%X] += 0x%02X;\n", X, NN);
+        break;
+    case OP_LD_REG:
+        fprintf(out, "        V[0x%X] = V[0x%X];\n", X, Y);
+        break;
+    case OP_OR:
+    case OP_AND:
+    case OP_XOR:
+        fprintf(out, "        V[0x%X] %c= V[0x%X];\n", X, op == OP_OR ? '|' : op == OP_AND ? '&' : '^', Y);
+        break;
+    case OP_ADD_REG:
+        fprintf(out, "        {\n            unsigned int sum = V[0x%X] + V[0x%X];\n", X, Y);
+        fprintf(out, "            V[0xF] = sum > 0xFF;\n            V[0x%X] = sum;\n        }\n", X);
+        break;
+    case OP_SUB:
+        // the interpreter clears VF before comparing, which matters when VF is an operand
+        if (X == 0xF || Y == 0xF) {
+            fprintf(out, "        V[0xF] = 0;\n");
+        }
+        fprintf(out, "        V[0xF] = V[0x%X] > V[0x%X];\n", X, Y);
+        fprintf(out, "        V[0x%X] = V[0x%X] - V[0x%X];\n", X, X, Y);
+        break;
+    case OP_SUBN:
+        fprintf(out, "        V[0xF] = V[0x%X] > V[0x%X];\n", Y, X);
+        fprintf(out, "        V[0x%X] = V[0x%X] - V[0x%X];\n", X, Y, X);
+        break;
+    case OP_SHR:
+    case OP_SHL:
+        fprintf(out, "        {\n            unsigned char value = V[0x%X];\n", q->shift_vy ? Y : X);
+        if (op == OP_SHR) {
+            fprintf(out, "            V[0xF] = value & 0x01;\n            V[0x%X] = value >> 1;\n        }\n", X);
+        } else {
+            fprintf(out, "            V[0xF] = value >> 7;\n            V[0x%X] = value << 1;\n        }\n", X);
+        }
+        break;
+    case OP_LD_I:
+        fprintf(out, "        r->I = 0x%03X;\n", NNN);
+        break;
+    case OP_JP_V0:
+        // the target is only known at run time, continue finds its case or hands it to the interpreter
+        if (q->jump_vx) {
+            fprintf(out, "        r->PC = 0x%03X + V[0x%X];\n", NNN, X);
+        } else {
+            fprintf(out, "        r->PC = 0x%03X + V[0x0];\n", NNN);
+        }
+        fprintf(out, "        AOT_JUMP(0x%03X, r->PC);\n        continue;\n", pc + 2);
+        break;
+    case OP_RND:
+        fprintf(out, "        V[0x%X] = chRandom(chip8) & 0x%02X;\n", X, NN);
+        break;
+    case OP_DRW:
+        if (N == 0 && t->profile == PROFILE_SCHIP) {
+            fprintf(out, "        {\n            unsigned char sprite[32];\n");
+            fprintf(out, "            memRead(&chip8->memory, r->I, sprite, 32);\n");
+            fprintf(out,
+                    "            V[0xF] = statsDraw(&chip8->stats, %s(&chip8->screen, V[0x%X], V[0x%X], "
+                    "(const char *)sprite));\n        }\n",
+                    q->clip ? "drawLargeSpriteClipped" : "drawLargeSprite", X, Y);
+        } else {
+            fprintf(out, "        {\n            unsigned char sprite[16];\n");
+            fprintf(out, "            memRead(&chip8->memory, r->I, sprite, %u);\n", N);
+            fprintf(out,
+                    "            V[0xF] = statsDraw(&chip8->stats, %s(&chip8->screen, V[0x%X], V[0x%X], "
+                    "(const char *)sprite, %u));\n        }\n",
+                    q->clip ? "drawSpriteClipped" : "drawSprite", X, Y, N);
+        }
+        break;
+    case OP_LD_LONG:
+        fprintf(out, "        r->I = 0x%04X;\n", wordAt(&t->cfg, pc + 2));
+        break;
+    case OP_PLANE:
+        fprintf(out, "        chip8->screen.planes = %u;\n", X & 0x03);
+        break;
+    case OP_PITCH:
+        fprintf(out, "        chip8->pitch = V[0x%X];\n", X);
+        break;
+    case OP_LD_VX_DT:
+        fprintf(out, "        V[0x%X] = r->delay_timer;\n", X);
+        break;
+    case OP_LD_DT:
+        fprintf(out, "        r->delay_timer = V[0x%X];\n", X);
+        break;
+    case OP_LD_ST:
+        fprintf(out, "        r->sound_timer = V[0x%X];\n", X);
+        break;
+    case OP_ADD_I:
+        fprintf(out, "        r->I += V[0x%X];\n", X);
+        break;
+    case OP_LD_F:
+        fprintf(out, "        r->I = V[0x%X] * 5;\n", X);
+        break;
+    case OP_LD_HF:
+        fprintf(out, "        r->I = BIG_FONT_START + (V[0x%X] & 0x0F) * 10;\n", X);
+        break;
+    case OP_LD_R:
+        fprintf(out, "        memcpy(r->flags, V, %u);\n", X + 1);
+        break;
+    case OP_LD_VX_R:
+        fprintf(out, "        memcpy(V, r->flags, %u);\n", X + 1);
+        break;
+    case OP_LD_BCD:
+        fprintf(out, "        setMemory(&chip8->memory, r->I, V[0x%X] / 100);\n", X);
+        fprintf(out, "        setMemory(&chip8->memory, r->I + 1, V[0x%X] / 10 %% 10);\n", X);
+        fprintf(out, "        setMemory(&chip8->memory, r->I + 2, V[0x%X] %% 10);\n", X);
+        emitStoreCheck(t, pc, next, "r->I", "3");
+        break;
+    case OP_LD_MEM:
+    case OP_LD_VX_MEM:
+        if (op == OP_LD_MEM) {
+            fprintf(out, "        for (int i = 0; i <= 0x%X; i++) {\n", X);
+            fprintf(out, "            setMemory(&chip8->memory, r->I + i, V[i]);\n        }\n");
+        } else {
+            fprintf(out, "        for (int i = 0; i <= 0x%X; i++) {\n", X);
+            fprintf(out, "            V[i] = getMemory(&chip8->memory, r->I + i);\n        }\n");
+        }
+        if (q->inc_i) {
+            fprintf(out, "        r->I += %u;\n", X + 1);
+        }
+        if (op == OP_LD_MEM) {
+            // I has already moved past the registers on profiles that increment it
+            char addr[16] = "r->I", len[8];
+            if (q->inc_i) {
+                snprintf(addr, sizeof(addr), "r->I - %u", X + 1);
+            }
+            snprintf(len, sizeof(len), "%u", X + 1);
+            emitStoreCheck(t, pc, next, addr, len);
+        }
+        break;
+    default:
+        // 0NNN and opcodes the profile lacks run as no-ops
+        fprintf(out, "        chip8->stats.unknown++;\n");
+        break;
+    }
+}
+
+static void emitBlock(struct Translator *t, struct CfgBlock *block) {
+    FILE *out = t->out;
+    unsigned int pc = block->start;
+    t->block = block;
+    fprintf(out, "\n");
+    while (pc < block->end) {
+        unsigned short opcode = wordAt(&t->cfg, pc);
+        enum Op op = decodeOp(t->cfg.isa, opcode);
+        char text[64];
+        formatOp(text, sizeof(text), opcode, op, wordAt(&t->cfg, pc + 2), 0x00);
+        const char *macro = pc != block->start ? "AOT_OP" : t->target[pc - t->cfg.start] ? "AOT_TARGET" : "AOT_BLOCK";
+        fprintf(out, "    %s(0x%03X) // %s\n", macro, pc, text);
+        emitOp(t, pc, opcode, op);
+        if (opTable[op].size == 4 && !isFallback(t, op)) {
+            // the second word never runs, which the hotspots see as a jump over it, execOpcode() counts its own
+            fprintf(out, "        AOT_JUMP(0x%03X, 0x%03X);\n", pc + 2, pc + 4);
+        }
+        pc += opTable[op].size;
+    }
+    // a block cut before a branch target runs on into it
+    if (opTable[decodeOp(t->cfg.isa, wordAt(&t->cfg, block->last))].flow == FLOW_NEXT) {
+        emitGoto(t, block->end, block->end);
+    }
+}
+
+// marks the blocks a translated one goes to with a goto, the others only get a case
+static void findTargets(struct Translator *t) {
+    struct Cfg *cfg = &t->cfg;
+    for (int i = 0; i < cfg->block_count; i++) {
+        struct CfgBlock *block = &cfg->blocks[i];
+        if (!isTranslated(t, block->start)) {
+            continue;
+        }
+        unsigned short opcode = wordAt(cfg, block->last);
+        enum Op op = decodeOp(cfg->isa, opcode);
+        unsigned int next = block->last + opTable[op].size;
+        unsigned int targets[2] = {next, next};
+        char skip[96];
+        switch (opTable[op].flow) {
+        case FLOW_JUMP:
+        case FLOW_CALL:
+            targets[0] = targets[1] = opcode & 0x0FFF;
+            break;
+        case FLOW_SKIP:
+            skipTarget(t, next, skip, sizeof(skip));
+            if (strchr(skip, '+') == 0x00) {
+                targets[1] = strtoul(skip, 0x00, 16);
+            }
+            break;
+        case FLOW_NEXT:
+            break;
+        default:
+            continue;
+        }
+        for (int j = 0; j < 2; j++) {
+            if (isBlock(t, targets[j])) {
+                t->target[targets[j] - cfg->start] = 1;
+            }
+        }
+    }
+}
+
+static void emitData(struct Translator *t, const unsigned char *rom, size_t size) {
+    FILE *out = t->out;
+    fprintf(out, "static const unsigned char image[%zu] = {", size);
+    for (size_t i = 0; i < size; i++) {
+        fprintf(out, "%s0x%02X,", i % 16 == 0 ? "\n    " : " ", rom[i]);
+    }
+    fprintf(out, "\n};\n\nstatic const unsigned char code[%zu] = {", (size + 7) / 8);
+    for (size_t i = 0; i < (size + 7) / 8; i++) {
+        unsigned int bits = 0;
+        for (size_t j = 0; j < 8 && i * 8 + j < size; j++) {
+            bits |= (unsigned int)(t->translated[i * 8 + j] != 0) << j;
+        }
+        fprintf(out, "%s0x%02X,", i % 16 == 0 ? "\n    " : " ", bits);
+    }
+    fprintf(out, "\n};\n\nstatic const struct AotRun runs[] = {\n");
+    int count = 0;
+    for (size_t i = 0; i < size; i++) {
+        if (t->translated[i] && (i == 0 || !t->translated[i - 1])) {
+            size_t len = 1;
+            while (i + len < size && t->translated[i + len]) {
+                len++;
+            }
+            fprintf(out, "    {0x%03zX, %zu},\n", ROM_START + i, len);
+            count++;
+        }
+    }
+    if (count == 0) {
+        fprintf(out, "    {ROM_START, 0},\n");
+    }
+    fprintf(out, "};\n");
+}
+
+static void translate(struct Translator *t, const char *path, const unsigned char *rom, size_t size,
+                      unsigned long long hash) {
+    struct Cfg *cfg = &t->cfg;
+    FILE *out = t->out;
+    for (int i = 0; i < cfg->block_count; i++) {
+        struct CfgBlock *block = &cfg->blocks[i];
+        if (canTranslate(cfg, block)) {
+            memset(&t->translated[block->start - cfg->start], 1, block->end - block->start);
+            t->blocks++;
+        }
+    }
+    findTargets(t);
+
+    const char *file = strrchr(path, '/') != 0x00 ? strrchr(path, '/') + 1 : path;
+    fprintf(out, "// %s translated for the %s profile by chip8-aot, do not edit\n", file, profileName(t->profile));
+    fprintf(out, "#include \"../inc/aot.h\"\n#include <string.h>\n\n");
+    emitData(t, rom, size);
+    fprintf(out, "\nextern const struct AotRom %s;\n\n", t->name);
+    fprintf(out, "static int run(struct Chip8 *chip8, int left, bool *stale) {\n");
+    fprintf(out, "    struct Registers *r = &chip8->registers;\n    unsigned char *V = r->V;\n");
+    fprintf(out, "    int given = left;\n    (void)stale;\n");
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (isTranslated(t, cfg->blocks[i].start) && isLoop(t, &cfg->blocks[i])) {
+            fprintf(out, "    AOT_LOOP(0x%03X);\n", cfg->blocks[i].start);
+        }
+    }
+    fprintf(out, "    for (;;) {\n        switch (r->PC) {\n");
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (isTranslated(t, cfg->blocks[i].start)) {
+            emitBlock(t, &cfg->blocks[i]);
+        }
+    }
+    fprintf(out, "\n    default:\n        goto out;\n        }\n    }\nout:\n");
+    for (int i = 0; i < cfg->block_count; i++) {
+        if (isTranslated(t, cfg->blocks[i].start) && isLoop(t, &cfg->blocks[i])) {
+            fprintf(out, "    AOT_LOOP_END(0x%03X, 0x%03X);\n", cfg->blocks[i].start, cfg->blocks[i].last + 2);
+        }
+    }
+    fprintf(out, "    chip8->cycles += given - left;\n    return left;\n}\n\n");
+    fprintf(out, "const struct AotRom %s = {\n", t->name);
+    fprintf(out, "    .hash = 0x%016llXULL,\n    .profile = %s,\n    .isa = 0x%X,\n", hash,
+            profile_enums[t->profile], cfg->isa);
+    fprintf(out, "    .image = image,\n    .size = sizeof(image),\n    .code = code,\n    .runs = runs,\n");
+    fprintf(out, "    .run_count = %s,\n    .run = run,\n};\n",
+            t->blocks > 0 ? "sizeof(runs) / sizeof(runs[0])" : "0");
+}
+
+// translates a ROM into C for src/aot/, named after the output file
+int main(int argc, char **argv) {
+    if (argc != 3 && argc != 4) {
+        printf("[Error] usage: ./chip8-aot <rom file> <c file> [profile]\n");
+        return -1;
+    }
+    struct Rom rom;
+    enum RomError error = romOpen(&rom, argv[1]);
+    if (error != ROM_OK) {
+        printf("[Error] %s: %s\n", argv[1], romError(error));
+        return -1;
+    }
+    int profile = defaultProfile(detectPlatform(rom.data, rom.size));
+    if (argc == 4 && (profile = profileFromName(argv[3])) == -1) {
+        printf("[Error] unknown profile %s\n", argv[3]);
+        romClose(&rom);
+        return -1;
+    }
+    struct Translator t = {.profile = profile};
+    // aot_ and the file name up to the extension, as the Makefile registers it
+    const char *stem = strrchr(argv[2], '/') != 0x00 ? strrchr(argv[2], '/') + 1 : argv[2];
+    size_t n = snprintf(t.name, sizeof(t.name), "aot_");
+    for (; *stem != '\0' && *stem != '.' && n + 1 < sizeof(t.name); stem++) {
+        t.name[n++] = isalnum((unsigned char)*stem) ? *stem : '_';
+    }
+    t.name[n] = '\0';
+    t.out = fopen(argv[2], "w");
+    if (t.out == 0x00) {
+        printf("[Error] could not write %s\n", argv[2]);
+        romClose(&rom);
+        return -1;
+    }
+    decodeInit();
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    cfgBuild(&t.cfg, rom.data, rom.size, profileIsa(profile));
+    t.translated = calloc(rom.size + 1, 1);
+    t.target = calloc(rom.size + 1, 1);
+    if (t.translated == 0x00 || t.target == 0x00) {
+        abort();
+    }
+    translate(&t, argv[1], rom.data, rom.size, hashBytes(rom.data, rom.size));
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    int result = fclose(t.out);
+    double ms = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    fprintf(stderr, "%s: %s profile, %d of %d blocks, %d instructions inline, %d through execOpcode(), %.2f ms\n",
+            argv[1], profileName(profile), t.blocks, t.cfg.block_count, t.inline_ops, t.fallback_ops, ms);
+    free(t.translated);
+    free(t.target);
+    cfgFree(&t.cfg);
+    romClose(&rom);
+    if (result != 0) {
+        printf("[Error] could not write %s\n", argv[2]);
+        return -1;
+    }
+    return 0;
+}